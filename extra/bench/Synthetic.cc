@@ -0,0 +1,181 @@
+/** @file "Synthetic.cc"
+ *  @brief synthetic plug-in implementation
+ *
+ *  @ingroup bench
+ */
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ * 
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ * 
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ * 
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ * 
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <trex/utils/Plugin.hh>
+#include <trex/utils/LogManager.hh>
+#include <trex/domain/IntegerDomain.hh>
+
+#include <boost/tokenizer.hpp>
+
+#include "Synthetic.hh"
+
+using namespace TREX::utils;
+using namespace TREX::transaction;
+using namespace TREX::bench;
+
+namespace {
+
+  /** @brief TREX log entry point */
+  SingletonUse<LogManager> s_log;
+
+  /** @brief Synthetic reactor declaration */
+  TeleoReactor::xml_factory::declare<Synthetic> decl("Synthetic");
+  
+}
+
+namespace TREX {
+  
+  /** @brief Plug-in initialisation
+   *
+   * This function is called by TREX after loading the synthetic plug-in.
+   *
+   * @ingroup bench
+   */
+  void initPlugin() {
+    ::s_log->syslog("plugin.synthetic", info)<<"Synthetic loaded."<<std::endl;
+  }
+
+} // TREX
+
+Symbol const Synthetic::busyPred("Busy");
+Symbol const Synthetic::valueAttr("value");
+
+// structors :
+
+Synthetic::Synthetic(TeleoReactor::xml_arg_type arg)
+  :TeleoReactor(arg, false),
+   m_obs(parse_attr<size_t>(1, TeleoReactor::xml_factory::node(arg),
+                            "observations")),
+   m_goals(parse_attr<size_t>(0, TeleoReactor::xml_factory::node(arg),
+                              "goals")),
+   m_steps(parse_attr<size_t>(0, TeleoReactor::xml_factory::node(arg),
+                              "steps")),
+   m_cost(parse_attr<long>(0, TeleoReactor::xml_factory::node(arg), "cost")),
+   m_next_provided(0), m_next_used(0), m_left(0),
+   m_n_obs(0), m_n_notified(0), m_n_requests(0), m_n_recalls(0) {
+  size_t n_tl = parse_attr<size_t>(1, TeleoReactor::xml_factory::node(arg),
+                                   "timelines");
+  std::string uses = parse_attr<std::string>("", TeleoReactor::xml_factory::node(arg),
+                                             "uses");
+  for(size_t i=0; i<n_tl; ++i) {
+    std::ostringstream oss;
+    oss<<getName()<<'_'<<i;
+    m_provided.push_back(Symbol(oss.str()));
+    provide(m_provided.back());
+  }
+  
+  boost::char_separator<char> sep(", ");
+  boost::tokenizer< boost::char_separator<char> > tok(uses, sep);
+  for(boost::tokenizer< boost::char_separator<char> >::iterator i=tok.begin();
+      tok.end()!=i; ++i) {
+    m_used.push_back(Symbol(*i));
+    use(m_used.back(), m_goals>0);
+  }
+}
+
+Synthetic::~Synthetic() {
+  syslog(null, info)<<m_n_obs<<" observations posted, "<<m_n_notified
+    <<" received, "<<m_n_requests<<" requests and "<<m_n_recalls
+    <<" recalls received";
+}
+
+// callbacks :
+
+void Synthetic::handleInit() {
+  // Give an initial state to all the internal timelines
+  for(std::vector<Symbol>::const_iterator i=m_provided.begin();
+      m_provided.end()!=i; ++i)
+    postObservation(Observation(*i, busyPred));
+}
+
+void Synthetic::handleTickStart() {
+  TICK const now = getCurrentTick();
+  
+  // Recall the goals sent last tick before sending new ones
+  for( ; !m_sent.empty(); m_sent.pop_front())
+    postRecall(m_sent.front());
+  if( !m_used.empty() ) {
+    for(size_t i=0; i<m_goals; ++i) {
+      Goal g(m_used[m_next_used], busyPred);
+      g.restrictAttribute(Variable(valueAttr, IntegerDomain(now)));
+      m_sent.push_back(postGoal(g));
+      m_next_used = (m_next_used+1)%m_used.size();
+    }
+  }
+  m_left = m_steps;
+}
+
+bool Synthetic::synchronize() {
+  TICK const now = getCurrentTick();
+  
+  if( !m_provided.empty() ) {
+    for(size_t i=0; i<m_obs; ++i) {
+      Observation obs(m_provided[m_next_provided], busyPred);
+      obs.restrictAttribute(valueAttr, IntegerDomain(now));
+      postObservation(obs);
+      m_next_provided = (m_next_provided+1)%m_provided.size();
+      ++m_n_obs;
+    }
+  }
+  return true;
+}
+
+bool Synthetic::hasWork() {
+  return m_left>0;
+}
+
+void Synthetic::resume() {
+  typedef CHRONO::high_resolution_clock clock;
+  
+  // Busy wait to emulate a cpu bound deliberation step
+  clock::time_point const end = clock::now()+m_cost;
+  while( clock::now()<end );
+  --m_left;
+}
+
+void Synthetic::handleRequest(goal_id const &/*g*/) {
+  ++m_n_requests;
+}
+
+void Synthetic::handleRecall(goal_id const &/*g*/) {
+  ++m_n_recalls;
+}
+
+void Synthetic::notify(Observation const &/*obs*/) {
+  ++m_n_notified;
+}
@@ -0,0 +1,127 @@
+/** @file "Synthetic.hh"
+ *  @brief synthetic reactor for benchmarks
+ *
+ *  This file defines a configurable reactor used to build synthetic 
+ *  reactor graphs for benchmarking.
+ *  
+ *  @ingroup bench
+ */
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ * 
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ * 
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ * 
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ * 
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef H_Synthetic
+# define H_Synthetic
+
+# include <trex/transaction/TeleoReactor.hh>
+
+# include <list>
+# include <vector>
+
+namespace TREX {
+  /** @brief synthetic benchmark plug-in
+   *
+   * This namespace embeds the classes provided by the synthetic 
+   * plug-in used by the @c trex_bench command
+   * 
+   * @ingroup bench
+   */
+  namespace bench {
+
+    /** @brief Synthetic reactor
+     *
+     * A reactor with no real purpose other than producing a configurable 
+     * load on the agent. Every tick it posts observations on its 
+     * @e Internal timelines, sends goals to its @e External timelines 
+     * -- recalling the ones it sent the previous tick -- and executes 
+     * a number of deliberation steps each busy for a given time.
+     *
+     * @ingroup bench
+     */
+    class Synthetic :public TREX::transaction::TeleoReactor {
+    public:
+      /** @brief XML constructor
+       * @param arg An XML node definition
+       *
+       * The expected XML format is the following:
+       * @code
+       * <Synthetic name="<name>" latency="<int>" lookahead="<int>" 
+       *            timelines="<int>" uses="<tl>,<tl>,..." 
+       *            observations="<int>" goals="<int>" steps="<int>" 
+       *            cost="<int>" />
+       * @endcode
+       * Where :
+       * @li @c timelines is the number of @e Internal timelines named 
+       *     @c @<name@>_0 to @c @<name@>_@<timelines-1@> (default 1)
+       * @li @c uses is a comma separated list of @e External timelines
+       * @li @c observations is the number of observations posted per tick
+       *     on the @e Internal timelines in turn (default 1)
+       * @li @c goals is the number of goals sent per tick on the 
+       *     @e External timelines in turn (default 0)
+       * @li @c steps is the number of deliberation steps requested per tick
+       *     (default 0)
+       * @li @c cost is the duration of a deliberation step in microseconds
+       *     (default 0)
+       */
+      Synthetic(TREX::transaction::TeleoReactor::xml_arg_type arg);
+      /** @brief Destructor */
+      ~Synthetic();
+
+    private:
+      void handleInit();
+      void handleTickStart();
+      bool synchronize();
+      
+      bool hasWork();
+      void resume();
+      
+      void handleRequest(TREX::transaction::goal_id const &g);
+      void handleRecall(TREX::transaction::goal_id const &g);
+      void notify(TREX::transaction::Observation const &obs);
+
+      std::vector<TREX::utils::Symbol> m_provided, m_used;
+      size_t const m_obs, m_goals, m_steps;
+      CHRONO::microseconds const m_cost;
+
+      size_t m_next_provided, m_next_used, m_left;
+      std::list<TREX::transaction::goal_id> m_sent;
+      
+      unsigned long long m_n_obs, m_n_notified, m_n_requests, m_n_recalls;
+      
+      static TREX::utils::Symbol const busyPred;
+      static TREX::utils::Symbol const valueAttr;
+    }; // TREX::bench::Synthetic
+
+  } // TREX::bench
+} // TREX
+
+#endif // H_Synthetic
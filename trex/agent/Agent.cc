@@ -40,6 +40,7 @@
 
 #include "Agent.hh"
 
+#include <algorithm>
 #include <iterator>
 #include <limits>
 
@@ -173,7 +174,21 @@ namespace TREX {
          *       soon as the search complete.
          */
         explicit sync_scheduller(reactor_queue &sync_order)
-        :m_sync(&sync_order) {}
+        :m_sync(&sync_order), m_tick(NULL) {}
+        /** @brief Constructor
+         *
+         * @param[in,out] sync_order A reference to the list where the schduling
+         *                           order should be stored
+         * @param[in,out] tick_order A reference to the list where the order 
+         *                           of the @c newTick calls should be stored
+         *
+         * Create A new instance that will put the reactor synchronization
+         * scheduling into the list referred by @p sync_order and the order 
+         * in which the reactors have been notified of the new tick into 
+         * @p tick_order
+         */
+        sync_scheduller(reactor_queue &sync_order, reactor_queue &tick_order)
+        :m_sync(&sync_order), m_tick(&tick_order) {}
         /** @briief Copy constructor
          *
          * @param[in] other Another instance
@@ -181,7 +196,7 @@ namespace TREX {
          * Create new instance referring to the same scheduling list as @p other
          */
         sync_scheduller(sync_scheduller const &other)
-        :CycleDetector(other), m_sync(other.m_sync) {}
+        :CycleDetector(other), m_sync(other.m_sync), m_tick(other.m_tick) {}
         /** @brief Destructor */
         virtual ~sync_scheduller() {}
         
@@ -198,9 +213,12 @@ namespace TREX {
           // First encounter with r :
           //   - inform him that a new tick has started
           //        this will result on dispatching its goals if possible
-          if( is_valid(r,g) )
+          if( is_valid(r,g) ) {
+            if( NULL!=m_tick )
+              m_tick->push_back(r);
             if( !r->newTick() )
               g.isolate(r);
+          }
         }
         
         /** @brief Finish vertex callback
@@ -223,6 +241,8 @@ namespace TREX {
       private:
         /** @brief Reference to scheduling list */
         reactor_queue               *m_sync;
+        /** @brief Reference to new tick notification list */
+        reactor_queue               *m_tick;
         
         sync_scheduller(); // no code in purpose
       };
@@ -422,6 +442,286 @@ namespace TREX {
         Cycle_Type timelineType;
       };
       
+      /** @brief Parallel synchronization of a dependency level
+       *
+       * This class is used by the agent when parallel synchronization is 
+       * enabled. It manages the synchronization of a set of reactors that 
+       * do not depend on each other -- ie all the reactors of a same level 
+       * in the dependency graph -- by sharing their @c doSynchronize calls 
+       * between the calling thread and a set of helper tasks posted on an 
+       * asio service.
+       *
+       * The call to execute acts as a barrier: it will not return until all 
+       * the reactors of this level have completed their synchronization.
+       *
+       * @note As @c doSynchronize blocks on the graph strand -- which is 
+       *       executed by the same asio service -- the number of helpers 
+       *       should always be strictly less than the number of threads 
+       *       of this service in order to avoid a dead lock.
+       *
+       * @relates class Agent
+       * @ingroup agent
+       */
+      class level_sync :boost::noncopyable {
+      public:
+        typedef std::vector<graph::reactor_id> reactor_vector;
+        
+        /** @brief Constructor
+         *
+         * @param[in] level A set of independent reactors
+         */
+        explicit level_sync(reactor_vector const &level)
+        :m_level(level), m_success(level.size(), 0), m_next(0), m_pending(0) {}
+        /** @brief Destructor */
+        ~level_sync() {}
+        
+        /** @brief Execute synchronization
+         *
+         * @param[in] io The service used to execute the helpers
+         * @param[in] helpers The maximum number of helpers to use
+         *
+         * Synchronizes all the reactors of this level using at most 
+         * @p helpers tasks on @p io in addition to the calling thread. 
+         * 
+         * @post all the reactors of this level have been synchronized
+         */
+        void execute(boost::asio::io_service &io, size_t helpers) {
+          if( m_level.size()<=helpers )
+            helpers = m_level.size()-1;
+          m_pending = helpers;
+          for(size_t i=0; i<helpers; ++i)
+            io.post(boost::bind(&level_sync::helper, this));
+          run();
+          // wait for all the helpers to complete
+          boost::unique_lock<boost::mutex> lock(m_mtx);
+          while( m_pending>0 )
+            m_done.wait(lock);
+        }
+        
+        /** @brief Synchronization result
+         *
+         * @param[in] i An index
+         *
+         * @pre execute has been called
+         * @retval true if the reactor @p i of this level synchronized
+         *  properly
+         * @retval false otherwise
+         */
+        bool succeeded(size_t i) const {
+          return m_success[i]!=0;
+        }
+        
+      private:
+        bool next(size_t &i) {
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          if( m_next<m_level.size() ) {
+            i = m_next++;
+            return true;
+          }
+          return false;
+        }
+        
+        void run() {
+          size_t i;
+          while( next(i) )
+            m_success[i] = m_level[i]->doSynchronize();
+        }
+        
+        void helper() {
+          run();
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          if( 0==--m_pending )
+            m_done.notify_all();
+        }
+        
+        reactor_vector const &m_level;
+        // Note: we avoid std::vector<bool> as each of its elements
+        //       are not independent memory locations
+        std::vector<char>     m_success;
+        size_t                m_next, m_pending;
+        boost::mutex              m_mtx;
+        boost::condition_variable m_done;
+        
+        level_sync(); // no code in purpose
+      };
+      
+      /** @brief Parallel deliberation executor
+       *
+       * This class is used by the agent when parallel deliberation is 
+       * enabled. It executes the deliberation steps of distinct reactors 
+       * concurrently on an asio service while the agent thread keeps 
+       * the ownership of the scheduling queues. 
+       *
+       * The agent is responsible to never dispatch a reactor that is 
+       * still running: a reactor is only given back to the agent -- 
+       * through completed or join -- once its step is complete which 
+       * ensures the mutual exclusion between the steps of a same reactor.
+       *
+       * @note As a reactor step may block on the graph strand -- which 
+       *       is executed by the same asio service -- the number of 
+       *       workers should always be strictly less than the number 
+       *       of threads of this service in order to avoid a dead lock.
+       *
+       * @relates class Agent
+       * @ingroup agent
+       */
+      class delib_pool :boost::noncopyable {
+      public:
+        typedef std::list<graph::reactor_id> reactor_queue;
+        typedef boost::function<void (graph::reactor_id)> step_fn;
+        
+        /** @brief Constructor
+         *
+         * @param[in] io The service used to execute the steps
+         * @param[in] workers The maximum number of concurrent steps
+         * @param[in] fn The function that executes a reactor step
+         */
+        delib_pool(boost::asio::io_service &io, size_t workers,
+                   step_fn const &fn)
+        :m_io(io), m_workers(workers), m_step(fn), m_woken(false) {}
+        /** @brief Destructor
+         *
+         * Wait for all the pending steps to complete
+         */
+        ~delib_pool() {
+          reactor_queue tmp;
+          join(tmp);
+        }
+        
+        /** @brief Check if the pool is busy
+         *
+         * @retval true if the pool already runs as many steps as it 
+         *  has workers
+         * @retval false otherwise
+         */
+        bool full() const {
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          return m_active.size()>=m_workers;
+        }
+        /** @brief Number of pending steps */
+        size_t running() const {
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          return m_active.size();
+        }
+        /** @brief Check if a reactor is running
+         *
+         * @param[in] r A reactor
+         *
+         * @retval true if @p r step is still pending
+         * @retval false otherwise
+         */
+        bool busy(graph::reactor_id r) const {
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          return m_active.end()!=m_active.find(r);
+        }
+        
+        /** @brief Start a reactor step
+         *
+         * @param[in] r A reactor
+         *
+         * Post the execution of @p r step on the pool
+         *
+         * @pre @p r is not currently running on this pool
+         */
+        void dispatch(graph::reactor_id r) {
+          {
+            boost::lock_guard<boost::mutex> lock(m_mtx);
+            m_active.insert(r);
+          }
+          m_io.post(boost::bind(&delib_pool::execute, this, r));
+        }
+        
+        /** @brief Collect completed steps
+         *
+         * @param[out] done A queue
+         * @param[in] block blocking flag
+         *
+         * Appends to @p done all the reactors which step completed since 
+         * the last call. If @p block is @c true and steps are still 
+         * pending, this call will block until at least one step completes 
+         * or wake() is called.
+         *
+         * @sa wake()
+         */
+        void completed(reactor_queue &done, bool block=false) {
+          boost::unique_lock<boost::mutex> lock(m_mtx);
+          if( block )
+            while( m_done.empty() && !m_active.empty() && !m_woken )
+              m_cond.wait(lock);
+          m_woken = false;
+          done.splice(done.end(), m_done);
+        }
+        /** @brief Wake up the agent
+         *
+         * Indicates that new work is available for reactors that are not 
+         * running. This makes the current -- or next -- blocking call to 
+         * completed return so the agent can dispatch them.
+         */
+        void wake() {
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          m_woken = true;
+          m_cond.notify_all();
+        }
+        /** @brief Wait for all steps
+         *
+         * @param[out] done A queue
+         *
+         * Wait for all the pending steps to complete and appends to @p done 
+         * all the reactors that completed.
+         */
+        void join(reactor_queue &done) {
+          boost::unique_lock<boost::mutex> lock(m_mtx);
+          while( !m_active.empty() )
+            m_cond.wait(lock);
+          done.splice(done.end(), m_done);
+        }
+        
+      private:
+        void execute(graph::reactor_id r) {
+          m_step(r);
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          m_done.push_back(r);
+          m_active.erase(r);
+          m_cond.notify_all();
+        }
+        
+        boost::asio::io_service  &m_io;
+        size_t                    m_workers;
+        step_fn                   m_step;
+        
+        mutable boost::mutex      m_mtx;
+        boost::condition_variable m_cond;
+        std::set<graph::reactor_id> m_active;
+        reactor_queue             m_done;
+        bool                      m_woken;
+        
+        delib_pool(); // no code in purpose
+      };
+      
+      /** @brief Deliberation pool registration
+       *
+       * Makes a pool the one woken up by Agent::work_available for the 
+       * lifetime of this instance.
+       *
+       * @relates class delib_pool
+       * @ingroup agent
+       */
+      class pool_scope :boost::noncopyable {
+      public:
+        pool_scope(boost::mutex &mtx, delib_pool *&slot, delib_pool &pool)
+        :m_mtx(mtx), m_slot(slot) {
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          m_slot = &pool;
+        }
+        ~pool_scope() {
+          boost::lock_guard<boost::mutex> lock(m_mtx);
+          m_slot = NULL;
+        }
+        
+      private:
+        boost::mutex &m_mtx;
+        delib_pool  *&m_slot;
+      };
       
     }
   }
@@ -443,14 +743,16 @@ TICK Agent::initialTick(clock_ref clk) {
 // structors :
 
 Agent::Agent(Symbol const &name, TICK final, clock_ref clk, bool verbose)
-:graph(name, initialTick(clk), verbose), m_continue_if_empty(false),
- m_stat_log(manager().service()), m_clock(clk), m_finalTick(final), m_valid(true) {
+:graph(name, initialTick(clk), verbose), m_order_updates(0), m_continue_if_empty(false),
+ m_stat_log(manager().service()), m_clock(clk), m_finalTick(final), m_pool(NULL),
+ m_valid(true), m_sync_threads(0), m_delib_threads(0) {
   m_proxy = new AgentProxy(*this);
   add_reactor(m_proxy);
 }
 
 Agent::Agent(std::string const &file_name, clock_ref clk, bool verbose)
-:m_stat_log(manager().service()), m_clock(clk), m_valid(true), m_continue_if_empty(false) {
+:m_order_updates(0), m_stat_log(manager().service()), m_clock(clk), m_pool(NULL),
+ m_valid(true), m_continue_if_empty(false), m_sync_threads(0), m_delib_threads(0) {
   set_verbose(verbose);
   updateTick(initialTick(m_clock), false);
   m_proxy = new AgentProxy(*this);
@@ -474,7 +776,8 @@ Agent::Agent(std::string const &file_name, clock_ref clk, bool verbose)
 }
 
 Agent::Agent(boost::property_tree::ptree::value_type &conf, clock_ref clk, bool verbose)
-:m_stat_log(manager().service()), m_clock(clk), m_valid(true), m_continue_if_empty(false) {
+:m_order_updates(0), m_stat_log(manager().service()), m_clock(clk), m_pool(NULL),
+ m_valid(true), m_continue_if_empty(false), m_sync_threads(0), m_delib_threads(0) {
   set_verbose(verbose);
   updateTick(initialTick(m_clock), false);
   m_proxy = new AgentProxy(*this);
@@ -697,6 +1000,33 @@ void Agent::loadConf(boost::property_tree::ptree::value_type &config) {
     m_finalTick = parse_attr<TICK>(std::numeric_limits<TICK>::max(), config, "finalTick");
     if( m_finalTick<=0 )
       throw XmlError(config, "agent life time should be greater than 0");
+    m_sync_threads = parse_attr<size_t>(0, config, "sync_threads");
+    if( m_sync_threads>0 ) {
+      // Keep at least one thread free for the strands used during
+      // reactors synchronization
+      size_t n = manager().thread_count(m_sync_threads+2)-1;
+      if( n<m_sync_threads ) {
+        syslog(null, warn)<<"Only "<<n
+        <<" threads available for parallel synchronization.";
+        m_sync_threads = n;
+      }
+      syslog(null, info)<<"Parallel synchronization enabled with "
+      <<m_sync_threads<<" helper threads.";
+    }
+    m_delib_threads = parse_attr<size_t>(0, config, "delib_threads");
+    if( m_delib_threads>0 ) {
+      // As for synchronization, steps may need the graph strand
+      size_t n = manager().thread_count(m_delib_threads+2)-1;
+      if( n<m_delib_threads ) {
+        syslog(null, warn)<<"Only "<<n
+        <<" threads available for parallel deliberation.";
+        m_delib_threads = n;
+      }
+      syslog(null, info)<<"Parallel deliberation enabled with "
+      <<m_delib_threads<<" worker threads.";
+    }
+    if( parse_attr<bool>(true, config, "journal") )
+      open_journal();
   } catch(bad_string_cast const &e) {
     throw XmlError(config, e.what());
   }
@@ -790,7 +1120,13 @@ void Agent::initComplete() {
   m_stat_log.open(manager().file_name("agent_stats.csv").c_str());
   m_stat_log<<"tick, synch_ns, synch_rt_ns,"
   " delib_ns, delib_rt_ns, delib_steps,"
-  " planned_sleep, sleep_cnt, sleep_ns\n";
+  " planned_sleep, sleep_cnt, sleep_ns, order_updates, wake_late_ns";
+  {
+    async_ofstream::entry e = m_stat_log.new_entry();
+    for(size_t i=0; i<Clock::lateness_histogram::size; ++i)
+      e.stream()<<", "<<Clock::lateness_histogram::label(i);
+    e.stream()<<'\n';
+  }
   
   {
     graph_names_writer gn;
@@ -819,14 +1155,70 @@ void Agent::run() {
   syslog(null, info)<<"Mission completed."<<std::endl;
 }
 
+void Agent::update_sync_order() {
+  if( structure_changed() ) {
+    // The graph changed: explore it again
+    m_sync_order.clear();
+    m_tick_order.clear();
+    m_sync_levels.clear();
+    
+    details::sync_scheduller sync(m_sync_order, m_tick_order);
+    boost::depth_first_search(me(), boost::visitor(sync));
+    
+    // Compute the dependency levels
+    std::map<reactor_id, size_t> depth;
+    
+    // m_sync_order is ordered from the least to the most dependent
+    // reactor which ensures that all the reactors r depends on have
+    // already been given a level when we reach it
+    for(std::list<reactor_id>::const_iterator i=m_sync_order.begin();
+        m_sync_order.end()!=i; ++i) {
+      size_t lvl = 0;
+      TeleoReactor::external_iterator e, last;
+      
+      for(boost::tie(e, last)=boost::out_edges(*i, me()); last!=e; ++e) {
+        std::map<reactor_id, size_t>::const_iterator
+          pos = depth.find(boost::target(*e, me()));
+        if( depth.end()!=pos && pos->second>=lvl )
+          lvl = pos->second+1;
+      }
+      depth[*i] = lvl;
+      if( m_sync_levels.size()<=lvl )
+        m_sync_levels.resize(lvl+1);
+      m_sync_levels[lvl].push_back(*i);
+    }
+    ++m_order_updates;
+  } else {
+    // Same structure: just notify the reactors of the new tick in
+    // the same order as the search would have done
+    for(std::list<reactor_id>::const_iterator i=m_tick_order.begin();
+        m_tick_order.end()!=i; ++i)
+      if( !is_isolated(*i) && !(*i)->newTick() )
+        isolate(*i);
+  }
+}
+
 std::list<Agent::reactor_id> Agent::sort_reactors_sync() {
   std::list<reactor_id> queue;
-  details::sync_scheduller sync(queue);
   
-  boost::depth_first_search(me(), boost::visitor(sync));
+  update_sync_order();
+  for(std::list<reactor_id>::const_iterator i=m_sync_order.begin();
+      m_sync_order.end()!=i; ++i)
+    if( !is_isolated(*i) )
+      queue.push_back(*i);
   return queue;
 }
 
+bool Agent::synchronized(reactor_id r, bool success) {
+  if( success ) {
+    schedule(r);
+    return true;
+  }
+  // r failed => kill the reactor
+  kill_reactor(r);
+  return false;
+}
+
 
 
 void Agent::synchronize() {
@@ -835,7 +1227,12 @@ void Agent::synchronize() {
   sort_dfs(boost::bind(&Agent::sort_reactors_sync, this));
   
   m_edf.clear(); // Make sure that there's no one left in the schedulling
-  m_idle.clear();
+  m_polled.clear();
+  {
+    // All the reactors will be evaluated during synchronization
+    boost::lock_guard<boost::mutex> lock(m_notify_mtx);
+    m_notified.clear();
+  }
   bool update = false;
   
   stat_clock::duration delta;
@@ -846,34 +1243,66 @@ void Agent::synchronize() {
     utils::chronograph<rt_clock> rt_chron(delta_rt);
     utils::chronograph<stat_clock> stat_chron(delta);
     
-    queue = strand_run(strand(), sort_dfs);
-    
-    size_t n_failed = cleanup();
-    if( n_failed>0 )
-      syslog(null, warn)<<n_failed<<" reactors failed to start tick "
-      <<now;
-    // Execute synchronization
-    //  - could be done with a dfs but we choose for now to do it using the
-    //  output list of sync_scheduller to avoid a potentially costfull graph
-    //  exploration.
-    while( !queue.empty() ) {
-      reactor_id r = queue.front();
-      queue.pop_front();
-      // synchronization
-      if( r->doSynchronize() ) {
-        double wr = r->workRatio();
+    if( m_sync_threads>0 ) {
+      boost::function<void ()>
+      update_order(boost::bind(&Agent::update_sync_order, this));
+      boost::function<bool (reactor_id)>
+      isolated(boost::bind(&Agent::is_isolated, this, _1));
+      
+      strand_run(strand(), update_order);
+      
+      // Execute synchronization level by level
+      //  - reactors within a level do not depend on each other and can
+      //    be synchronized concurrently
+      //  - a level is started only when the previous one is complete
+      //  - the reactors isolated while starting the tick are skipped. 
+      //    They are only destroyed by cleanup once all the levels are 
+      //    done as m_sync_levels still refers to them
+      for(std::vector<sync_level>::const_iterator 
+            lvl=m_sync_levels.begin(); m_sync_levels.end()!=lvl; ++lvl) {
+        sync_level const *l = &*lvl;
+        sync_level active;
         
-        if( !std::isnan(wr) ) {
-          // this reactor has deliberation :
-          //   - add it to the edf scheduler
-          m_edf.insert(std::make_pair(wr, r));
-        } else {
-          m_idle.push_front(r);
+        if( l->end()!=std::find_if(l->begin(), l->end(), isolated) ) {
+          // only copy the level when it has isolated reactors
+          std::remove_copy_if(l->begin(), l->end(), 
+                              std::back_inserter(active), isolated);
+          l = &active;
         }
-      } else {
-        // r failed => kill the reactor
-        kill_reactor(r);
-        update = true;
+        if( l->size()>1 ) {
+          details::level_sync exec(*l);
+          exec.execute(manager().service(), m_sync_threads);
+          
+          for(size_t i=0; i<l->size(); ++i)
+            if( !synchronized((*l)[i], exec.succeeded(i)) )
+              update = true;
+        } else if( !l->empty() ) {
+          reactor_id r = l->front();
+          if( !synchronized(r, r->doSynchronize()) )
+            update = true;
+        }
+      }
+      size_t n_failed = cleanup();
+      if( n_failed>0 )
+        syslog(null, warn)<<n_failed<<" reactors failed to start tick "
+        <<now;
+    } else {
+      queue = strand_run(strand(), sort_dfs);
+    
+      size_t n_failed = cleanup();
+      if( n_failed>0 )
+        syslog(null, warn)<<n_failed<<" reactors failed to start tick "
+        <<now;
+      // Execute synchronization
+      //  - could be done with a dfs but we choose for now to do it using the
+      //  output list of sync_scheduller to avoid a potentially costfull graph
+      //  exploration.
+      while( !queue.empty() ) {
+        reactor_id r = queue.front();
+        queue.pop_front();
+        // synchronization
+        if( !synchronized(r, r->doSynchronize()) )
+          update = true;
       }
     }
   }
@@ -896,46 +1325,118 @@ void Agent::synchronize() {
   }
 }
 
-bool Agent::executeReactor() {
-  Symbol id = null;
-  bool was_empty = m_edf.empty();
+void Agent::step_reactor(reactor_id r) {
+  Symbol id = r->getName();
   
-  if( !was_empty ) {
-    // One reactor requested to run
-    double wr;
-    reactor_id r;
+  try {
+    r->step();
+  } catch(Exception const &e) {
+    syslog(id, warn)<<"Exception caught while executing reactor step:\n"<<e;
+  } catch(std::exception const &se) {
+    syslog(id, warn)<<"C++ exception caught while executing reactor step:\n"
+    <<se.what();
+  } catch(...) {
+    syslog(id, warn)<<"Unknown exception caught while executing reactor step.";
+  }
+}
 
-    boost::tie(wr, r) = *(m_edf.begin());
-    m_edf.erase(m_edf.begin());
-    m_idle.push_back(r);
+void Agent::work_available(reactor_id r) {
+  boost::lock_guard<boost::mutex> lock(m_notify_mtx);
+  m_notified.insert(r);
+  // let the agent dispatch r if it is waiting for a step to complete
+  if( NULL!=m_pool )
+    m_pool->wake();
+}
 
-    try {
-      id = r->getName();
-      r->step();
-    } catch(Exception const &e) {
-      syslog(id, warn)<<"Exception caught while executing reactor step:\n"<<e;
-    } catch(std::exception const &se) {
-      syslog(id, warn)<<"C++ exception caught while executing reactor step:\n"
-      <<se.what();
-    } catch(...) {
-      syslog(id, warn)<<"Unknown exception caught while executing reactor step.";
-    }
+void Agent::schedule(reactor_id r) {
+  double wr = r->workRatio();
+  
+  if( std::isnan(wr) ) {
+    m_edf.erase(r); // r is now idle
+    if( r->is_polled() )
+      m_polled.insert(r);
+  } else {
+    m_edf.push(r, wr); // add or update r in the edf scheduler
+    m_polled.erase(r);
   }
+}
+
+void Agent::schedule_polled(details::delib_pool const *pool) {
+  std::set<reactor_id>::iterator i = m_polled.begin();
   
-  std::list<reactor_id>::iterator i = m_idle.begin();
-  double wr;
-  while( m_idle.end()!=i ) {
+  while( m_polled.end()!=i ) {
+    reactor_id r = *(i++); // schedule may remove r from m_polled
+    
+    if( !is_member(r) || !r->is_polled() )
+      m_polled.erase(r);
+    else if( NULL==pool || !pool->busy(r) )
+      schedule(r);
+  }
+}
+
+void Agent::schedule_notified(details::delib_pool const *pool) {
+  std::set<reactor_id> tmp;
+  {
+    boost::lock_guard<boost::mutex> lock(m_notify_mtx);
+    std::swap(tmp, m_notified);
+  }
+  for(std::set<reactor_id>::const_iterator i=tmp.begin(); tmp.end()!=i; ++i) {
+    // Running reactors will be evaluated when their step complete
+    if( NULL!=pool && pool->busy(*i) )
+      continue;
     // Check if the reactor is still valid
-    if( is_member(*i) ) {
-      wr = (*i)->workRatio();
-      if( !std::isnan(wr) ) {
-	m_edf.insert(std::make_pair(wr, *i));
-	i = m_idle.erase(i);
-      } else
-	++i;
-    } else
-      i = m_idle.erase(i);
+    if( is_member(*i) )
+      schedule(*i);
+  }
+  // Some reactors do not notify their work: re-evaluate them too
+  schedule_polled(pool);
+}
+
+bool Agent::executeReactors(details::delib_pool &pool, size_t &count) {
+  std::list<reactor_id> done;
+  bool dispatched = false;
+  
+  // Reschedule the reactors that completed their step
+  pool.completed(done);
+  for(; !done.empty(); done.pop_front())
+    schedule(done.front());
+  schedule_notified(&pool);
+  
+  for(bool waited=false; ; waited=true) {
+    // Dispatch the reactors by decreasing workRatio as long as we
+    // have free workers and the clock allows more steps
+    while( !m_edf.empty() && !pool.full() && m_clock->is_free() ) {
+      reactor_id r = m_edf.top();
+      m_edf.pop();
+      pool.dispatch(r);
+      dispatched = true;
+      m_clock->report_steps(++count, true);
+    }
+    if( dispatched || waited || !m_clock->is_free() )
+      return true;
+    if( 0==pool.running() )
+      return false; // no more deliberation to do
+    // nothing new could be dispatched: wait for one step to complete
+    // or for new work to be notified by work_available
+    pool.completed(done, true);
+    for(; !done.empty(); done.pop_front())
+      schedule(done.front());
+    schedule_notified(&pool);
   }
+}
+
+bool Agent::executeReactor() {
+  bool was_empty = m_edf.empty();
+  
+  if( !was_empty ) {
+    // One reactor requested to run
+    reactor_id r = m_edf.top();
+    
+    step_reactor(r);
+    // update its priority
+    schedule(r);
+  }
+  schedule_notified(NULL);
   return !(was_empty && m_edf.empty());
 }
 
@@ -962,7 +1463,7 @@ bool Agent::doNext() {
   
   size_t count = 0; //slp_count = 0;
   stat_clock::duration delib;
-  rt_clock::duration delib_rt, sleep_time, sleep_req;
+  rt_clock::duration delib_rt, sleep_time, sleep_req(rt_clock::duration::zero());
   size_t sl_count = 0;
   
   bool print_delib = true;
@@ -971,10 +1472,25 @@ bool Agent::doNext() {
     {
       utils::chronograph<stat_clock> stat_chron(delib);
       utils::chronograph<rt_clock> rt_chron(delib_rt);
-      while( m_clock->tick()==now
-            && m_clock->is_free() && valid()
-            && executeReactor() ) {
-        ++count;
+      if( m_delib_threads>0 ) {
+        details::delib_pool pool(manager().service(), m_delib_threads,
+                                 boost::bind(&Agent::step_reactor, this, _1));
+        details::pool_scope wake_on_work(m_notify_mtx, m_pool, pool);
+        
+        while( m_clock->tick()==now
+              && m_clock->is_free() && valid()
+              && executeReactors(pool, count) );
+        m_clock->report_steps(count, !m_edf.empty() || 0<pool.running());
+        // Do not start the next tick while steps are still running
+        std::list<reactor_id> done;
+        pool.join(done);
+      } else {
+        while( m_clock->tick()==now
+              && m_clock->is_free() && valid()
+              && executeReactor() ) {
+          ++count;
+          m_clock->report_steps(count, !m_edf.empty());
+        }
       }
     }
     
@@ -999,8 +1515,19 @@ bool Agent::doNext() {
     m_valid = false;
   }
   if( print_delib )
-    m_stat_log<<", "<<delib.count()<<", "<<count<<", ";
-  m_stat_log<<sleep_req.count()<<", "<<sl_count<<", "<<sleep_time.count()<<std::endl;
+    m_stat_log<<", "<<delib.count()<<", "<<delib_rt.count()
+    <<", "<<count<<", ";
+  {
+    async_ofstream::entry e = m_stat_log.new_entry();
+    // Cumulated histogram of how late the clock woke up on new ticks
+    Clock::lateness_histogram const &late = m_clock->lateness();
+    
+    e.stream()<<sleep_req.count()<<", "<<sl_count<<", "<<sleep_time.count()
+    <<", "<<m_order_updates<<", "<<late.last().count();
+    for(size_t i=0; i<Clock::lateness_histogram::size; ++i)
+      e.stream()<<", "<<late.count(i);
+    e.stream()<<std::endl;
+  }
   
   return valid();
 }
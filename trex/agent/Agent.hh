@@ -54,12 +54,17 @@
 # include "Clock.hh"
 # include <trex/utils/PluginLoader.hh>
 # include <trex/utils/asio_fstream.hh>
+# include <trex/utils/indexed_heap.hh>
 
 namespace TREX {
   namespace agent {
     
     typedef SHARED_PTR<Clock> clock_ref;
     
+    namespace details {
+      class delib_pool;
+    }
+    
     /** @brief TREX agent
      *
      * This class implements the TREX agent. It extends the graph concept
@@ -105,10 +110,11 @@ namespace TREX {
        *
        * This structure is used to find a good scheduling order for the reactors
        * deliberation. It sorts the reactors that needs to deliberate from the one
-       * with the largest @c workRatio to the one with smaller @c workRatio
+       * with the largest @c workRatio to the one with smaller @c workRatio. As 
+       * it is indexed by reactor, the priority of a reactor can be updated 
+       * after each deliberation step without rebuilding the queue.
        */
-      typedef std::multimap< double, reactor_id,
-      std::greater<double> > priority_queue;
+      typedef TREX::utils::indexed_heap<double, reactor_id> priority_queue;
       
       /** @brief Constructor
        *
@@ -150,6 +156,18 @@ namespace TREX {
        * @li @c name is the name of the agent
        * @li @c finalTick is a value greater than 0 that indicates
        *     the agent lifetime
+       * @li @c sync_threads is an optional attribute giving the number 
+       *     of extra threads used to synchronize in parallel the reactors 
+       *     that do not depend on each other. Its default value is 0 which 
+       *     means that reactors are synchronized sequentially
+       * @li @c delib_threads is an optional attribute giving the maximum 
+       *     number of reactors allowed to deliberate concurrently. Its 
+       *     default value is 0 which means that reactors steps are executed 
+       *     sequentially by the agent thread
+       * @li @c journal is an optional flag (default @c 1) indicating if 
+       *     the observations are recorded in the @c observations.tsv 
+       *     journal. When set only the observations of verbose reactors 
+       *     are echoed in the system log
        * @li @c config is an optional attribute that points to another XML file.
        *     this file will contains extra tags that will be parse in simlar mananer
        *     to the childs of this root tag.
@@ -427,8 +445,57 @@ namespace TREX {
                           TREX::transaction::details::timeline const &tl);
       
       std::list<reactor_id> init_dfs_sync();
+      /** @brief Synchronization order
+       *
+       * Notifies all the reactors of the new tick and identifies the order 
+       * in which they should be synchronized -- from the least dependent 
+       * to the most dependent.
+       *
+       * @return the list of reactors in synchronization order
+       *
+       * @sa update_sync_order()
+       */
       std::list<reactor_id> sort_reactors_sync();
       
+      /** @brief Set of independent reactors
+       *
+       * A set of reactors that do not depend on each other and can 
+       * then be synchronized concurrently
+       */
+      typedef std::vector<reactor_id> sync_level;
+      /** @brief Update synchronization order
+       *
+       * Notifies all the reactors of the new tick. If the graph structure 
+       * changed since the last call, this is done through a depth first 
+       * search which also recomputes the synchronization order cache. 
+       * Otherwise the reactors are notified using the cached order and 
+       * the search is avoided.
+       *
+       * @pre this method is executed within the graph strand
+       *
+       * @sa TREX::transaction::graph::structure_changed(bool)
+       */
+      void update_sync_order();
+      /** @brief Cached @c newTick order */
+      std::list<reactor_id>   m_tick_order;
+      /** @brief Cached synchronization order */
+      std::list<reactor_id>   m_sync_order;
+      /** @brief Cached synchronization levels
+       *
+       * The synchronization order of the reactors like m_sync_order but 
+       * regrouped by dependency level, from the least dependent to the 
+       * most dependent. Each reactor belongs to the level following the 
+       * deepest level of all the reactors it depends on. All the 
+       * reactors of a level can be synchronized in parallel as long as 
+       * all the reactors of the previous levels have been synchronized.
+       *
+       * @note These levels may include reactors isolated since they were 
+       *   computed which should then be skipped
+       */
+      std::vector<sync_level> m_sync_levels;
+      /** @brief Number of synchronization order updates */
+      size_t                  m_order_updates;
+      
       std::list<boost::property_tree::ptree::value_type> m_goals;
       
       AgentProxy *m_proxy;
@@ -459,6 +526,18 @@ namespace TREX {
        * @li @c name is the name of the agent
        * @li @c finalTick is a value greater than 0 that indicates
        *     the agent lifetime
+       * @li @c sync_threads is an optional attribute giving the number 
+       *     of extra threads used to synchronize in parallel the reactors 
+       *     that do not depend on each other. Its default value is 0 which 
+       *     means that reactors are synchronized sequentially
+       * @li @c delib_threads is an optional attribute giving the maximum 
+       *     number of reactors allowed to deliberate concurrently. Its 
+       *     default value is 0 which means that reactors steps are executed 
+       *     sequentially by the agent thread
+       * @li @c journal is an optional flag (default @c 1) indicating if 
+       *     the observations are recorded in the @c observations.tsv 
+       *     journal. When set only the observations of verbose reactors 
+       *     are echoed in the system log
        * @li @c config is an optional attribute that points to another XML file.
        *     this file will contains extra tags that will be parse in simlar mananer
        *     to the childs of this root tag.
@@ -539,10 +618,41 @@ namespace TREX {
       clock_ref                  m_clock;
       TREX::transaction::TICK    m_finalTick;
       priority_queue             m_edf;
-      std::list<reactor_id>      m_idle;
+      /** @brief Idle polled reactors
+       *
+       * The reactors with no deliberation to do which are polled for 
+       * work. Their @c workRatio is re-evaluated after each step as they 
+       * may have new work without notifying it.
+       *
+       * @sa TREX::transaction::TeleoReactor::is_polled() const
+       */
+      std::set<reactor_id>       m_polled;
+      /** @brief Reactors notified of new work since last evaluation */
+      std::set<reactor_id>       m_notified;
+      boost::mutex               m_notify_mtx;
+      /** @brief Active deliberation pool
+       *
+       * The pool woken up by work_available while parallel deliberation 
+       * runs or NULL. Protected by m_notify_mtx.
+       */
+      details::delib_pool       *m_pool;
       
       mutable utils::SharedVar<bool> m_valid;
       bool m_continue_if_empty;
+      /** @brief Number of parallel synchronization helpers
+       *
+       * The number of threads that can be used in addition to the agent 
+       * thread to synchronize the reactors. A value of 0 indicates that 
+       * reactors are synchronized sequentially.
+       */
+      size_t m_sync_threads;
+      /** @brief Number of parallel deliberation workers
+       *
+       * The maximum number of reactors that can execute their deliberation 
+       * step concurrently. A value of 0 indicates that the steps are executed 
+       * sequentially by the agent thread.
+       */
+      size_t m_delib_threads;
       
       bool valid() const {
         utils::SharedVar<bool>::scoped_lock lck(m_valid);
@@ -550,8 +660,75 @@ namespace TREX {
       }
       
       void synchronize();
+      /** @brief Post synchronization scheduling
+       *
+       * @param[in] r A reactor
+       * @param[in] success Result of @p r synchronization
+       *
+       * Updates the deliberation scheduling of @p r after its 
+       * synchronization or kill @p r if it failed to synchronize
+       *
+       * @retval true if @p r synchronized successfully
+       * @retval false if @p r has been killed
+       */
+      bool synchronized(reactor_id r, bool success);
       
       bool executeReactor();
+      /** @brief Parallel deliberation
+       *
+       * @param[in] pool A deliberation executor
+       * @param[in,out] count Number of steps dispatched
+       *
+       * Dispatches to @p pool the steps of the reactors with the highest 
+       * @c workRatio as long as it has free workers and increments @p count 
+       * accordingly. If no reactor can be dispatched while some steps are 
+       * still running, this call blocks until one of them completes.
+       *
+       * @retval true if deliberation is still in progress
+       * @retval false if there's no more deliberation to do
+       */
+      bool executeReactors(details::delib_pool &pool, size_t &count);
+      /** @brief Execute a reactor step
+       *
+       * @param[in] r A reactor
+       *
+       * Executes the deliberation step of @p r and logs any exception it 
+       * may produce
+       */
+      void step_reactor(reactor_id r);
+      /** @brief Update reactor scheduling
+       *
+       * @param[in] r A reactor
+       *
+       * Evaluate the @c workRatio of @p r and update its position in the 
+       * deliberation queue accordingly. If @p r has no deliberation to do 
+       * it is removed from the queue.
+       */
+      void schedule(reactor_id r);
+      /** @brief Reschedule notified reactors
+       *
+       * @param[in] pool A deliberation executor or @c NULL
+       *
+       * Update the scheduling of all the reactors that notified new work 
+       * since the last call along with the idle polled reactors. Reactors 
+       * still running in @p pool are skipped as they will be rescheduled 
+       * when their step complete.
+       *
+       * @sa work_available(reactor_id)
+       * @sa schedule_polled(details::delib_pool const *)
+       */
+      void schedule_notified(details::delib_pool const *pool);
+      /** @brief Reschedule idle polled reactors
+       *
+       * @param[in] pool A deliberation executor or @c NULL
+       *
+       * Re-evaluate the @c workRatio of all the reactors of m_polled. This 
+       * ensures that reactors which do not call notifyWork when they get 
+       * new work are still scheduled.
+       */
+      void schedule_polled(details::delib_pool const *pool);
+      
+      void work_available(reactor_id r);
       
       void loadPlugin(boost::property_tree::ptree::value_type &pg,
                       std::string path);
@@ -39,12 +39,57 @@
  */
 #include "Clock.hh"
 
+#include <algorithm>
+
+#include <time.h>
+#include <unistd.h>
+
 #include <boost/date_time/posix_time/posix_time_io.hpp>
 
+// clock_nanosleep with TIMER_ABSTIME is only available on systems
+// implementing the posix monotonic clock and timers (not darwin)
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS>0 && \
+    defined(_POSIX_MONOTONIC_CLOCK) && defined(TIMER_ABSTIME)
+# define TREX_DEADLINE_SLEEP
+#endif
+
 using namespace TREX::agent;
 using namespace TREX::transaction;
 using namespace TREX::utils;
 
+/*
+ * class TREX::agent::Clock::lateness_histogram
+ */
+
+// statics :
+
+char const *Clock::lateness_histogram::label(size_t i) {
+  static char const *labels[size] = {
+    "late_10us", "late_100us", "late_1ms", "late_10ms", "late_100ms",
+    "late_more"
+  };
+  return labels[i];
+}
+
+// structors :
+
+Clock::lateness_histogram::lateness_histogram()
+:m_last(duration_type::zero()) {
+  std::fill(m_count, m_count+size, 0);
+}
+
+// modifiers :
+
+void Clock::lateness_histogram::add(Clock::duration_type const &late) {
+  duration_type bound = CHRONO::microseconds(10);
+  size_t i = 0;
+
+  m_last = late;
+  for( ; i+1<size && late>=bound; ++i)
+    bound *= 10;
+  ++m_count[i];
+}
+
 /*
  * class TREX::transaction::Clock
  */
@@ -64,6 +109,35 @@ void Clock::sleep(Clock::duration_type const &delay){
   }
 }
 
+void Clock::deadline_sleep(Clock::steady_clock::time_point const &deadline) {
+#ifdef TREX_DEADLINE_SLEEP
+  CHRONO::nanoseconds date = 
+    CHRONO::duration_cast<CHRONO::nanoseconds>(deadline.time_since_epoch());
+  timespec tv;
+  
+  tv.tv_sec = date.count()/1000000000l;
+  tv.tv_nsec = date.count()%1000000000l;
+  // Interruptions just resume waiting for the same deadline
+  int ret;
+  while( EINTR==(ret=clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                                     &tv, NULL)) );
+  if( 0!=ret ) {
+    errno = ret;
+    throw ErrnoExcept("Clock:deadline_sleep");
+  }
+#else // !TREX_DEADLINE_SLEEP
+  sleep(CHRONO::duration_cast<duration_type>(deadline-steady_clock::now()));
+#endif // TREX_DEADLINE_SLEEP
+}
+
+bool Clock::has_deadline_sleep() {
+#ifdef TREX_DEADLINE_SLEEP
+  return true;
+#else
+  return false;
+#endif
+}
+
 // structors :
 
 Clock::~Clock() {
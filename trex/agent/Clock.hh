@@ -95,7 +95,57 @@ namespace TREX {
       typedef transaction::graph::duration_type          duration_type;
       typedef utils::chrono_posix_convert<duration_type> dur_converter;
       typedef transaction::graph::date_type              date_type;
-      
+
+      /** @brief Tick wake-up lateness histogram
+       *
+       * Accumulates how late the clock detected each new tick compared
+       * to the exact tick boundary. Values are distributed in decimal
+       * buckets from 10us up to 100ms, the last bucket collecting
+       * everything above.
+       *
+       * @relates Clock
+       * @ingroup agent
+       */
+      class lateness_histogram {
+      public:
+        /** @brief Number of buckets */
+        static size_t const size = 6;
+
+        lateness_histogram();
+
+        /** @brief Record a lateness
+         * @param[in] late How late a tick was detected
+         *
+         * Add @p late to the histogram and make it the last lateness
+         */
+        void add(duration_type const &late);
+
+        /** @brief Last lateness
+         * @return the last lateness recorded or 0 if none
+         */
+        duration_type const &last() const {
+          return m_last;
+        }
+        /** @brief Bucket count
+         * @param[in] i A bucket index
+         * @pre @p i < size
+         * @return the number of latenesses recorded in bucket @p i
+         */
+        size_t count(size_t i) const {
+          return m_count[i];
+        }
+        /** @brief Bucket label
+         * @param[in] i A bucket index
+         * @pre @p i < size
+         * @return A short name for bucket @p i suitable as a csv column
+         */
+        static char const *label(size_t i);
+
+      private:
+        duration_type m_last;
+        size_t        m_count[size];
+      }; // TREX::agent::Clock::lateness_histogram
+
       /** @brief Destructor */
       virtual ~Clock();
       
@@ -114,6 +164,22 @@ namespace TREX {
         return std::numeric_limits<TREX::transaction::TICK>::max();
       }
       bool is_free() const;
+      /** @brief Report deliberation progress
+       *
+       * @param[in] steps number of deliberation steps executed so far 
+       *            in the current tick
+       * @param[in] pending whether some reactors still had deliberation 
+       *            work left
+       *
+       * Called by the agent as it executes deliberation steps. It can be 
+       * called several times in a tick, the last call giving the state of 
+       * deliberation when the agent stopped.
+       *
+       * @sa steps_done(size_t, bool)
+       */
+      void report_steps(size_t steps, bool pending) {
+        steps_done(steps, pending);
+      }
             
       
       /** @brief Initial tick
@@ -166,6 +232,58 @@ namespace TREX {
        * @throw ErrnoExcept An error occurred while trying to sleep
        */
       static void sleep(duration_type const &sleepDuration);
+      /** @brief Steady clock
+       *
+       * The clock used for absolute deadlines. Its epoch is the one of
+       * the posix @c CLOCK_MONOTONIC clock.
+       */
+      typedef CHRONO::steady_clock steady_clock;
+      
+      /** @brief Deadline sleep
+       * @param deadline the wake up date
+       *
+       * Make the calling process sleep until @p deadline. On platforms 
+       * supporting @c clock_nanosleep this is an absolute sleep on the 
+       * monotonic clock so interruptions or scheduling delays do not 
+       * accumulate. Other platforms fall back to the relative sleep.
+       *
+       * @throw ErrnoExcept An error occurred while trying to sleep
+       * @sa has_deadline_sleep()
+       * @sa to_steady
+       */
+      static void deadline_sleep(steady_clock::time_point const &deadline);
+      /** @brief Convert to steady_clock
+       * @param date A date
+       *
+       * Convert @p date into the steady_clock. The conversion is exact
+       * for steady_clock dates. Other clocks are converted based on 
+       * their current offset with steady_clock.
+       *
+       * @return the steady_clock date matching @p date
+       * @{
+       */
+      template<class C, class D>
+      static steady_clock::time_point to_steady(CHRONO::time_point<C, D> const &date) {
+        return steady_clock::now()+CHRONO::duration_cast<steady_clock::duration>(date-C::now());
+      }
+      static steady_clock::time_point to_steady(steady_clock::time_point const &date) {
+        return date;
+      }
+      /** @} */
+      /** @brief Check for absolute sleep support
+       * @retval true if deadline_sleep relies on absolute deadlines
+       * @retval false if it falls back to the relative sleep
+       */
+      static bool has_deadline_sleep();
+
+      /** @brief Tick lateness
+       *
+       * @return the histogram of how late new ticks were detected by
+       * this clock. Only clocks that follow real time do fill it.
+       */
+      lateness_histogram const &lateness() const {
+        return m_lateness;
+      }
       /** @brief Get tick string
        *
        * @param[in] tick A tick
@@ -210,6 +328,20 @@ namespace TREX {
       virtual size_t count() const {
         return m_count;
       }
+      /** @brief Deliberation progress
+       *
+       * @param[in] steps number of deliberation steps executed so far 
+       *            in the current tick
+       * @param[in] pending whether some reactors still had deliberation 
+       *            work left
+       *
+       * Allows clocks to base their behavior on the deliberation 
+       * actually done by the agent. The default implementation ignores 
+       * this information.
+       *
+       * @sa report_steps(size_t, bool)
+       */
+      virtual void steps_done(size_t /*steps*/, bool /*pending*/) {}
       
       
       /** @brief get time in TICK
@@ -258,7 +390,18 @@ namespace TREX {
        * relevant to have the tick variable located on this class.
        */
       void advanceTick(TREX::transaction::TICK &tick);
-      
+      /** @brief Record tick lateness
+       * @param[in] late How late the new tick was detected
+       *
+       * Called by specialized clocks when they detect a new tick to
+       * record how late it is compared to the tick boundary.
+       *
+       * @sa lateness() const
+       */
+      void record_lateness(duration_type const &late) {
+        m_lateness.add(late);
+      }
+
       utils::log::stream syslog(utils::log::id_type const &kind=utils::log::null)
       const;
       
@@ -276,7 +419,8 @@ namespace TREX {
       mutable bool               m_free;
       mutable size_t             m_free_count, m_count;
       mutable utils::async_ofstream m_data;
-      
+      lateness_histogram            m_lateness;
+
       friend class FastClock;
     }; // TREX::agent::Clock
     
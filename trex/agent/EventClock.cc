@@ -0,0 +1,111 @@
+/** @file "EventClock.cc"
+ * @brief EventClock class implementation
+ * 
+ * @ingroup agent
+ */
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ * 
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ * 
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ * 
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ * 
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "EventClock.hh"
+
+using namespace TREX::transaction;
+using namespace TREX::agent;
+using namespace TREX::utils;
+
+namespace {
+  /** @brief Clock XML factor declaration for EventClock
+   * @relates TREX::agent::EventClock
+   *
+   * This variable provides an access to the Clock XML factory
+   * to allow automatic parsing of EventClock from xml. The tag
+   * associated to this is @c "EventClock"
+   *
+   * @sa TREX::transaction::Clock::xml_factory
+   * @sa EventClock(boost::property_tree::ptree::value_type &)
+   * @ingroup agent
+   */
+  Clock::xml_factory::declare<EventClock> decl("EventClock");
+
+} // ::
+
+/*
+ * class TREX::agent::EventClock
+ */
+
+// structors :
+
+EventClock::EventClock(size_t max_steps)
+  :Clock(duration_type::zero()), m_tick(0), m_steps(0), m_pending(false),
+   m_max_steps(max_steps) {}
+
+EventClock::EventClock(boost::property_tree::ptree::value_type &node)
+  :Clock(duration_type::zero()), m_tick(0), m_steps(0), m_pending(false),
+   m_max_steps(parse_attr<size_t>(0, node, "steps")) {}
+
+// modifiers :
+
+TICK EventClock::getNextTick() {
+  return m_tick;
+}
+
+Clock::duration_type EventClock::doSleep() {
+  // only report a cut if the agent still had work when it stopped
+  if( m_pending && !free() )
+    syslog(log::debug)<<"Deliberation cut after "<<m_steps<<" steps.";
+  Clock::advanceTick(m_tick);
+  m_steps = 0;
+  m_pending = false;
+  return duration_type::zero();
+}
+
+void EventClock::steps_done(size_t steps, bool pending) {
+  m_steps = steps;
+  m_pending = pending;
+}
+
+// observers :
+
+bool EventClock::free() const {
+  return 0==m_max_steps || m_steps<m_max_steps;
+}
+
+std::string EventClock::info() const {
+  std::ostringstream oss;
+  oss<<"Event driven clock with ";
+  if( 0==m_max_steps )
+    oss<<"no limit on";
+  else 
+    oss<<"at most "<<m_max_steps;
+  oss<<" deliberation steps per tick.";
+  return oss.str();
+}
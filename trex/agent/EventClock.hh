@@ -0,0 +1,157 @@
+/* -*- C++ -*- */
+/** @file "EventClock.hh"
+ * @brief definition of an event driven pseudo clock
+ *
+ * This files defines a pseudo-clock that advances as soon as the 
+ * agent has no more deliberation to do.
+ *
+ * @ingroup agent
+ */
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ * 
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ * 
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ * 
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ * 
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef H_EventClock
+# define H_EventClock
+
+# include "Clock.hh"
+# include <trex/utils/StringExtract.hh>
+
+namespace TREX {
+  namespace agent {
+    
+    /** @brief Event driven pseudo clock
+     *
+     * This class implements a TREX clock that advances to the next tick 
+     * as soon as the agent is idle: all the pending goals were dispatched 
+     * and no reactor reports any deliberation work left. Contrary to 
+     * StepClock the number of deliberation steps is not fixed which allows 
+     * to run a simulation as fast as the reactors allow without cutting 
+     * their deliberation short.
+     *
+     * As a reactor may always report work, the number of steps per tick can 
+     * be capped. When this cap is reached the clock stops the deliberation 
+     * and advances to the next tick. The steps are counted as reported 
+     * by the agent through Clock::report_steps.
+     *
+     * @note As for StepClock, the tick duration is of 1 second. This clock
+     * can be used as the base of a FastClock to give it a different 
+     * epoch and tick duration.
+     *
+     * @ingroup agent
+     */
+    class EventClock :public Clock {
+    public:
+      /** @brief Constructor
+       * @param[in] max_steps maximum number of steps per tick
+       *
+       * Create a new instance allowing @p max_steps deliberation 
+       * steps per tick. A value of 0 puts no limit to deliberation.
+       */
+      explicit EventClock(size_t max_steps=0);
+      /** @brief XML parsing constructor
+       * @param node A XML clock definition
+       *
+       * Create a new instance based on the constent of @a node.
+       * The expected structure of node is 
+       * @code
+       * <EventClock steps="<number>"/>
+       * @endcode
+       *
+       * where the optional @c @<number@> is the maximum number of 
+       * deliberation steps per tick. If not given, or 0, deliberation 
+       * is not limited.
+       *
+       * @throw TREX::utils::bad_string_cast unable to parse @c steps attribute
+       */
+      explicit EventClock(boost::property_tree::ptree::value_type &node);
+      /** @brief Destructor */
+      ~EventClock() {}
+
+      /** @brief Maximum steps per tick
+       * @return the maximum number of steps allowed in a tick or 0 
+       * if unlimited
+       */
+      size_t max_steps() const {
+        return m_max_steps;
+      }
+
+      std::string info() const;
+
+    private:
+      /** @brief get current tick date
+       * @return current tick date
+       */
+      TREX::transaction::TICK getNextTick();
+      /** @brief Check if clock is free
+       *
+       * @retval true if the number of steps reported by the agent for 
+       *         the current tick did not reach max_steps()
+       * @retval false otherwise
+       */
+      bool free() const;
+      /** @brief Deliberation progress
+       *
+       * @param[in] steps number of steps executed in the current tick
+       * @param[in] pending whether deliberation work was left
+       *
+       * Records the steps the agent executed and whether it had more 
+       * work to do.
+       */
+      void steps_done(size_t steps, bool pending);
+      /** @brief Advance to the next tick
+       *
+       * The agent only sleeps when it has no more deliberation to do 
+       * or when the clock is not free anymore. This clock reacts by 
+       * advancing immediately to the next tick.
+       *
+       * @return 0
+       */
+      duration_type doSleep();
+      duration_type getSleepDelay() const {
+        return duration_type::zero();
+      }
+
+      /** @brief current tick date */
+      TREX::transaction::TICK m_tick;
+      /** @brief steps executed in the current tick */
+      size_t                  m_steps;
+      /** @brief deliberation work left flag */
+      bool                    m_pending;
+      /** @brief maximum allowed number of steps per tick */
+      size_t const            m_max_steps;
+    }; // TREX::agent::EventClock
+
+  } // TREX::agent 
+} // TREX
+
+#endif // H_EventClock
@@ -62,6 +62,10 @@ namespace TREX {
         return m_clock->count();
       }
       
+      void steps_done(size_t steps, bool pending) {
+        m_clock->steps_done(steps, pending);
+      }
+      
       duration_type doSleep() {
         return m_clock->doSleep(); // not sure if I need to convert to warped time
       }
@@ -37,6 +37,8 @@
 
 #include <boost/date_time/posix_time/posix_time_io.hpp>
 
+#include <sstream>
+
 
 using namespace TREX::agent;
 using namespace TREX::transaction;
@@ -65,59 +67,153 @@ LogClock::tick_info::tick_info(bpt::ptree::value_type const &node)
 // structors
 
 LogClock::LogClock(bpt::ptree::value_type &node) 
-  :Clock(Clock::duration_type::zero()) {
+  :Clock(Clock::duration_type::zero()), 
+   m_start(parse_attr<TICK>(0, node, "start")),
+   m_prefetch(parse_attr<size_t>(64, node, "prefetch")) {
   // find the log to replay
   SingletonUse<LogManager> log;
-  std::string file = parse_attr<std::string>("clock.xml", node, "file");
+  m_file = parse_attr<std::string>("clock.xml", node, "file");
   bool found;
-  file = log->use(file, found);
+  std::string located = log->use(m_file, found);
+  if( !found ) // the log may have been compressed
+    located = log->use(m_file+".gz", found);
   if( !found )
-    throw XmlError(node, "Unable to locate file \""+file+"\"");
+    throw XmlError(node, "Unable to locate file \""+m_file+"\"");
+  m_file = located;
+  if( 0==m_prefetch )
+    throw XmlError(node, "prefetch should be at least 1.");
+  m_log.open(m_file);
+  if( !m_log )
+    throw XmlError(node, "Unable to open file \""+m_file+"\"");
+  m_size = m_log.rdbuf()->disk_size();
+  
+  // the header is everything before the first tick
+  std::string header, elt;
   bpt::ptree tks;
-  // parse the log
-  read_xml(file, tks, xml::no_comments|xml::trim_whitespace);
-  if( tks.empty() ) {
-    syslog(error)<<"clock log \""<<file<<"\" is empty.";
-    throw XmlError(node, "Empty clock log file.");
+  bool has_tick = false;
+  
+  m_data = m_log.tellg();
+  while( next_element(elt) ) {
+    if( parse_tick(elt, tks) ) {
+      has_tick = true;
+      break;
+    }
+    header += elt;
+    m_data = m_log.tellg();
   }
-  if( tks.size()!=1 ) {
-    syslog(error)<<"clock log \""<<file<<"\" has more than 1 root.";
-    throw XmlError(node, "Invalid clock log file");
+  if( std::string::npos==header.find('<') ) {
+    syslog(error)<<"clock log \""<<m_file<<"\" is empty.";
+    throw XmlError(node, "Empty clock log file.");
   }
-  tks = tks.get_child("Clock");
-  m_period = Clock::duration_type(parse_attr<Clock::duration_type::rep>(tks, "rate"));
+  if( has_tick )
+    header += "</Clock>";
+  std::istringstream iss(header);
+  bpt::ptree hdr;
+  read_xml(iss, hdr, xml::no_comments|xml::trim_whitespace);
+  hdr = hdr.get_child("Clock");
+  m_period = Clock::duration_type(parse_attr<Clock::duration_type::rep>(hdr, "rate"));
   try {
-    m_epoch = parse_attr<Clock::date_type>(tks, "epoch");
+    m_epoch = parse_attr<Clock::date_type>(hdr, "epoch");
   } catch(utils::bad_string_cast const &e) {
     Clock::duration_type dur(m_period);
-    dur *= parse_attr<unsigned>(tks, "epoch");
+    dur *= parse_attr<unsigned>(hdr, "epoch");
     typedef utils::chrono_posix_convert<Clock::duration_type> cvt;
     m_epoch = boost::posix_time::from_time_t(0);
     m_epoch += cvt::to_posix(dur);
   }
-  bpt::ptree::assoc_iterator i, last;
-  boost::tie(i, last) = tks.equal_range("tick");
-  boost::optional<transaction::TICK> prev;
-  for(; last!=i; ++i) {
-    tick_info tck(*i);
-    if( tck.count>0 ) {
-      if( prev ) {
-        if( tck.date > 1+(*prev) )
-          syslog(warn)<<"Missing tick(s) between "<<(*prev)<<" and "<<tck.date;
-      }
-      prev = tck.date;
-      m_ticks.push_back(tck);
-    } else
-      syslog(warn)<<"Skipping tick "<<tck.date<<" with 0 count.";
+  if( has_tick ) {
+    if( parse_attr<TICK>(tks.front(), "value")<m_start )
+      seek(m_start);
+    else {
+      m_log.clear();
+      m_log.seekg(m_data, std::ios::beg);
+    }
   }
-  if( m_ticks.empty() )
+  if( !fetch() )
     throw XmlError(node, "clock log has no valid tick.");
 }
 
 // manipulators
 
-TICK LogClock::getNextTick() {
+bool LogClock::next_element(std::string &elt) {
+  if( !std::getline(m_log, elt, '>') )
+    return false;
+  if( !m_log.eof() )
+    elt.push_back('>');
+  return true;
+}
+
+bool LogClock::parse_tick(std::string const &elt, bpt::ptree &pt) {
+  size_t pos = elt.find_first_not_of(" \t\r\n");
+  
+  if( std::string::npos==pos || 0!=elt.compare(pos, 5, "<tick") )
+    return false;
+  std::istringstream iss(elt.substr(pos));
+  pt.clear();
+  read_xml(iss, pt, xml::no_comments|xml::trim_whitespace);
+  return !pt.empty();
+}
+
+void LogClock::seek(TICK tck) {
+  // the element at lo is always the first tick or a tick before tck
+  std::streamoff lo = m_data, hi = m_size;
+  std::string elt;
+  bpt::ptree pt;
+  
+  // a compressed log can only be scanned: fetch will skip all the ticks
+  // before tck
+  if( !m_log.rdbuf()->seekable() )
+    hi = lo;
+  while( hi-lo>256 ) {
+    std::streamoff mid = lo+(hi-lo)/2, pos;
+    
+    m_log.clear();
+    m_log.seekg(mid, std::ios::beg);
+    // skip the end of the element mid falls into
+    if( next_element(elt) && !m_log.eof() ) {
+      pos = m_log.tellg();
+      if( next_element(elt) && parse_tick(elt, pt) &&
+          parse_attr<TICK>(pt.front(), "value")<tck ) {
+        lo = pos;
+        continue;
+      }
+    }
+    hi = mid;
+  }
+  // fetch will skip the few ticks before tck left
+  m_log.clear();
+  m_log.seekg(lo, std::ios::beg);
+  syslog(TREX::utils::log::info)<<"Skipped clock log ticks before "<<tck;
+}
+
+bool LogClock::fetch() {
   if( m_ticks.empty() ) {
+    std::string elt;
+    bpt::ptree pt;
+    
+    while( m_ticks.size()<m_prefetch && next_element(elt) ) {
+      if( parse_tick(elt, pt) ) {
+        tick_info tck(pt.front());
+        
+        if( tck.date<m_start )
+          continue;
+        if( tck.count>0 ) {
+          if( m_prev ) {
+            if( tck.date > 1+(*m_prev) )
+              syslog(warn)<<"Missing tick(s) between "<<(*m_prev)<<" and "<<tck.date;
+          }
+          m_prev = tck.date;
+          m_ticks.push_back(tck);
+        } else
+          syslog(warn)<<"Skipping tick "<<tck.date<<" with 0 count.";
+      }
+    }
+  }
+  return !m_ticks.empty();
+}
+
+TICK LogClock::getNextTick() {
+  if( !fetch() ) {
     syslog(error)<<"no more tick to play.";
     throw Clock::Error("clock has no more tick to play.");
   } 
@@ -134,7 +230,7 @@ TICK LogClock::getNextTick() {
     TICK expected = tck.date+1, next;
 
     m_ticks.pop_front();
-    if( m_ticks.empty() )
+    if( !fetch() )
       throw Clock::Error("LogClock has no more tick to play");
     next = m_ticks.front().date;
 
@@ -161,8 +257,10 @@ bool LogClock::free() const {
 
 std::string LogClock::info() const {
   std::ostringstream oss;
-  oss<<"LogClock with "<<m_ticks.size();
-  display(oss<<" ticks to play\n\tsimulated tick period: ", m_period);
+  oss<<"LogClock replaying \""<<m_file<<'"';
+  if( m_start>0 )
+    oss<<" from tick "<<m_start;
+  display(oss<<"\n\tsimulated tick period: ", m_period);
   return oss.str();
 }
 
@@ -36,6 +36,10 @@
 
 # include "Clock.hh"
 
+# include <trex/utils/log_ifstream.hh>
+
+# include <boost/optional.hpp>
+
 namespace TREX {
   namespace agent {
   
@@ -47,6 +51,23 @@ namespace TREX {
      * This cock allow to accurately replay a mission by giving as many atomic 
      * call steps for each tcj as it really occured during the replayed mission.
      *
+     * The XML format is:
+     * @code
+     * <LogClock file="<file>" start="<tick>" prefetch="<n>" />
+     * @endcode
+     * Where:
+     * @li @c file is the clock log to replay (default @c clock.xml). 
+     *     If it does not exist its compressed version @c file.gz is 
+     *     used instead.
+     * @li @c start is an optional tick from which the replay starts. 
+     *     The ticks before it are skipped by a binary search over the 
+     *     file, so they are never parsed. A compressed log is scanned 
+     *     instead.
+     * @li @c prefetch is the number of ticks loaded from the file at 
+     *     once (default @c 64)
+     *
+     * The ticks are read lazily from the log as the replay progress.
+     *
      * @author Frederic Py <fpy@mbari.org>
      * @ingroup agent
      */
@@ -78,9 +99,59 @@ namespace TREX {
         size_t const free_count;
       }; // TREX::agent::LogClock::tick_info
       
+      /** @brief Read next element
+       *
+       * @param[out] elt The element text
+       *
+       * Extract the next XML element from the log
+       *
+       * @retval true if an element was read
+       * @retval false if the end of the file was reached
+       */
+      bool next_element(std::string &elt);
+      /** @brief Parse a tick
+       *
+       * @param[in] elt An element text as extracted by next_element
+       * @param[out] pt The parsed element
+       *
+       * @retval true if @p elt is a tick element
+       * @retval false otherwise
+       */
+      static bool parse_tick(std::string const &elt,
+                             boost::property_tree::ptree &pt);
+      /** @brief Jump to a tick
+       *
+       * @param[in] tck A tick
+       *
+       * Do a binary search on the log in order to move the reading 
+       * position before the first log entry of @p tck. When the log is 
+       * not seekable the reading position is just reset to the first 
+       * tick
+       */
+      void seek(TREX::transaction::TICK tck);
+      /** @brief Prefetch ticks
+       *
+       * Load up to @c m_prefetch new ticks from the log if the tick 
+       * buffer is empty
+       *
+       * @retval true if the buffer is not empty
+       * @retval false if there's no more tick to play
+       */
+      bool fetch();
+      
       date_type     m_epoch;
       duration_type m_period;
       std::list<tick_info> m_ticks;
+      
+      std::string   m_file;
+      TREX::utils::log_ifstream m_log;
+      /** @brief Offset of the first tick in the log */
+      std::streamoff m_data;
+      /** @brief Size of the log file on disk */
+      std::streamoff m_size;
+      TREX::transaction::TICK m_start;
+      size_t m_prefetch;
+      boost::optional<TREX::transaction::TICK> m_prev;
       // size_t m_counter;
       
       // TREX::transaction::TICK m_last;
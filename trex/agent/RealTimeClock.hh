@@ -106,14 +106,17 @@ namespace TREX {
       /** @brief Constructor
        *
        * @param[in] period The tick period
+       * @param[in] percent_use Percentage of the tick allowed for deliberation
+       * @param[in] deadline Sleep on absolute tick deadlines
        *
        * Create a new clock with a tick duration of @p period where the unit 
        * of @p period is @t Period
        *
        * @{
        */
-      explicit rt_clock(rep const &period, unsigned percent_use=100)
-        :Clock(duration_type::zero()), m_period(period) {
+      explicit rt_clock(rep const &period, unsigned percent_use=100,
+                        bool deadline=false)
+        :Clock(duration_type::zero()), m_period(period), m_deadline(deadline) {
         check_tick();
         if( percent_use<5 || percent_use>100 )
           throw utils::Exception("Only accept clock percent_use between 5 and 100%");
@@ -121,8 +124,9 @@ namespace TREX {
         m_sleep_watchdog /= 100;
       }
       
-      explicit rt_clock(tick_rate const &period, unsigned percent_use=100)
-        :Clock(duration_type::zero()), m_period(period) {
+      explicit rt_clock(tick_rate const &period, unsigned percent_use=100,
+                        bool deadline=false)
+        :Clock(duration_type::zero()), m_period(period), m_deadline(deadline) {
         check_tick();
         if( percent_use<5 || percent_use>100 )
           throw utils::Exception("Only accept clock percent_use between 5 and 100%");
@@ -146,6 +150,15 @@ namespace TREX {
        *  <ClockName minutes="2" seconds="20" micros="20000" /> 
        * @endcode
        * All attributes on either definition are expected to be integer.
+       *
+       * The optional boolean attribute @c deadline makes the clock sleep
+       * until the exact date of the next tick boundary instead of a 
+       * relative delay (see Clock::deadline_sleep) which reduces the 
+       * wake up jitter of high frequency clocks. It is only effective 
+       * when the base clock @p Clk is steady:
+       * @code
+       *  <ClockName millis="50" deadline="1" />
+       * @endcode
        */  
       explicit rt_clock(boost::property_tree::ptree::value_type &node) 
         :Clock(duration_type::zero()) {
@@ -212,6 +225,9 @@ namespace TREX {
           m_period = CHRONO::duration_cast<tick_rate>(ns_tick);
         } 
         check_tick();
+        m_deadline = utils::parse_attr<bool>(false, node, "deadline");
+        if( m_deadline && !clock_type::is_steady )
+          syslog(warn)<<"Deadline sleep disabled as the base clock is not steady.";
         unsigned sleep_ratio = utils::parse_attr<unsigned>(100, node, "percent_use");
         if( sleep_ratio<5 || sleep_ratio>100 )
           throw utils::Exception("Only accept clock precent_use between 5 and 100%");
@@ -342,6 +358,13 @@ namespace TREX {
           oss<<hz<<"Hz ("<<x_den<<'/'<<x_num<<')';
         }
         utils::display(oss<<"\n\tsleep timer:", m_sleep_watchdog);
+        if( m_deadline ) {
+          oss<<"\n\tsleep mode: ";
+          if( !clock_type::is_steady )
+            oss<<"relative (base clock is not steady)";
+          else
+            oss<<(has_deadline_sleep()?"absolute deadline":"relative (no deadline support)");
+        }
         return oss.str();
       }
       
@@ -357,7 +380,14 @@ namespace TREX {
       transaction::TICK getNextTick() {
         typename mutex_type::scoped_lock guard(m_lock);
         if( NULL!=m_clock.get() ) {
+          typename clock_type::time_point prev = m_tick;
           typename clock_type::base_duration how_late = m_clock->to_next(m_tick, m_period);
+          if( prev!=m_tick ) {
+            // lateness relative to the boundary of the tick we entered
+            typename clock_type::base_duration late = how_late;
+            late -= CHRONO::duration_cast<typename clock_type::base_duration>((m_tick-prev)-m_period);
+            record_lateness(CHRONO::duration_cast<duration_type>(late));
+          }
           if( how_late >=clock_type::base_duration::zero() ) {
             double ratio = CHRONO::duration_cast< CHRONO::duration<double, Period> >(how_late).count();
             ratio /= m_period.count();
@@ -389,8 +419,36 @@ namespace TREX {
       }
       
       duration_type doSleep() {
+        if( deadline_mode() && NULL!=m_clock.get() ) {
+          duration_type delay = getSleepDelay();
+          if( delay>duration_type::zero() ) {
+            typename clock_type::base_time_point target;
+            {
+              typename mutex_type::scoped_lock guard(m_lock);
+              // sleep until the next tick boundary instead of delay from 
+              // now so the time spent since it was computed is not added
+              target = m_clock->epoch();
+              target += CHRONO::duration_cast<typename clock_type::base_duration>((m_tick+m_period).time_since_epoch());
+            }
+            deadline_sleep(to_steady(target));
+          }
+          return delay;
+        }
         return Clock::doSleep();
       }
+      
+      /** @brief Check for deadline sleep
+       *
+       * The tick boundaries are dates of the base clock which can only
+       * be converted once into a monotonic deadline if this clock is 
+       * steady. Otherwise the clock falls back to relative sleeps.
+       *
+       * @retval true if the clock sleeps on absolute tick deadlines
+       * @retval false otherwise
+       */
+      bool deadline_mode() const {
+        return m_deadline && clock_type::is_steady;
+      }
 
       duration_type getSleepDelay() const {
         typename mutex_type::scoped_lock guard(m_lock);
@@ -423,6 +481,7 @@ namespace TREX {
       
       mutable mutex_type   m_lock;
       tick_rate            m_period;
+      bool                 m_deadline;
       UNIQ_PTR<clock_type> m_clock;
       date_type            m_epoch;
       
@@ -0,0 +1,599 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file core_bench.cc
+ * @brief Core data types micro-benchmarks
+ *
+ * This program measures the cost of the basic operations on the core
+ * TREX types:
+ * @li @c symbol construction, comparison and hashing
+ * @li @c observation and @c goal construction, copy and attribute lookup
+ * @li @c interval and @c enumerated domains intersection and restriction
+ * @li @c goal temporal restriction
+ * @li @c xml and @c json round-trip of a goal through ptree_io
+ * @li @c async_ofstream entries throughput
+ * @li @c priority_strand post and dequeue
+ *
+ * Each benchmark is run with an increasing number of iterations until
+ * it lasts at least the requested minimum time and the result is then
+ * averaged over a number of repetitions. The results are reported
+ * either as a table or as JSON -- following the layout of Google
+ * Benchmark so existing tools can compare the output of two releases.
+ *
+ * Usage:
+ * @code
+ * core_bench [options]
+ * @endcode
+ */
+#include <trex/transaction/Goal.hh>
+#include <trex/transaction/Observation.hh>
+#include <trex/domain/FloatDomain.hh>
+#include <trex/domain/StringDomain.hh>
+#include <trex/utils/asio_fstream.hh>
+#include <trex/utils/asio_runner.hh>
+#include <trex/utils/chrono_helper.hh>
+#include <trex/utils/cpu_clock.hh>
+#include <trex/utils/priority_strand.hh>
+#include <trex/utils/ptree_io.hh>
+#include <trex/utils/TREXversion.hh>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/program_options.hpp>
+
+using namespace TREX::utils;
+using namespace TREX::transaction;
+
+namespace po=boost::program_options;
+namespace bpt=boost::property_tree;
+
+namespace {
+
+  typedef CHRONO::high_resolution_clock bench_clock;
+
+  /** @brief Optimization barrier
+   *
+   * The benchmarks accumulate the results of the operations they
+   * measure in this variable so the compiler cannot discard them.
+   */
+  size_t volatile sink = 0;
+
+  /** @brief Benchmark function
+   *
+   * A benchmark takes a number of iterations and executes the operation
+   * it measures this number of times.
+   */
+  typedef void (*bench_fn)(size_t);
+
+  struct bench_case {
+    char const *name;
+    bench_fn    fn;
+  };
+
+  struct result {
+    std::string name;
+    size_t      iterations;
+    double      real_ns, cpu_ns;
+  };
+
+  /*
+   * Data shared by the benchmarks, built once before any of them runs
+   */
+  size_t const pool_size = 64;
+
+  std::vector<std::string> names;
+  std::vector<Symbol>      symbols;
+  std::vector<Symbol>      attrs;
+
+  Observation *ref_obs = NULL;
+  Goal        *ref_goal = NULL;
+
+  IntegerDomain *int_a = NULL, *int_b = NULL;
+  FloatDomain   *flt_a = NULL, *flt_b = NULL;
+  StringDomain  *str_a = NULL, *str_b = NULL;
+
+  asio_runner *runner = NULL;
+
+
+  void fill(Predicate &p) {
+    for(size_t i=0; i<attrs.size(); ++i)
+      p.restrictAttribute(Variable(attrs[i], IntegerDomain(i)));
+  }
+
+  void setup() {
+    for(size_t i=0; i<pool_size; ++i) {
+      std::ostringstream oss;
+      oss<<"timeline_"<<i;
+      names.push_back(oss.str());
+      symbols.push_back(Symbol(names.back()));
+    }
+    for(size_t i=0; i<4; ++i) {
+      std::ostringstream oss;
+      oss<<"attr_"<<i;
+      attrs.push_back(Symbol(oss.str()));
+    }
+
+    ref_obs = new Observation(symbols[0], symbols[1]);
+    fill(*ref_obs);
+    ref_goal = new Goal(symbols[0], symbols[1]);
+    fill(*ref_goal);
+    ref_goal->restrictTime(IntegerDomain(0, 100), IntegerDomain(1, 10),
+                           IntegerDomain(5, 120));
+
+    int_a = new IntegerDomain(0, 100);
+    int_b = new IntegerDomain(50, 150);
+    flt_a = new FloatDomain(0.0, 100.0);
+    flt_b = new FloatDomain(50.0, 150.0);
+
+    std::vector<std::string> vals;
+    for(size_t i=0; i<8; ++i)
+      vals.push_back(names[i]);
+    str_a = new StringDomain(vals.begin(), vals.end());
+    str_b = new StringDomain(vals.begin()+4, vals.end());
+
+    runner = new asio_runner(1);
+  }
+
+  void teardown() {
+    delete runner;
+    delete str_b;
+    delete str_a;
+    delete flt_b;
+    delete flt_a;
+    delete int_b;
+    delete int_a;
+    delete ref_goal;
+    delete ref_obs;
+  }
+
+  /*
+   * Symbol
+   */
+  void symbol_construct(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      Symbol s(names[i%pool_size]);
+      sink += s.id();
+    }
+  }
+
+  void symbol_copy(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      Symbol s(symbols[i%pool_size]);
+      sink += s.id();
+    }
+  }
+
+  void symbol_equal(size_t n) {
+    for(size_t i=0; i<n; ++i)
+      sink += (symbols[i%pool_size]==symbols[(i*7)%pool_size]);
+  }
+
+  void symbol_less(size_t n) {
+    for(size_t i=0; i<n; ++i)
+      sink += (symbols[i%pool_size]<symbols[(i*7)%pool_size]);
+  }
+
+  // same hash as used by boost::unordered containers
+  void symbol_hash(size_t n) {
+    boost::hash<Symbol> hash;
+    for(size_t i=0; i<n; ++i)
+      sink += hash(symbols[i%pool_size]);
+  }
+
+  /*
+   * Predicates
+   */
+  void observation_construct(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      Observation obs(symbols[i%pool_size], symbols[1]);
+      fill(obs);
+      sink += obs.object().id();
+    }
+  }
+
+  void observation_copy(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      Observation obs(*ref_obs);
+      sink += obs.object().id();
+    }
+  }
+
+  void observation_lookup(size_t n) {
+    for(size_t i=0; i<n; ++i)
+      sink += ref_obs->hasAttribute(attrs[i%attrs.size()]);
+  }
+
+  void goal_construct(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      Goal g(symbols[i%pool_size], symbols[1]);
+      fill(g);
+      sink += g.object().id();
+    }
+  }
+
+  void goal_copy(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      Goal g(*ref_goal);
+      sink += g.object().id();
+    }
+  }
+
+  void goal_lookup(size_t n) {
+    for(size_t i=0; i<n; ++i)
+      sink += ref_goal->getAttribute(attrs[i%attrs.size()]).isComplete();
+  }
+
+  void goal_restrict_time(size_t n) {
+    Goal ref(symbols[0], symbols[1]);
+    IntegerDomain const s(10, 50), d(1, 5), e(11, 60);
+
+    for(size_t i=0; i<n; ++i) {
+      Goal g(ref);
+      g.restrictTime(s, d, e);
+      sink += g.object().id();
+    }
+  }
+
+  /*
+   * Domains
+   *
+   * The restriction is applied on a copy of the reference domain, the
+   * cost of this copy is therefore included.
+   */
+  void integer_intersect(size_t n) {
+    for(size_t i=0; i<n; ++i)
+      sink += int_a->intersect(*int_b);
+  }
+
+  void integer_restrict(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      IntegerDomain tmp(*int_a);
+      tmp.restrictWith(*int_b);
+      sink += tmp.isSingleton();
+    }
+  }
+
+  void float_intersect(size_t n) {
+    for(size_t i=0; i<n; ++i)
+      sink += flt_a->intersect(*flt_b);
+  }
+
+  void float_restrict(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      FloatDomain tmp(*flt_a);
+      tmp.restrictWith(*flt_b);
+      sink += tmp.isSingleton();
+    }
+  }
+
+  void enumerated_intersect(size_t n) {
+    for(size_t i=0; i<n; ++i)
+      sink += str_a->intersect(*str_b);
+  }
+
+  void enumerated_restrict(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      StringDomain tmp(str_a->begin(), str_a->end());
+      tmp.restrictWith(*str_b);
+      sink += tmp.isSingleton();
+    }
+  }
+
+  /*
+   * ptree_io round-trip: the goal is serialized then parsed back into
+   * a new goal
+   */
+  void xml_roundtrip(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      std::ostringstream out;
+      ref_goal->to_xml(out);
+
+      std::istringstream in(out.str());
+      bpt::ptree tree;
+      read_xml(in, tree);
+      Goal g(tree.front());
+      sink += g.object().id();
+    }
+  }
+
+  void json_roundtrip(size_t n) {
+    for(size_t i=0; i<n; ++i) {
+      std::ostringstream out;
+      ref_goal->to_json(out);
+
+      std::istringstream in(out.str());
+      bpt::ptree tree;
+      read_json(in, tree);
+      Goal g(tree.front());
+      sink += g.object().id();
+    }
+  }
+
+  /*
+   * async_ofstream: each entry is a short csv line similar to the
+   * reactors stat.csv. The file is flushed at the end so the timing
+   * includes the writing of all the entries.
+   */
+  void ofstream_entry(size_t n) {
+    async_ofstream out(runner->service(), "/dev/null");
+
+    for(size_t i=0; i<n; ++i) {
+      async_ofstream::entry e = out.new_entry();
+      e.stream()<<i<<", "<<(0.5*i)<<", "<<symbols[i%pool_size]<<'\n';
+    }
+    out.flush();
+    out.close();
+  }
+
+  /*
+   * priority_strand: post tasks with various priorities and wait for
+   * all of them to be dequeued and executed
+   */
+  size_t bump() {
+    return ++sink;
+  }
+
+  void strand_post(size_t n) {
+    priority_strand strand(runner->service());
+
+    for(size_t i=1; i<n; ++i)
+      strand.send(&bump, i%8);
+    strand.post(&bump).get();
+  }
+
+  void strand_post_future(size_t n) {
+    priority_strand strand(runner->service());
+    std::vector< boost::shared_future<size_t> > results;
+
+    results.reserve(n);
+    for(size_t i=0; i<n; ++i)
+      results.push_back(strand.post(&bump, i%8));
+    for(size_t i=0; i<n; ++i)
+      results[i].get();
+  }
+
+  bench_case const cases[] = {
+    { "symbol/construct", &symbol_construct },
+    { "symbol/copy", &symbol_copy },
+    { "symbol/equal", &symbol_equal },
+    { "symbol/less", &symbol_less },
+    { "symbol/hash", &symbol_hash },
+    { "observation/construct", &observation_construct },
+    { "observation/copy", &observation_copy },
+    { "observation/lookup", &observation_lookup },
+    { "goal/construct", &goal_construct },
+    { "goal/copy", &goal_copy },
+    { "goal/lookup", &goal_lookup },
+    { "goal/restrict_time", &goal_restrict_time },
+    { "integer/intersect", &integer_intersect },
+    { "integer/restrict", &integer_restrict },
+    { "float/intersect", &float_intersect },
+    { "float/restrict", &float_restrict },
+    { "enumerated/intersect", &enumerated_intersect },
+    { "enumerated/restrict", &enumerated_restrict },
+    { "ptree_io/xml_roundtrip", &xml_roundtrip },
+    { "ptree_io/json_roundtrip", &json_roundtrip },
+    { "async_ofstream/entry", &ofstream_entry },
+    { "priority_strand/post", &strand_post },
+    { "priority_strand/post_future", &strand_post_future }
+  };
+  size_t const n_cases = sizeof(cases)/sizeof(bench_case);
+
+  /** @brief Time a benchmark
+   *
+   * @param[in] fn A benchmark
+   * @param[in] n The number of iterations
+   * @param[out] real The wall clock time spent
+   *
+   * @return the cpu time spent
+   */
+  cpu_clock::duration time(bench_fn fn, size_t n,
+                           bench_clock::duration &real) {
+    cpu_clock::duration cpu;
+    {
+      chronograph<cpu_clock> c_chron(cpu);
+      chronograph<bench_clock> r_chron(real);
+
+      fn(n);
+    }
+    return cpu;
+  }
+
+  double ns(bench_clock::duration const &d) {
+    return static_cast<double>(CHRONO::duration_cast<CHRONO::nanoseconds>(d).count());
+  }
+
+  /** @brief Run a benchmark
+   *
+   * @param[in] b The benchmark
+   * @param[in] min_time The minimum duration of a run in seconds
+   * @param[in] reps The number of repetitions
+   *
+   * Find the number of iterations needed for @p b to last at least
+   * @p min_time and then execute it @p reps times with this number
+   * of iterations.
+   *
+   * @return the average time per iteration
+   */
+  result run(bench_case const &b, double min_time, size_t reps) {
+    size_t const max_iter = 1000000000;
+    double const target = 1e9*min_time;
+    bench_clock::duration real;
+    size_t n = 1;
+    result ret;
+
+    ret.name = b.name;
+    // calibration
+    while( true ) {
+      time(b.fn, n, real);
+      double elapsed = ns(real);
+
+      if( elapsed>=target || n>=max_iter )
+        break;
+      size_t next = 10*n;
+      if( elapsed>0.0 ) {
+        // aim slightly above target to avoid another calibration round
+        double guess = 1.4*n*target/elapsed;
+        if( guess<next )
+          next = static_cast<size_t>(guess)+1;
+      }
+      n = std::min(std::max(next, n+1), max_iter);
+    }
+
+    double real_ns = 0.0, cpu_ns = 0.0;
+    for(size_t i=0; i<reps; ++i) {
+      cpu_ns += CHRONO::duration_cast<CHRONO::nanoseconds>(time(b.fn, n, real)).count();
+      real_ns += ns(real);
+    }
+    ret.iterations = n;
+    ret.real_ns = real_ns/(reps*n);
+    ret.cpu_ns = cpu_ns/(reps*n);
+    return ret;
+  }
+
+  std::string json_str(std::string const &s) {
+    std::string ret("\"");
+    for(std::string::const_iterator i=s.begin(); s.end()!=i; ++i) {
+      if( '"'==*i || '\\'==*i )
+        ret += '\\';
+      ret += *i;
+    }
+    return ret+'"';
+  }
+
+  void print_json(std::ostream &out, std::vector<result> const &res,
+                  double min_time, size_t reps) {
+    out<<"{\n  \"context\": {\n"
+    <<"    \"date\": \""
+    <<boost::posix_time::to_iso_extended_string(boost::posix_time::second_clock::universal_time())
+    <<"Z\",\n"
+    <<"    \"executable\": \"core_bench\",\n"
+    <<"    \"trex_version\": "<<json_str(TREX::version::full_str())<<",\n"
+    <<"    \"min_time\": "<<min_time<<",\n"
+    <<"    \"repetitions\": "<<reps<<"\n"
+    <<"  },\n  \"benchmarks\": [";
+    for(size_t i=0; i<res.size(); ++i) {
+      out<<(i?",\n":"\n")<<"    {\n"
+      <<"      \"name\": "<<json_str(res[i].name)<<",\n"
+      <<"      \"iterations\": "<<res[i].iterations<<",\n"
+      <<std::fixed<<std::setprecision(2)
+      <<"      \"real_time\": "<<res[i].real_ns<<",\n"
+      <<"      \"cpu_time\": "<<res[i].cpu_ns<<",\n"
+      <<"      \"time_unit\": \"ns\"\n    }";
+    }
+    out<<"\n  ]\n}"<<std::endl;
+  }
+
+  void print_table(std::ostream &out, std::vector<result> const &res) {
+    out<<std::setw(30)<<std::left<<"benchmark"<<std::right
+    <<std::setw(14)<<"real (ns)"<<std::setw(14)<<"cpu (ns)"
+    <<std::setw(14)<<"iterations"<<'\n'
+    <<std::fixed<<std::setprecision(1);
+    for(size_t i=0; i<res.size(); ++i)
+      out<<std::setw(30)<<std::left<<res[i].name<<std::right
+      <<std::setw(14)<<res[i].real_ns<<std::setw(14)<<res[i].cpu_ns
+      <<std::setw(14)<<res[i].iterations<<'\n';
+    out.flush();
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+  po::options_description opt("Usage: core_bench [options]\n\nAllowed options");
+
+  opt.add_options()
+  ("help,h", "Print this message and exit")
+  ("list,l", "List the available benchmarks and exit")
+  ("filter,f", po::value<std::string>()->default_value(""),
+   "Only run the benchmarks whose name contains this string")
+  ("min-time,m", po::value<double>()->default_value(0.2),
+   "Minimum duration of a run in seconds")
+  ("repetitions,n", po::value<size_t>()->default_value(3),
+   "Number of runs averaged for each benchmark")
+  ("json,j", "Print the results as JSON")
+  ("output,o", po::value<std::string>(), "Write the JSON results in the given file");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, opt), vm);
+    po::notify(vm);
+  } catch(po::error const &e) {
+    std::cerr<<e.what()<<'\n'<<opt<<std::endl;
+    return 1;
+  }
+  if( vm.count("help") ) {
+    std::cout<<opt<<std::endl;
+    return 0;
+  }
+  if( vm.count("list") ) {
+    for(size_t i=0; i<n_cases; ++i)
+      std::cout<<cases[i].name<<'\n';
+    return 0;
+  }
+
+  std::string const filter = vm["filter"].as<std::string>();
+  double const min_time = vm["min-time"].as<double>();
+  size_t reps = vm["repetitions"].as<size_t>();
+
+  if( 0==reps )
+    reps = 1;
+
+  setup();
+
+  std::vector<result> res;
+  for(size_t i=0; i<n_cases; ++i)
+    if( std::string(cases[i].name).find(filter)!=std::string::npos )
+      res.push_back(run(cases[i], min_time, reps));
+
+  teardown();
+
+  if( vm.count("output") ) {
+    std::ofstream out(vm["output"].as<std::string>().c_str());
+    if( !out ) {
+      std::cerr<<"Failed to open "<<vm["output"].as<std::string>()<<std::endl;
+      return 1;
+    }
+    print_json(out, res, min_time, reps);
+  }
+  if( vm.count("json") )
+    print_json(std::cout, res, min_time, reps);
+  else
+    print_table(std::cout, res);
+  return 0;
+}
@@ -0,0 +1,221 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file edf_bench.cc
+ * @brief Deliberation scheduling micro-benchmark
+ *
+ * This program compares the overhead per deliberation step of the agent 
+ * scheduling strategies as the number of reactors grows:
+ * @li @c legacy is the former approach where the ready reactors were 
+ *     stored in a multimap and all the idle reactors were polled after 
+ *     each step.
+ * @li @c indexed is the current approach where ready reactors are 
+ *     stored in an indexed heap which priority is updated after each 
+ *     step while idle reactors are only evaluated when notified (none of
+ *     the simulated reactors opts in for polling).
+ *
+ * The reactors used here are only simulating the calls made by the 
+ * agent and do no actual deliberation which allows to isolate the 
+ * scheduling cost.
+ *
+ * Usage:
+ * @code
+ * edf_bench [ticks [active [steps]]]
+ * @endcode
+ */
+#include <trex/utils/indexed_heap.hh>
+#include <trex/utils/chrono_helper.hh>
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+
+using namespace TREX::utils;
+
+namespace {
+  
+  typedef CHRONO::high_resolution_clock bench_clock;
+  
+  /** @brief Simulated reactor
+   *
+   * A reactor that needs to deliberate a given number of steps per tick. 
+   * Its workRatio mimics the cost of a real reactor: it locks a mutex -- 
+   * as TeleoReactor does for its pending goals -- before evaluating 
+   * if it has work to do.
+   */
+  class fake_reactor {
+  public:
+    fake_reactor():m_steps(0), m_done(0) {}
+    fake_reactor(fake_reactor const &other)
+    :m_steps(other.m_steps), m_done(other.m_done) {}
+    
+    void new_tick(size_t steps) {
+      m_steps = steps;
+      m_done = 0;
+    }
+    
+    double workRatio() {
+      boost::mutex::scoped_lock lock(m_mtx);
+      if( m_done<m_steps )
+        return 1.0/(m_done+1);
+      return NAN;
+    }
+    void step() {
+      ++m_done;
+    }
+  private:
+    size_t m_steps, m_done;
+    boost::mutex m_mtx;
+  };
+  
+  typedef fake_reactor *reactor_id;
+  
+  size_t legacy(std::vector<fake_reactor> &reactors) {
+    std::multimap<double, reactor_id, std::greater<double> > edf;
+    std::list<reactor_id> idle;
+    size_t count = 0;
+    
+    for(std::vector<fake_reactor>::iterator i=reactors.begin();
+        reactors.end()!=i; ++i) {
+      double wr = i->workRatio();
+      if( std::isnan(wr) )
+        idle.push_front(&*i);
+      else
+        edf.insert(std::make_pair(wr, &*i));
+    }
+    while( !edf.empty() ) {
+      reactor_id r = edf.begin()->second;
+      edf.erase(edf.begin());
+      idle.push_back(r);
+      r->step();
+      ++count;
+      
+      for(std::list<reactor_id>::iterator i=idle.begin(); idle.end()!=i; ) {
+        double wr = (*i)->workRatio();
+        if( std::isnan(wr) )
+          ++i;
+        else {
+          edf.insert(std::make_pair(wr, *i));
+          i = idle.erase(i);
+        }
+      }
+    }
+    return count;
+  }
+  
+  size_t indexed(std::vector<fake_reactor> &reactors) {
+    indexed_heap<double, reactor_id> edf;
+    size_t count = 0;
+    
+    for(std::vector<fake_reactor>::iterator i=reactors.begin();
+        reactors.end()!=i; ++i) {
+      double wr = i->workRatio();
+      if( !std::isnan(wr) )
+        edf.push(&*i, wr);
+    }
+    while( !edf.empty() ) {
+      reactor_id r = edf.top();
+      r->step();
+      ++count;
+      
+      double wr = r->workRatio();
+      if( std::isnan(wr) )
+        edf.erase(r);
+      else
+        edf.push(r, wr);
+    }
+    return count;
+  }
+  
+  double run(size_t (*sched)(std::vector<fake_reactor> &),
+             size_t n_reactors, size_t active, size_t steps, size_t ticks) {
+    std::vector<fake_reactor> reactors(n_reactors);
+    bench_clock::duration total = bench_clock::duration::zero(), delta;
+    size_t count = 0, stride = n_reactors/active;
+    
+    for(size_t t=0; t<ticks; ++t) {
+      // spread the active reactors among the idle ones
+      for(size_t i=0; i<n_reactors; ++i) {
+        bool busy = (0==i%stride) && (i/stride)<active;
+        reactors[i].new_tick(busy?steps:0);
+      }
+      {
+        chronograph<bench_clock> chron(delta);
+        count += sched(reactors);
+      }
+      total += delta;
+    }
+    return static_cast<double>(CHRONO::duration_cast<CHRONO::nanoseconds>(total).count())/count;
+  }
+  
+}
+
+int main(int argc, char *argv[]) {
+  size_t ticks = 100, active = 4, steps = 50;
+  
+  try {
+    if( argc>1 )
+      ticks = boost::lexical_cast<size_t>(argv[1]);
+    if( argc>2 )
+      active = boost::lexical_cast<size_t>(argv[2]);
+    if( argc>3 )
+      steps = boost::lexical_cast<size_t>(argv[3]);
+  } catch(boost::bad_lexical_cast const &e) {
+    std::cerr<<"Usage: "<<argv[0]<<" [ticks [active [steps]]]"<<std::endl;
+    return 1;
+  }
+  if( 0==active )
+    active = 1;
+  
+  size_t const sizes[] = { 5, 10, 20, 50, 100, 200, 500, 1000 };
+  
+  std::cout<<ticks<<" ticks with "<<active<<" reactors deliberating "
+  <<steps<<" steps per tick\n\n"
+  <<std::setw(10)<<"reactors"<<std::setw(18)<<"legacy (ns/step)"
+  <<std::setw(18)<<"indexed (ns/step)"<<std::endl;
+  for(size_t i=0; i<sizeof(sizes)/sizeof(size_t); ++i) {
+    if( sizes[i]<active )
+      continue;
+    std::cout<<std::setw(10)<<sizes[i]
+    <<std::setw(18)<<std::fixed<<std::setprecision(1)
+    <<run(&legacy, sizes[i], active, steps, ticks)
+    <<std::setw(18)<<run(&indexed, sizes[i], active, steps, ticks)<<std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file log_bench.cc
+ * @brief syslog throughput benchmark
+ *
+ * This program measures how many log entries per second a text_log 
+ * can absorb when 1, 4 or 8 threads produce messages concurrently. 
+ * The entries are written to a file by an out_file handler -- as done 
+ * for TREX.log -- and the time includes the dispatch of all of them.
+ *
+ * It also reports the throughput of messages rejected by the 
+ * verbosity level, which should not be formatted at all.
+ *
+ * Usage:
+ * @code
+ * log_bench [messages] [file]
+ * @endcode
+ * Where @c messages is the number of messages per thread and @c file 
+ * the log output (@c /dev/null by default)
+ */
+#include <trex/utils/asio_runner.hh>
+#include <trex/utils/chrono_helper.hh>
+#include <trex/utils/log/text_log.hh>
+#include <trex/utils/log/out_file.hh>
+
+#include <iomanip>
+#include <iostream>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace TREX::utils;
+
+namespace {
+  
+  typedef CHRONO::high_resolution_clock bench_clock;
+  
+  log::id_type const source("bench");
+  
+  /** @brief Producer thread
+   *
+   * @param[in] dest The log
+   * @param[in] kind The kind of the messages
+   * @param[in] n The number of messages
+   * @param[in] start Starting barrier
+   */
+  void produce(log::text_log &dest, log::id_type const &kind, size_t n,
+               boost::barrier &start) {
+    start.wait();
+    for(size_t i=0; i<n; ++i)
+      dest(i, source, kind)<<"Observation "<<i<<" of "<<n
+      <<" with a value of "<<(0.5*i);
+  }
+  
+  /** @brief Run a benchmark
+   *
+   * @param[in] dest The log
+   * @param[in] kind The kind of the messages
+   * @param[in] threads The number of producers
+   * @param[in] n The number of messages per producer
+   *
+   * @return the number of entries per second
+   */
+  double run(log::text_log &dest, log::id_type const &kind,
+             size_t threads, size_t n) {
+    boost::barrier start(threads+1);
+    boost::thread_group producers;
+    bench_clock::duration delta;
+    
+    for(size_t i=0; i<threads; ++i)
+      producers.create_thread(boost::bind(&produce, boost::ref(dest),
+                                          boost::cref(kind), n,
+                                          boost::ref(start)));
+    {
+      chronograph<bench_clock> chron(delta);
+      
+      start.wait();
+      producers.join_all();
+      dest.flush();
+    }
+    return (threads*n)/(1e-9*CHRONO::duration_cast<CHRONO::nanoseconds>(delta).count());
+  }
+  
+}
+
+int main(int argc, char *argv[]) {
+  size_t n = 100000;
+  std::string file("/dev/null");
+  
+  try {
+    if( argc>1 )
+      n = boost::lexical_cast<size_t>(argv[1]);
+    if( argc>2 )
+      file = argv[2];
+  } catch(boost::bad_lexical_cast const &e) {
+    std::cerr<<"Usage: "<<argv[0]<<" [messages] [file]"<<std::endl;
+    return 1;
+  }
+  if( 0==n )
+    n = 1;
+  
+  asio_runner runner(1);
+  log::text_log dest(runner.service());
+  log::out_file out(file);
+  size_t const threads[] = { 1, 4, 8 };
+  
+  dest.direct_connect(log::text_log::slot_type(out));
+  
+  std::cout<<n<<" messages per thread\n\n"
+  <<std::setw(10)<<"threads"<<std::setw(20)<<"logged (entry/s)"
+  <<std::setw(20)<<"rejected (entry/s)"<<std::endl;
+  for(size_t i=0; i<3; ++i) {
+    std::cout<<std::setw(10)<<threads[i]
+    <<std::setw(20)<<std::fixed<<std::setprecision(0)
+    <<run(dest, log::info, threads[i], n)
+    <<std::setw(20)<<run(dest, log::debug, threads[i], n)<<std::endl;
+  }
+  return 0;
+}
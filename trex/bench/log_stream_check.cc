@@ -0,0 +1,165 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file log_stream_check.cc
+ * @brief LogPlayer streaming reader check
+ *
+ * This program checks the tick index of the reader used by LogPlayer 
+ * in streaming mode:
+ * @li an index saved for a log is reloaded as long as the log is 
+ *     unchanged
+ * @li an index left by a previous version of the log is detected as 
+ *     stale so it can be rebuilt
+ * @li seeking to a start tick resumes the replay on the first tick 
+ *     which is not before it.
+ *
+ * Usage:
+ * @code
+ * log_stream_check [dir]
+ * @endcode
+ * Where @c dir is the directory where the test log is written (the 
+ * system temporary directory by default). The program returns 0 when 
+ * all the checks succeed.
+ */
+#include <trex/transaction/private/log_stream.hh>
+
+#include <fstream>
+#include <iostream>
+
+#include <boost/filesystem/operations.hpp>
+
+using namespace TREX::transaction;
+
+namespace fs=boost::filesystem;
+
+namespace {
+  
+  /** @brief Write a test log
+   *
+   * @param[in] file The log file
+   * @param[in] last The last tick
+   *
+   * Write a log with every other tick from 0 to @p last
+   */
+  void write_log(std::string const &file, TICK last) {
+    std::ofstream out(file.c_str());
+    
+    out<<"<Log>\n <header>\n   <provide name=\"robot\" goals=\"1\" plan=\"0\" />\n"
+    <<" </header>\n";
+    for(TICK t=0; t<=last; t+=2)
+      out<<" <tick value=\""<<t<<"\">  <synchronize>\n"
+      <<"<!-- <tick value=\"-1\"> in a comment -->\n"
+      <<"   <Observation on=\"robot\" pred=\"At\"/>\n"
+      <<"  </synchronize>\n </tick>\n";
+    out<<"</Log>\n";
+  }
+  
+  bool check(bool cond, char const *msg) {
+    if( !cond )
+      std::cerr<<"log_stream: "<<msg<<std::endl;
+    return cond;
+  }
+  
+  TICK tick_of(details::log_stream::ptree const &pt) {
+    return pt.front().second.get<TICK>("<xmlattr>.value");
+  }
+  
+}
+
+int main(int argc, char *argv[]) {
+  fs::path dir = (argc>1)?fs::path(argv[1]):fs::temp_directory_path();
+  std::string const log = (dir/fs::unique_path("trex-%%%%-%%%%.tr.log")).string(),
+    index = log+".idx";
+  bool ok = true;
+  
+  try {
+    details::log_stream::ptree pt;
+    
+    write_log(log, 10);
+    {
+      details::log_stream in(log);
+      
+      ok = check(in.header(pt), "header not found") && ok;
+      in.build_index();
+      ok = check(in.save_index(index), "failed to save the index") && ok;
+      ok = check(in.next(pt) && 0==tick_of(pt),
+                 "building the index moved the reader") && ok;
+    }
+    {
+      details::log_stream in(log);
+      
+      in.header(pt);
+      ok = check(in.load_index(index), "valid index not reloaded") && ok;
+      in.seek_tick(4);
+      ok = check(in.next(pt) && 4==tick_of(pt),
+                 "seek to an indexed tick") && ok;
+      ok = check(in.next(pt) && 6==tick_of(pt),
+                 "tick following the seek") && ok;
+    }
+    // the log gets longer: its former index is now stale
+    write_log(log, 20);
+    {
+      details::log_stream in(log);
+      
+      in.header(pt);
+      ok = check(!in.load_index(index), "stale index was loaded") && ok;
+      in.build_index();
+      ok = check(in.save_index(index), "failed to save the new index") && ok;
+    }
+    {
+      details::log_stream in(log);
+      
+      in.header(pt);
+      ok = check(in.load_index(index), "rebuilt index not reloaded") && ok;
+      in.seek_tick(15);
+      ok = check(in.next(pt) && 16==tick_of(pt),
+                 "seek between two ticks") && ok;
+    }
+    {
+      details::log_stream in(log);
+      
+      in.header(pt);
+      in.build_index();
+      in.seek_tick(21);
+      ok = check(!in.next(pt), "seek after the last tick") && ok;
+    }
+  } catch(std::exception const &e) {
+    std::cerr<<"Unexpected exception: "<<e.what()<<std::endl;
+    ok = false;
+  }
+  fs::remove(log);
+  fs::remove(index);
+  std::cout<<(ok?"log_stream checks passed":"log_stream checks FAILED")
+  <<std::endl;
+  return ok?0:1;
+}
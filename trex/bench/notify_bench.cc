@@ -0,0 +1,201 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file notify_bench.cc
+ * @brief External observations notification micro-benchmark
+ *
+ * This program compares the per tick cost for a reactor to collect the 
+ * new observations of its @e External timelines when only a fraction of 
+ * them is updated every tick:
+ * @li @c scan is the former approach where the reactor visited all its 
+ *     @e External timelines and checked the date of their last 
+ *     observation.
+ * @li @c push is the current approach where each updated timeline 
+ *     pushes itself into the updated list of its clients which is the 
+ *     only one visited by the reactor.
+ *
+ * Timelines are simulated which isolates the cost of the notification 
+ * from the rest of the synchronization.
+ *
+ * Usage:
+ * @code
+ * notify_bench [ticks [timelines [rate]]]
+ * @endcode
+ */
+#include <trex/utils/id_mapper.hh>
+#include <trex/utils/Symbol.hh>
+#include <trex/utils/chrono_helper.hh>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+using namespace TREX::utils;
+
+namespace {
+  
+  typedef CHRONO::high_resolution_clock bench_clock;
+  
+  /** @brief Simulated timeline
+   *
+   * A timeline with its last observation and the date it was posted
+   */
+  struct fake_timeline {
+    typedef fake_timeline base_type;
+    typedef Symbol        id_type;
+    
+    static id_type const &get_id(base_type const &tl) {
+      return tl.name;
+    }
+    
+    Symbol name;
+    long   date;
+    long   obs;
+  };
+  
+  typedef pointer_id_traits<fake_timeline> tl_traits;
+  typedef list_set<tl_traits>              tl_set;
+  typedef std::vector<fake_timeline *>     tl_list;
+  
+  /** @brief Run a benchmark
+   *
+   * @param[in] timelines The @e External timelines of the reactor
+   * @param[in] updates The timelines updated at each tick
+   * @param[in] push Use the push strategy
+   *
+   * Simulate the observation posting and notification of all the ticks 
+   * of @p updates.
+   *
+   * @return the average cost per tick in nanoseconds
+   */
+  double run(std::vector<fake_timeline> &timelines,
+             std::vector< std::vector<size_t> > const &updates,
+             bool push) {
+    tl_set externals;
+    tl_list updated;
+    id_cmp<tl_traits> cmp((std::less<Symbol>()));
+    std::vector<long> notified;
+    size_t count = 0;
+    
+    for(std::vector<fake_timeline>::iterator i=timelines.begin();
+        timelines.end()!=i; ++i) {
+      i->date = -1;
+      externals.insert(&*i);
+    }
+    
+    bench_clock::duration delta;
+    {
+      chronograph<bench_clock> chron(delta);
+      
+      for(long now=0; static_cast<size_t>(now)<updates.size(); ++now) {
+        // timeline synchronization
+        for(std::vector<size_t>::const_iterator i=updates[now].begin();
+            updates[now].end()!=i; ++i) {
+          fake_timeline &tl = timelines[*i];
+          tl.date = now;
+          tl.obs += 1;
+          if( push )
+            updated.push_back(&tl);
+        }
+        // reactor notification
+        if( push ) {
+          if( updated.size()>1 ) {
+            std::sort(updated.begin(), updated.end(), cmp);
+            updated.erase(std::unique(updated.begin(), updated.end()), 
+                          updated.end());
+          }
+          for(tl_list::const_iterator i=updated.begin(); updated.end()!=i; ++i)
+            if( (*i)->date==now )
+              notified.push_back((*i)->obs);
+          updated.clear();
+        } else {
+          for(tl_set::const_iterator i=externals.begin(); externals.end()!=i; ++i)
+            if( (*i)->date==now )
+              notified.push_back((*i)->obs);
+        }
+        count += notified.size();
+        notified.clear();
+      }
+    }
+    if( 0==count )
+      std::cerr<<"No observation notified"<<std::endl;
+    return static_cast<double>(CHRONO::duration_cast<CHRONO::nanoseconds>(delta).count())/updates.size();
+  }
+  
+}
+
+int main(int argc, char *argv[]) {
+  size_t ticks = 10000, n_timelines = 200;
+  double rate = 0.05;
+  
+  try {
+    if( argc>1 )
+      ticks = boost::lexical_cast<size_t>(argv[1]);
+    if( argc>2 )
+      n_timelines = boost::lexical_cast<size_t>(argv[2]);
+    if( argc>3 )
+      rate = boost::lexical_cast<double>(argv[3]);
+  } catch(boost::bad_lexical_cast const &e) {
+    std::cerr<<"Usage: "<<argv[0]<<" [ticks [timelines [rate]]]"<<std::endl;
+    return 1;
+  }
+  
+  std::vector<fake_timeline> timelines(n_timelines);
+  for(size_t i=0; i<n_timelines; ++i) {
+    std::ostringstream oss;
+    oss<<"tl_"<<i;
+    timelines[i].name = Symbol(oss.str());
+    timelines[i].obs = 0;
+  }
+  
+  // same update pattern for both strategies
+  std::vector< std::vector<size_t> > updates(ticks);
+  std::srand(0);
+  for(size_t t=0; t<ticks; ++t)
+    for(size_t i=0; i<n_timelines; ++i)
+      if( std::rand()<rate*RAND_MAX )
+        updates[t].push_back(i);
+  
+  std::cout<<ticks<<" ticks with "<<n_timelines<<" External timelines and "
+  <<(rate*100.0)<<"% updated per tick\n\n"
+  <<std::setw(18)<<"scan (ns/tick)"<<std::setw(18)<<"push (ns/tick)"<<std::endl;
+  std::cout<<std::setw(18)<<std::fixed<<std::setprecision(1)
+  <<run(timelines, updates, false)
+  <<std::setw(18)<<run(timelines, updates, true)<<std::endl;
+  return 0;
+}
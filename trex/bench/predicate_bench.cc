@@ -0,0 +1,168 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file predicate_bench.cc
+ * @brief Predicate attributes storage micro-benchmark
+ *
+ * This program compares the cost of the operations done on the 
+ * attributes of a predicate for two storage strategies:
+ * @li @c map is the former approach where attributes were stored in a 
+ *     @c std::map indexed by their name
+ * @li @c flat is the current approach where attributes are stored in a 
+ *     sorted flat_map with the first 4 of them inline
+ *
+ * For each strategy we measure the time to build a predicate by adding 
+ * its attributes one by one, to copy it and to look for each of its 
+ * attributes by name.
+ *
+ * Usage:
+ * @code
+ * predicate_bench [iterations [attributes]]
+ * @endcode
+ */
+#include <trex/utils/flat_map.hh>
+#include <trex/utils/chrono_helper.hh>
+#include <trex/domain/Variable.hh>
+#include <trex/domain/IntegerDomain.hh>
+
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+using namespace TREX::utils;
+using TREX::transaction::Variable;
+using TREX::transaction::IntegerDomain;
+
+namespace {
+  
+  typedef CHRONO::high_resolution_clock bench_clock;
+  
+  typedef std::map<Symbol, Variable>   map_set;
+  typedef flat_map<Symbol, Variable, 4> flat_set;
+  
+  struct result {
+    double construct, copy, lookup;
+  };
+  
+  // same insertion pattern as Predicate::restrictAttribute
+  template<class Set>
+  void build(Set &s, std::vector<Variable> const &vars) {
+    for(std::vector<Variable>::const_iterator i=vars.begin(); vars.end()!=i; ++i) {
+      typename Set::iterator pos = s.lower_bound(i->name());
+      if( s.end()!=pos && i->name()==pos->first )
+        pos->second.restrict(*i);
+      else
+        s.insert(pos, std::make_pair(i->name(), *i));
+    }
+  }
+  
+  double ns(bench_clock::duration const &d, size_t n) {
+    return static_cast<double>(CHRONO::duration_cast<CHRONO::nanoseconds>(d).count())/n;
+  }
+  
+  template<class Set>
+  result run(std::vector<Variable> const &vars, size_t iter) {
+    bench_clock::duration delta;
+    result ret;
+    size_t found = 0;
+    
+    {
+      chronograph<bench_clock> chron(delta);
+      for(size_t i=0; i<iter; ++i) {
+        Set s;
+        build(s, vars);
+      }
+    }
+    ret.construct = ns(delta, iter);
+    
+    Set ref;
+    build(ref, vars);
+    {
+      chronograph<bench_clock> chron(delta);
+      for(size_t i=0; i<iter; ++i) {
+        Set s(ref);
+        found += s.size();
+      }
+    }
+    ret.copy = ns(delta, iter);
+    
+    {
+      chronograph<bench_clock> chron(delta);
+      for(size_t i=0; i<iter; ++i)
+        for(std::vector<Variable>::const_iterator v=vars.begin(); vars.end()!=v; ++v)
+          if( ref.end()!=ref.find(v->name()) )
+            ++found;
+    }
+    ret.lookup = ns(delta, iter*vars.size());
+    // make sure the compiler does not optimize the loops away
+    if( 0==found )
+      std::cerr<<"No attribute found"<<std::endl;
+    return ret;
+  }
+  
+}
+
+int main(int argc, char *argv[]) {
+  size_t iter = 100000, n_attrs = 4;
+  
+  try {
+    if( argc>1 )
+      iter = boost::lexical_cast<size_t>(argv[1]);
+    if( argc>2 )
+      n_attrs = boost::lexical_cast<size_t>(argv[2]);
+  } catch(boost::bad_lexical_cast const &e) {
+    std::cerr<<"Usage: "<<argv[0]<<" [iterations [attributes]]"<<std::endl;
+    return 1;
+  }
+  
+  std::vector<Variable> vars;
+  for(size_t i=0; i<n_attrs; ++i) {
+    std::ostringstream oss;
+    oss<<"attr_"<<i;
+    vars.push_back(Variable(Symbol(oss.str()), IntegerDomain(i)));
+  }
+  
+  result m = run<map_set>(vars, iter), f = run<flat_set>(vars, iter);
+  
+  std::cout<<iter<<" predicates with "<<n_attrs<<" attributes\n\n"
+  <<std::setw(18)<<" "<<std::setw(12)<<"map (ns)"<<std::setw(12)<<"flat (ns)"<<'\n'
+  <<std::fixed<<std::setprecision(1)
+  <<std::setw(18)<<"construct"<<std::setw(12)<<m.construct<<std::setw(12)<<f.construct<<'\n'
+  <<std::setw(18)<<"copy"<<std::setw(12)<<m.copy<<std::setw(12)<<f.copy<<'\n'
+  <<std::setw(18)<<"lookup"<<std::setw(12)<<m.lookup<<std::setw(12)<<f.lookup<<std::endl;
+  return 0;
+}
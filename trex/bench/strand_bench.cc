@@ -0,0 +1,198 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file strand_bench.cc
+ * @brief strand_run micro-benchmark
+ *
+ * This program measures the cost of a synchronous call through 
+ * utils::strand_run in the two situations the agent hits every tick:
+ * @li @c outside the caller is not running in the strand and has to 
+ *     wait for another thread to execute the call
+ * @li @c inside the caller is already executing a handler of this 
+ *     strand.
+ * 
+ * For each situation it compares the former implementation -- which 
+ * always created a packaged_task and its future -- against the current 
+ * one using either a boost::function or directly the boost::bind 
+ * functor.
+ *
+ * Usage:
+ * @code
+ * strand_bench [calls]
+ * @endcode
+ */
+#include <trex/utils/asio_runner.hh>
+#include <trex/utils/chrono_helper.hh>
+
+#include <iomanip>
+#include <iostream>
+
+#include <boost/lexical_cast.hpp>
+
+using namespace TREX::utils;
+
+namespace {
+  
+  typedef CHRONO::high_resolution_clock bench_clock;
+  
+  /** @brief Former strand_run implementation
+   *
+   * Kept here as a reference point 
+   */
+  template<class Service, typename Ret>
+  Ret legacy_run(Service &s, boost::function<Ret ()> const &f) {
+    boost::packaged_task<Ret> tsk(f);
+    boost::unique_future<Ret> result = tsk.get_future();
+    
+    s.dispatch(boost::bind(&boost::packaged_task<Ret>::operator(),
+                           boost::ref(tsk)));
+    return result.get();
+  }
+  
+  size_t incr(size_t &val) {
+    return ++val;
+  }
+  
+  enum method {
+    legacy,
+    function,
+    functor
+  };
+  
+  /** @brief Benchmark loop
+   *
+   * @param[in] s The strand
+   * @param[in] m The strand_run flavor to use
+   * @param[in] calls The number of calls
+   *
+   * Execute @p calls synchronous calls on @p s using @p m
+   *
+   * @return the average cost of a call in nanoseconds
+   */
+  double loop(boost::asio::strand &s, method m, size_t calls) {
+    size_t val = 0;
+    bench_clock::duration delta;
+    {
+      chronograph<bench_clock> chron(delta);
+      
+      for(size_t i=0; i<calls; ++i) {
+        switch( m ) {
+          case legacy:
+            {
+              boost::function<size_t ()> fn(boost::bind(&incr, boost::ref(val)));
+              legacy_run(s, fn);
+            }
+            break;
+          case function:
+            {
+              boost::function<size_t ()> fn(boost::bind(&incr, boost::ref(val)));
+              strand_run(s, fn);
+            }
+            break;
+          default:
+            strand_run(s, boost::bind(&incr, boost::ref(val)));
+        }
+      }
+    }
+    return static_cast<double>(CHRONO::duration_cast<CHRONO::nanoseconds>(delta).count())/calls;
+  }
+  
+  void inside(boost::asio::strand &s, method m, size_t calls, double &ret) {
+    ret = loop(s, m, calls);
+  }
+  
+  void check_fast_path(boost::asio::strand &s, bool &ret) {
+    ret = details::running_in(s);
+  }
+  
+  /** @brief Run a benchmark
+   *
+   * @param[in] s The strand
+   * @param[in] m The strand_run flavor to use
+   * @param[in] calls The number of calls
+   * @param[in] in_strand Indicates if the calls are made from a 
+   *   handler of @p s
+   *
+   * @return the average cost of a call in nanoseconds
+   */
+  double run(boost::asio::strand &s, method m, size_t calls, bool in_strand) {
+    if( in_strand ) {
+      double ret;
+      boost::function<void ()> fn(boost::bind(&inside, boost::ref(s), m, 
+                                              calls, boost::ref(ret)));
+      legacy_run(s, fn);
+      return ret;
+    } else 
+      return loop(s, m, calls);
+  }
+  
+}
+
+int main(int argc, char *argv[]) {
+  size_t calls = 100000;
+  
+  try {
+    if( argc>1 )
+      calls = boost::lexical_cast<size_t>(argv[1]);
+  } catch(boost::bad_lexical_cast const &e) {
+    std::cerr<<"Usage: "<<argv[0]<<" [calls]"<<std::endl;
+    return 1;
+  }
+  if( 0==calls )
+    calls = 1;
+  
+  asio_runner runner(1);
+  boost::asio::strand s(runner.service());
+  char const *names[] = { "legacy", "function", "functor" };
+  bool fast = false;
+  boost::function<void ()> check(boost::bind(&check_fast_path, boost::ref(s),
+                                             boost::ref(fast)));
+  
+  legacy_run(s, check);
+  if( !fast ) {
+    std::cerr<<"strand_run does not detect calls made from the strand"
+    <<std::endl;
+    return 1;
+  }
+  
+  std::cout<<calls<<" calls\n\n"
+  <<std::setw(10)<<"method"<<std::setw(20)<<"outside (ns/call)"
+  <<std::setw(20)<<"inside (ns/call)"<<std::endl;
+  for(int m=legacy; m<=functor; ++m) {
+    std::cout<<std::setw(10)<<names[m]
+    <<std::setw(20)<<std::fixed<<std::setprecision(1)
+    <<run(s, static_cast<method>(m), calls, false)
+    <<std::setw(20)<<run(s, static_cast<method>(m), calls, true)<<std::endl;
+  }
+  return 0;
+}
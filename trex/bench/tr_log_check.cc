@@ -0,0 +1,193 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file tr_log_check.cc
+ * @brief Binary transaction log round trip check
+ *
+ * This program checks that a log written by tr_log::binary_writer is 
+ * read back by tr_log::binary_reader as the same XML log the 
+ * tr_log::xml_writer produces from the same transactions:
+ * @li a record type unknown to the reader is skipped
+ * @li a record larger than details::max_record_size is rejected as a 
+ *     corrupted log.
+ *
+ * Usage:
+ * @code
+ * tr_log_check
+ * @endcode
+ * The program returns 0 when all the checks succeed.
+ */
+#include <trex/transaction/TransactionLog.hh>
+#include <trex/domain/IntegerDomain.hh>
+#include <trex/domain/FloatDomain.hh>
+#include <trex/domain/StringDomain.hh>
+
+#include <iostream>
+#include <sstream>
+
+#include <boost/property_tree/xml_parser.hpp>
+
+using namespace TREX::transaction;
+using TREX::utils::Symbol;
+
+namespace {
+  
+  /** @brief Write a sample log
+   *
+   * @param[in] out A log writer
+   * @param[in] unknown A stream where an unknown record is inserted in 
+   *   the middle of the log or NULL
+   *
+   * Write the same transactions into @p out whatever its format
+   */
+  void sample(tr_log::writer &out, std::ostream *unknown) {
+    Observation obs(Symbol("robot"), Symbol("At"));
+    obs.restrictAttribute(Variable(Symbol("x"), IntegerDomain(-3, 12)));
+    obs.restrictAttribute(Variable(Symbol("speed"), FloatDomain(0.5)));
+    obs.restrictAttribute(Variable(Symbol("name"), StringDomain("home")));
+    goal_id g(new Goal(Symbol("robot"), Symbol("Go")));
+    g->restrictAttribute(Variable(Symbol("x"), IntegerDomain(7)));
+    
+    out.open();
+    out.provide(Symbol("robot"), true, false);
+    out.use(Symbol("sensor"), false, true);
+    out.latency(2);
+    out.end_header();
+    for(TICK t=0; t<3; ++t) {
+      out.open_tick(t);
+      out.open_phase(tr_log::in_synchronize);
+      out.observation(obs);
+      out.close_phase(tr_log::in_synchronize);
+      if( 1==t && NULL!=unknown ) {
+        // length, a type code no version uses and 2 bytes of payload
+        unknown->put(3);
+        unknown->put(static_cast<char>(0x7f));
+        unknown->put('a');
+        unknown->put('b');
+      }
+      out.open_phase(tr_log::in_work);
+      out.work(1==t);
+      out.goal(tr_log::request, g);
+      out.goal(tr_log::recall, g);
+      out.comment("tick done");
+      out.close_phase(tr_log::in_work);
+      out.close_tick();
+    }
+    out.unuse(Symbol("sensor"));
+    out.close();
+  }
+  
+  boost::property_tree::ptree parse(std::string const &xml) {
+    boost::property_tree::ptree ret;
+    std::istringstream in(xml);
+    read_xml(in, ret);
+    return ret;
+  }
+  
+  bool round_trip() {
+    std::ostringstream ref_xml, bin, xml;
+    
+    {
+      tr_log::xml_writer ref(ref_xml);
+      sample(ref, NULL);
+    }
+    {
+      tr_log::binary_writer writer(bin);
+      sample(writer, &bin);
+    }
+    std::istringstream in(bin.str());
+    tr_log::binary_reader reader(in);
+    tr_log::xml_writer out(xml);
+    
+    // as for trlog2xml the log opening is left to the caller
+    out.open();
+    reader.convert(out);
+    if( parse(ref_xml.str())!=parse(xml.str()) ) {
+      std::cerr<<"round trip: converted log differs from the XML log\n"
+      <<"expected:\n"<<ref_xml.str()<<"\ngot:\n"<<xml.str()<<std::endl;
+      return false;
+    }
+    return true;
+  }
+  
+  bool oversized() {
+    std::ostringstream bin;
+    
+    {
+      tr_log::binary_writer writer(bin);
+      writer.open();
+    }
+    // a complete record of an unknown type just above the limit: it 
+    // would be silently skipped if its length was not checked
+    size_t const len = tr_log::details::max_record_size+1;
+    
+    for(size_t val=len; ; val >>= 7) {
+      if( val<0x80 ) {
+        bin.put(static_cast<char>(val));
+        break;
+      }
+      bin.put(static_cast<char>(0x80|(val&0x7f)));
+    }
+    bin.put(static_cast<char>(0x7f));
+    bin<<std::string(len-1, 'x');
+    
+    std::istringstream in(bin.str());
+    std::ostringstream xml;
+    tr_log::binary_reader reader(in);
+    tr_log::xml_writer out(xml);
+    
+    try {
+      reader.next(out);
+    } catch(tr_log::bad_format const &) {
+      return true;
+    }
+    std::cerr<<"oversized: a record larger than max_record_size was accepted"
+    <<std::endl;
+    return false;
+  }
+  
+}
+
+int main(int, char *[]) {
+  bool ok = true;
+  
+  try {
+    ok = round_trip() && ok;
+    ok = oversized() && ok;
+  } catch(std::exception const &e) {
+    std::cerr<<"Unexpected exception: "<<e.what()<<std::endl;
+    ok = false;
+  }
+  std::cout<<(ok?"tr_log checks passed":"tr_log checks FAILED")<<std::endl;
+  return ok?0:1;
+}
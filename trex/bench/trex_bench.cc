@@ -0,0 +1,373 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file trex_bench.cc
+ * @brief Synthetic reactor graph benchmark
+ *
+ * This program builds an agent made of synthetic reactors -- provided by 
+ * the @c synthetic plug-in -- with a configurable graph shape and load, 
+ * executes it with a simulated clock and reports as JSON:
+ * @li the number of ticks per second
+ * @li the time spent in each phase of the agent as reported by its 
+ *     @c agent_stats.csv
+ * @li the same statistics for each reactor from their @c stat.csv
+ *
+ * The reactors are named @c r0 to @c r<n-1> and reactor @c ri only uses 
+ * timelines of reactors with a greater index which guarantees the graph 
+ * has no cycle. The @e External timelines of a reactor are evenly spread 
+ * among the ones available which means that the fan-out of the last 
+ * reactors is smaller than requested.
+ *
+ * Usage:
+ * @code
+ * trex_bench [options]
+ * @endcode
+ * The plug-in @c synthetic_pg has to be in the TREX search path.
+ */
+#include <trex/agent/Agent.hh>
+#include <trex/agent/EventClock.hh>
+#include <trex/agent/FastClock.hh>
+#include <trex/agent/StepClock.hh>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <boost/program_options.hpp>
+#include <boost/tokenizer.hpp>
+
+using namespace TREX::agent;
+using namespace TREX::utils;
+
+namespace po=boost::program_options;
+namespace bpt=boost::property_tree;
+
+namespace {
+  
+  typedef CHRONO::high_resolution_clock bench_clock;
+  
+  /** @brief Benchmark parameters */
+  struct bench_params {
+    size_t reactors, timelines, fanout;
+    size_t observations, goals, steps, cost;
+    size_t ticks, clock_steps;
+    size_t sync_threads, delib_threads;
+    std::string clock;
+    bool tr_log;
+  };
+  
+  /** @brief Reactor name
+   * @param[in] i A reactor index
+   * @return the name of the reactor @p i
+   */
+  std::string reactor_name(size_t i) {
+    std::ostringstream oss;
+    oss<<'r'<<i;
+    return oss.str();
+  }
+  
+  /** @brief Build the agent configuration
+   *
+   * @param[in] p The benchmark parameters
+   *
+   * @return the XML definition of the synthetic agent described by @p p
+   */
+  bpt::ptree make_config(bench_params const &p) {
+    bpt::ptree root;
+    bpt::ptree &agent = root.add("Agent", "");
+    
+    agent.put("<xmlattr>.name", "bench");
+    agent.put("<xmlattr>.finalTick", p.ticks);
+    agent.put("<xmlattr>.sync_threads", p.sync_threads);
+    agent.put("<xmlattr>.delib_threads", p.delib_threads);
+    
+    bpt::ptree &plugin = agent.add("Plugin", "");
+    plugin.put("<xmlattr>.name", "synthetic_pg");
+    
+    for(size_t i=0; i<p.reactors; ++i) {
+      bpt::ptree &r = plugin.add("Synthetic", "");
+      std::ostringstream uses;
+      // Candidates are all the timelines of the reactors after i
+      size_t const n_cand = (p.reactors-1-i)*p.timelines;
+      size_t const n_uses = std::min(p.fanout, n_cand);
+      
+      for(size_t f=0; f<n_uses; ++f) {
+        size_t idx = (f*n_cand)/n_uses;
+        if( f>0 )
+          uses<<',';
+        uses<<reactor_name(i+1+idx/p.timelines)<<'_'<<(idx%p.timelines);
+      }
+      r.put("<xmlattr>.name", reactor_name(i));
+      r.put("<xmlattr>.latency", 0);
+      r.put("<xmlattr>.lookahead", 1);
+      r.put("<xmlattr>.log", p.tr_log);
+      r.put("<xmlattr>.timelines", p.timelines);
+      r.put("<xmlattr>.uses", uses.str());
+      r.put("<xmlattr>.observations", p.observations);
+      r.put("<xmlattr>.goals", p.goals);
+      r.put("<xmlattr>.steps", p.steps);
+      r.put("<xmlattr>.cost", p.cost);
+    }
+    return root;
+  }
+  
+  /** @brief Statistics file summary
+   *
+   * The sum of each column of a TREX statistics csv file. The columns 
+   * which are already cumulated by TREX are summarized by their last 
+   * value instead.
+   */
+  struct csv_summary {
+    csv_summary():rows(0) {}
+    
+    size_t rows;
+    std::vector<std::string> columns;
+    std::vector<long double> totals;
+    std::vector<long double> last;
+    
+    /** @brief Check for a cumulated column
+     * @param[in] name A column name
+     * @retval true if the values of @p name are cumulated from the start
+     * @retval false otherwise
+     */
+    static bool cumulative(std::string const &name);
+    
+    /** @brief Load a csv file
+     * @param[in] file A file name
+     * @retval true if @p file was loaded
+     * @retval false otherwise
+     */
+    bool load(std::string const &file);
+    /** @brief Print as JSON
+     * @param[in,out] out An output stream
+     * @param[in] indent The indentation of the fields
+     *
+     * Write the totals -- or the last value of the cumulative ones -- of
+     * all the columns except @c tick as JSON fields
+     */
+    void print(std::ostream &out, std::string const &indent) const;
+  };
+  
+  bool csv_summary::cumulative(std::string const &name) {
+    // the agent order updates count and the clock lateness histogram
+    return "order_updates"==name || 0==name.compare(0, 5, "late_");
+  }
+  
+  bool csv_summary::load(std::string const &file) {
+    typedef boost::tokenizer< boost::char_separator<char> > tokenizer;
+    boost::char_separator<char> sep(", ");
+    std::ifstream in(file.c_str());
+    std::string line;
+    
+    if( !std::getline(in, line) )
+      return false;
+    tokenizer header(line, sep);
+    columns.assign(header.begin(), header.end());
+    totals.assign(columns.size(), 0.0);
+    last.assign(columns.size(), 0.0);
+    while( std::getline(in, line) ) {
+      tokenizer tok(line, sep);
+      size_t col = 0;
+      
+      ++rows;
+      for(tokenizer::iterator i=tok.begin(); tok.end()!=i && col<totals.size();
+          ++i, ++col) {
+        std::istringstream iss(*i);
+        long double val;
+        if( iss>>val ) {
+          totals[col] += val;
+          last[col] = val;
+        }
+      }
+    }
+    return true;
+  }
+  
+  void csv_summary::print(std::ostream &out, std::string const &indent) const {
+    out<<indent<<"\"rows\": "<<rows;
+    for(size_t i=0; i<columns.size(); ++i)
+      if( "tick"!=columns[i] )
+        out<<",\n"<<indent<<'"'<<columns[i]<<"\": "
+           <<(cumulative(columns[i])?last[i]:totals[i]);
+  }
+  
+}
+
+int main(int argc, char *argv[]) {
+  bench_params p;
+  po::options_description opt("Usage:\n"
+                              "  trex_bench [options]\n\n"
+                              "Allowed options");
+  
+  opt.add_options()
+  ("help,h", "produce help message")
+  ("include-path,I", po::value< std::vector<std::string> >(), "Add a directory to trex search path")
+  ("log-dir,L", po::value<std::string>(), "Set log directory")
+  ("output,o", po::value<std::string>(), "Write the JSON report in the given file")
+  ("reactors,r", po::value<size_t>(&p.reactors)->default_value(10),
+   "number of reactors")
+  ("timelines,t", po::value<size_t>(&p.timelines)->default_value(1),
+   "number of Internal timelines per reactor")
+  ("fanout,f", po::value<size_t>(&p.fanout)->default_value(2),
+   "number of External timelines per reactor")
+  ("observations", po::value<size_t>(&p.observations)->default_value(1),
+   "observations posted per reactor and tick")
+  ("goals", po::value<size_t>(&p.goals)->default_value(0),
+   "goals posted per reactor and tick")
+  ("steps", po::value<size_t>(&p.steps)->default_value(0),
+   "deliberation steps per reactor and tick")
+  ("cost", po::value<size_t>(&p.cost)->default_value(0),
+   "duration of a deliberation step in microseconds")
+  ("ticks,n", po::value<size_t>(&p.ticks)->default_value(100),
+   "number of ticks to execute")
+  ("clock", po::value<std::string>(&p.clock)->default_value("step"),
+   "clock to use: step (StepClock) or fast (FastClock over an EventClock)")
+  ("clock-steps", po::value<size_t>(&p.clock_steps)->default_value(0),
+   "maximum steps per tick of the clock (0: enough for all the reactors "
+   "steps with step, no limit with fast)")
+  ("sync-threads", po::value<size_t>(&p.sync_threads)->default_value(0),
+   "agent synchronization threads")
+  ("delib-threads", po::value<size_t>(&p.delib_threads)->default_value(0),
+   "agent deliberation threads")
+  ("no-tr-log", "disable the reactors transaction logs")
+  ;
+  
+  po::variables_map opt_val;
+  
+  try {
+    po::store(po::parse_command_line(argc, argv, opt), opt_val);
+    po::notify(opt_val);
+  } catch(boost::program_options::error const &e) {
+    std::cerr<<"command line error: "<<e.what()<<'\n'
+    <<opt<<std::endl;
+    return 1;
+  }
+  if( opt_val.count("help") ) {
+    std::cout<<"TREX synthetic reactor graph benchmark.\n"<<opt<<std::endl;
+    return 0;
+  }
+  if( 0==p.reactors || 0==p.timelines || 0==p.ticks ) {
+    std::cerr<<"reactors, timelines and ticks must be positive"<<std::endl;
+    return 1;
+  }
+  p.tr_log = !opt_val.count("no-tr-log");
+  
+  SingletonUse<LogManager> log;
+  
+  if( opt_val.count("include-path") ) {
+    std::vector<std::string> const &incs = opt_val["include-path"].as< std::vector<std::string> >();
+    for(std::vector<std::string>::const_iterator i=incs.begin();
+        incs.end()!=i; ++i)
+      log->addSearchPath(*i);
+  }
+  if( opt_val.count("log-dir") )
+    log->setLogPath(opt_val["log-dir"].as<std::string>());
+  LogManager::path_type const dir = log->logPath();
+  
+  clock_ref clk;
+  if( "step"==p.clock ) {
+    size_t steps = p.clock_steps;
+    if( 0==steps )
+      steps = p.reactors*(p.steps+1)+1;
+    clk.reset(new StepClock(Clock::duration_type(0), steps));
+  } else if( "fast"==p.clock ) {
+    clk.reset(new FastClock(clock_ref(new EventClock(p.clock_steps)),
+                            boost::posix_time::second_clock::universal_time(),
+                            CHRONO::seconds(1)));
+  } else {
+    std::cerr<<"Unknown clock \""<<p.clock<<"\": use step or fast"<<std::endl;
+    return 1;
+  }
+  
+  bench_clock::duration wall;
+  try {
+    bpt::ptree cfg = make_config(p);
+    UNIQ_PTR<Agent> agent(new Agent(cfg.front(), clk));
+    bench_clock::time_point start = bench_clock::now();
+    
+    agent->run();
+    wall = bench_clock::now()-start;
+    agent.reset(); // close all the stat files
+  } catch(TREX::utils::Exception const &e) {
+    std::cerr<<"TREX exception: "<<e<<std::endl;
+    return 1;
+  } catch(std::exception const &se) {
+    std::cerr<<"exception: "<<se.what()<<std::endl;
+    return 1;
+  }
+  
+  // Build the report
+  std::ofstream file;
+  std::ostream *out = &std::cout;
+  if( opt_val.count("output") ) {
+    file.open(opt_val["output"].as<std::string>().c_str());
+    out = &file;
+  }
+  double const secs = CHRONO::duration_cast< CHRONO::duration<double> >(wall).count();
+  csv_summary agent_stats;
+  
+  agent_stats.load((dir/"agent_stats.csv").string());
+  
+  *out<<std::setprecision(12)
+    <<"{\n  \"params\": {"
+    <<"\n    \"reactors\": "<<p.reactors
+    <<",\n    \"timelines\": "<<p.timelines
+    <<",\n    \"fanout\": "<<p.fanout
+    <<",\n    \"observations\": "<<p.observations
+    <<",\n    \"goals\": "<<p.goals
+    <<",\n    \"steps\": "<<p.steps
+    <<",\n    \"cost_us\": "<<p.cost
+    <<",\n    \"clock\": \""<<p.clock<<'"'
+    <<",\n    \"clock_steps\": "<<p.clock_steps
+    <<",\n    \"sync_threads\": "<<p.sync_threads
+    <<",\n    \"delib_threads\": "<<p.delib_threads
+    <<",\n    \"tr_log\": "<<(p.tr_log?"true":"false")
+    <<"\n  },\n  \"ticks\": "<<agent_stats.rows
+    <<",\n  \"wall_s\": "<<secs
+    <<",\n  \"ticks_per_sec\": "<<(secs>0.0?agent_stats.rows/secs:0.0)
+    <<",\n  \"agent\": {\n";
+  agent_stats.print(*out, "    ");
+  *out<<"\n  },\n  \"reactors\": [";
+  for(size_t i=0; i<p.reactors; ++i) {
+    csv_summary stats;
+    
+    stats.load((dir/reactor_name(i)/"stat.csv").string());
+    *out<<(i>0?",":"")<<"\n    {\n      \"name\": \""<<reactor_name(i)<<"\",\n";
+    stats.print(*out, "      ");
+    *out<<"\n    }";
+  }
+  *out<<"\n  ]\n}"<<std::endl;
+  return 0;
+}
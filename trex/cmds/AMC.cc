@@ -81,6 +81,7 @@
 #include <trex/agent/RealTimeClock.hh>
 #include <trex/agent/StepClock.hh>
 #include <trex/utils/TREXversion.hh>
+#include <trex/utils/asio_fstream.hh>
 
 #include <boost/date_time/posix_time/time_formatters.hpp>
 
@@ -167,6 +168,9 @@ int main(int argc, char *argv[]) {
   ("version,v", "print trex version")
   ("include-path,I", po::value< std::vector<std::string> >(), "Add a directory to trex search path")
   ("log-dir,L", po::value<std::string>(), "Set log directory")
+  ("compress-logs,z", "gzip compress the log files")
+  ("rotate-logs", po::value<size_t>(),
+   "split the log files every given number of MB")
   ("sim,s", po::value<size_t>()->implicit_value(60),
    "run agent with simulated clock with given deliberation steps per tick")
   ("period,p", po::value<unsigned long>()->implicit_value(1000),
@@ -290,6 +294,18 @@ int main(int argc, char *argv[]) {
     amc_log->setLogPath(opt_val["log-dir"].as<std::string>());
   // Create log directory and all
   amc_log->logPath();
+  if( opt_val.count("compress-logs") || opt_val.count("rotate-logs") ) {
+    async_ofstream::storage_policy storage(opt_val.count("compress-logs"));
+    
+    if( storage.compress && !async_ofstream::compression_supported() ) {
+      amc_log->syslog("amc", warn)<<"This version of trex does not support "
+      <<"log compression: logs will not be compressed.";
+      storage.compress = false;
+    }
+    if( opt_val.count("rotate-logs") )
+      storage.rotate = opt_val["rotate-logs"].as<size_t>()<<20;
+    async_ofstream::default_storage(storage);
+  }
   
 
 #ifdef DAEMON
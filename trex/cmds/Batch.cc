@@ -0,0 +1,571 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ * 
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ * 
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ * 
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ * 
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @defgroup batchcmd trex_batch command
+ * @brief A parallel mission batch running command
+ *
+ * This module embeds all the code related to the @c trex_batch program
+ *
+ * @h1 trex_batch command usage
+ *
+ * The trex_batch command runs a list of missions -- for example the 
+ * variants of a regression suite -- concurrently:
+ * @code
+ * trex_batch [options] <mission>[.cfg] ... [--runs <file>]
+ * @endcode 
+ * Each run is described by a mission configuration file and an optional 
+ * list of overrides of the form @c <path>=<value>. The path is relative 
+ * to the @c Agent element of the configuration with dot separated 
+ * elements, a component starting with @c @@ designating an attribute. 
+ * For example @c @@finalTick=200 changes the final tick of the agent while
+ * @c Plugin.Light.@@state=0 changes the @c state attribute of the first 
+ * @c Light reactor of the first @c Plugin.
+ *
+ * A runs file lists one run per line: the mission name followed by its 
+ * overrides separated by spaces. Empty lines and lines starting with 
+ * @c # are ignored. The overrides given with @c --set apply to all the 
+ * runs before their own overrides.
+ *
+ * Each run is executed by a separate process with its own log directory 
+ * -- a sub-directory of the batch log directory -- and its own clock. 
+ * This isolates the agents from each other as the LogManager and the 
+ * factories are process wide singletons. At most @c --jobs runs execute 
+ * at the same time and the command prints, for each run, its status 
+ * along with the number of ticks per second and the deliberation time 
+ * extracted from its @c agent_stats.csv.
+ *
+ * @ingroup commands
+ */
+
+/** @file Batch.cc
+ * @brief Parallel mission batch runner
+ *
+ * This file implements the trex_batch command
+ *
+ * @ingroup batchcmd
+ */
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <trex/agent/Agent.hh>
+#include <trex/agent/EventClock.hh>
+#include <trex/agent/RealTimeClock.hh>
+#include <trex/agent/StepClock.hh>
+#include <trex/utils/TREXversion.hh>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/tokenizer.hpp>
+
+using namespace TREX::agent;
+using namespace TREX::utils;
+namespace tlog=TREX::utils::log;
+
+namespace po=boost::program_options;
+namespace fs=boost::filesystem;
+namespace bpt=boost::property_tree;
+
+namespace {
+
+  typedef CHRONO::high_resolution_clock wall_clock;
+  
+  /** @brief A batch run
+   *
+   * The description and outcome of one mission run
+   *
+   * @ingroup batchcmd
+   */
+  struct batch_run {
+    batch_run():pid(-1), status(0), ticks(0), delib(0) {}
+
+    /** @brief Mission configuration name */
+    std::string              mission;
+    /** @brief Configuration overrides */
+    std::vector<std::string> overrides;
+    /** @brief Log directory */
+    fs::path                 dir;
+    /** @brief Process id of the worker while running */
+    pid_t                    pid;
+    /** @brief worker status as returned by waitpid */
+    int                      status;
+    
+    wall_clock::time_point   start;
+    wall_clock::duration     wall;
+    /** @brief Number of ticks executed */
+    unsigned long long       ticks;
+    /** @brief Total deliberation time in nanoseconds */
+    unsigned long long       delib;
+
+    bool succeeded() const {
+      return WIFEXITED(status) && 0==WEXITSTATUS(status);
+    }
+    std::string status_str() const;
+    double seconds() const {
+      return CHRONO::duration_cast< CHRONO::duration<double> >(wall).count();
+    }
+    /** @brief Extract statistics from the run agent_stats.csv */
+    void load_stats();
+  }; // ::batch_run
+  
+  std::string batch_run::status_str() const {
+    std::ostringstream oss;
+    if( WIFEXITED(status) ) {
+      if( 0==WEXITSTATUS(status) )
+        return "ok";
+      oss<<"failed("<<WEXITSTATUS(status)<<')';
+    } else if( WIFSIGNALED(status) )
+      oss<<"killed("<<WTERMSIG(status)<<')';
+    else
+      oss<<"unknown";
+    return oss.str();
+  }
+
+  void batch_run::load_stats() {
+    std::ifstream csv((dir/"agent_stats.csv").string().c_str());
+    std::string line;
+    size_t delib_col = std::numeric_limits<size_t>::max();
+    
+    typedef boost::tokenizer< boost::char_separator<char> > tokenizer;
+    boost::char_separator<char> sep(", ");
+    
+    if( std::getline(csv, line) ) {
+      tokenizer tok(line, sep);
+      size_t col = 0;
+      for(tokenizer::iterator i=tok.begin(); tok.end()!=i; ++i, ++col)
+        if( "delib_rt_ns"==*i )
+          delib_col = col;
+    }
+    while( std::getline(csv, line) ) {
+      tokenizer tok(line, sep);
+      size_t col = 0;
+      
+      ++ticks;
+      for(tokenizer::iterator i=tok.begin(); tok.end()!=i; ++i, ++col) {
+        if( delib_col==col ) {
+          try {
+            delib += string_cast<unsigned long long>(*i);
+          } catch(bad_string_cast const &) {}
+          break;
+        }
+      }
+    }
+  }
+  
+  po::options_description opt("Usage:\n"
+                              "  trex_batch <mission>[.cfg] ... [options]\n\n"
+                              "Allowed options");
+
+  /** @brief Apply a configuration override
+   *
+   * @param[in,out] agent An agent XML configuration
+   * @param[in] ovr An override of the form <path>=<value>
+   *
+   * @throw TREX::utils::Exception @p ovr is not a valid override
+   */
+  void apply_override(bpt::ptree &agent, std::string const &ovr) {
+    size_t eq = ovr.find('=');
+    if( std::string::npos==eq || 0==eq )
+      throw TREX::utils::Exception("Invalid override \""+ovr
+                                   +"\": expected <path>=<value>");
+    std::string const key = ovr.substr(0, eq);
+    std::string path;
+    boost::char_separator<char> sep(".");
+    boost::tokenizer< boost::char_separator<char> > tok(key, sep);
+    
+    for(boost::tokenizer< boost::char_separator<char> >::iterator i=tok.begin();
+        tok.end()!=i; ++i) {
+      if( !path.empty() )
+        path += '.';
+      if( '@'==(*i)[0] )
+        path += "<xmlattr>."+i->substr(1);
+      else
+        path += *i;
+    }
+    agent.put(path, ovr.substr(eq+1));
+  }
+
+  /** @brief Execute a single run
+   *
+   * @param[in] opt_val The command line options
+   *
+   * This is the entry point of the worker processes spawned by the 
+   * batch: it loads the mission with its overrides in the log directory 
+   * it was given and execute the agent until completion.
+   *
+   * @return the process exit code
+   */
+  int run_worker(po::variables_map const &opt_val) {
+    SingletonUse<LogManager> log;
+    std::string const mission = opt_val["mission"].as< std::vector<std::string> >().front();
+    
+    if( opt_val.count("include-path") ) {
+      std::vector<std::string> const &incs = opt_val["include-path"].as< std::vector<std::string> >();
+      for(std::vector<std::string>::const_iterator i=incs.begin();
+          incs.end()!=i; ++i)
+        log->addSearchPath(*i);
+    }
+    log->setLogPath(opt_val["worker"].as<std::string>());
+    log->logPath();
+    
+    try {
+      clock_ref clk;
+      
+      if( opt_val.count("sim") )
+        clk.reset(new StepClock(Clock::duration_type(0),
+                                opt_val["sim"].as<size_t>()));
+      else if( opt_val.count("fast") )
+        clk.reset(new EventClock(opt_val["fast"].as<size_t>()));
+      
+      bool found;
+      std::string name = log->use(mission, found);
+      if( !found ) {
+        name = log->use(mission+".cfg", found);
+        if( !found )
+          throw TREX::utils::Exception("Unable to locate "+mission);
+      }
+      bpt::ptree cfg;
+      bpt::read_xml(name, cfg, bpt::xml_parser::no_comments|bpt::xml_parser::trim_whitespace);
+      if( cfg.size()!=1 )
+        throw TREX::utils::Exception("Configuration file : \""+name
+                                     +"\" should have exactly one root.");
+      if( opt_val.count("set") ) {
+        std::vector<std::string> const &sets = opt_val["set"].as< std::vector<std::string> >();
+        for(std::vector<std::string>::const_iterator i=sets.begin();
+            sets.end()!=i; ++i) {
+          log->syslog("batch", tlog::info)<<"Override "<<*i;
+          apply_override(cfg.front().second, *i);
+        }
+        // Keep the actual configuration used
+        bpt::write_xml(log->file_name("cfg/batch.cfg").string(), cfg);
+      }
+      
+      UNIQ_PTR<Agent> agent(new Agent(cfg.front(), clk));
+      agent->setClock(clock_ref(new RealTimeClock(CHRONO::seconds(1))));
+      agent->run();
+      agent.reset();
+    } catch(TREX::utils::Exception const &e) {
+      log->syslog("batch", tlog::error)<<"TREX exception :"<<e;
+      log->flush();
+      return 1;
+    } catch(std::exception const &se) {
+      log->syslog("batch", tlog::error)<<"exception :"<<se.what();
+      log->flush();
+      return 1;
+    }
+    log->flush();
+    return 0;
+  }
+
+  /** @brief Start a run
+   *
+   * @param[in] self The name of this command
+   * @param[in,out] run The run to start
+   * @param[in] common Worker arguments common to all the runs
+   *
+   * Spawn a new worker process for @p run. The worker standard and 
+   * error outputs are redirected to the file @c output.txt of the 
+   * run log directory.
+   */
+  void spawn(char const *self, batch_run &run,
+             std::vector<std::string> const &common) {
+    std::vector<std::string> args;
+    std::vector<char *> argv;
+    
+    args.push_back(self);
+    args.push_back("--worker");
+    args.push_back(run.dir.string());
+    args.insert(args.end(), common.begin(), common.end());
+    for(std::vector<std::string>::const_iterator i=run.overrides.begin();
+        run.overrides.end()!=i; ++i) {
+      args.push_back("--set");
+      args.push_back(*i);
+    }
+    args.push_back(run.mission);
+    for(std::vector<std::string>::iterator i=args.begin(); args.end()!=i; ++i)
+      argv.push_back(&(*i)[0]);
+    argv.push_back(NULL);
+    
+    fs::create_directories(run.dir);
+    std::string out = (run.dir/"output.txt").string();
+    
+    run.start = wall_clock::now();
+    run.pid = fork();
+    if( 0==run.pid ) {
+      int fd = open(out.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+      if( fd>=0 ) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+      }
+      execvp(self, &argv[0]);
+      std::cerr<<"Failed to execute "<<self<<": "<<strerror(errno)<<std::endl;
+      _exit(127);
+    } else if( run.pid<0 ) {
+      std::cerr<<"Failed to spawn a worker: "<<strerror(errno)<<std::endl;
+      exit(2);
+    }
+  }
+  
+  /** @brief Parse a runs file
+   *
+   * @param[in] file A file name
+   * @param[out] runs The list of runs
+   *
+   * Add all the runs described in @p file at the end of @p runs 
+   */
+  void load_runs(std::string const &file, std::vector<batch_run> &runs) {
+    std::ifstream in(file.c_str());
+    std::string line;
+
+    if( !in ) {
+      std::cerr<<"Unable to open runs file \""<<file<<"\""<<std::endl;
+      exit(1);
+    }
+    while( std::getline(in, line) ) {
+      std::istringstream iss(line);
+      std::string word;
+      
+      if( !(iss>>word) || '#'==word[0] )
+        continue;
+      batch_run run;
+      run.mission = word;
+      while( iss>>word )
+        run.overrides.push_back(word);
+      runs.push_back(run);
+    }
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+  po::options_description hidden("Hidden options"), cmd_line;
+  size_t jobs = boost::thread::hardware_concurrency();
+  
+  // Handler for the mission names
+  hidden.add_options()
+  ("mission", po::value< std::vector<std::string> >(),
+   "The name of the mission files")
+  ("worker", po::value<std::string>(), "run a single mission in the given log dir");
+  po::positional_options_description p;
+  p.add("mission", -1);
+  
+  opt.add_options()
+  ("help,h", "produce help message")
+  ("version,v", "print trex version")
+  ("include-path,I", po::value< std::vector<std::string> >(), "Add a directory to trex search path")
+  ("log-dir,L", po::value<std::string>(), "Set the batch log directory")
+  ("runs,r", po::value<std::string>(), "Load the runs listed in the given file")
+  ("set,D", po::value< std::vector<std::string> >(),
+   "Override a configuration value in all the runs (<path>=<value>)")
+  ("jobs,j", po::value<size_t>(&jobs), "Maximum number of concurrent runs")
+  ("sim,s", po::value<size_t>()->implicit_value(60),
+   "run agents with simulated clock with given deliberation steps per tick")
+  ("fast,f", po::value<size_t>()->implicit_value(0),
+   "run agents with an event clock with the given maximum deliberation "
+   "steps per tick (0 for no limit)")
+  ;
+  cmd_line.add(opt).add(hidden);
+  
+  po::variables_map opt_val;
+  
+  try {
+    po::store(po::command_line_parser(argc, argv).options(cmd_line).positional(p).run(),
+              opt_val);
+    po::notify(opt_val);
+  } catch(boost::program_options::error const &e) {
+    std::cerr<<"command line error: "<<e.what()<<'\n'
+    <<opt<<std::endl;
+    exit(1);
+  }
+  if( opt_val.count("help") ) {
+    std::cout<<"TREX parallel batch execution command.\n"<<opt<<"\nExample:\n  "
+    <<"trex_batch sample -D @finalTick=100 -j 4 --fast\n"
+    <<"  - run trex agent from sample.cfg with a final tick of 100 as fast as possible\n"<<std::endl;
+    exit(0);
+  }
+  if( opt_val.count("version") ) {
+    std::cout<<"trex_batch for trex "<<TREX::version::full_str()<<std::endl;
+    exit(0);
+  }
+  if( opt_val.count("sim") && opt_val.count("fast") ) {
+    std::cerr<<"Options sim and fast are conflicting: pick one!\n"
+    <<opt<<std::endl;
+    exit(1);
+  }
+  
+  if( opt_val.count("worker") ) {
+    if( 1!=opt_val.count("mission") ) {
+      std::cerr<<"A worker runs exactly one mission."<<std::endl;
+      exit(1);
+    }
+    return run_worker(opt_val);
+  }
+  
+  // Build the list of runs
+  std::vector<batch_run> runs;
+  std::vector<std::string> common;
+
+  if( opt_val.count("mission") ) {
+    std::vector<std::string> const &names = opt_val["mission"].as< std::vector<std::string> >();
+    for(std::vector<std::string>::const_iterator i=names.begin();
+        names.end()!=i; ++i) {
+      batch_run run;
+      run.mission = *i;
+      runs.push_back(run);
+    }
+  }
+  if( opt_val.count("runs") )
+    load_runs(opt_val["runs"].as<std::string>(), runs);
+  if( runs.empty() ) {
+    std::cerr<<"No mission to run.\n"<<opt<<std::endl;
+    exit(1);
+  }
+  if( 0==jobs )
+    jobs = 1;
+  
+  // Arguments passed to all the workers
+  if( opt_val.count("include-path") ) {
+    std::vector<std::string> const &incs = opt_val["include-path"].as< std::vector<std::string> >();
+    for(std::vector<std::string>::const_iterator i=incs.begin();
+        incs.end()!=i; ++i) {
+      // the workers do not run in the same directory
+      common.push_back("-I");
+      common.push_back(fs::absolute(*i).string());
+    }
+  }
+  if( opt_val.count("sim") ) 
+    common.push_back("--sim="+boost::lexical_cast<std::string>(opt_val["sim"].as<size_t>()));
+  else if( opt_val.count("fast") )
+    common.push_back("--fast="+boost::lexical_cast<std::string>(opt_val["fast"].as<size_t>()));
+  if( opt_val.count("set") ) {
+    std::vector<std::string> const &sets = opt_val["set"].as< std::vector<std::string> >();
+    for(std::vector<std::string>::const_iterator i=sets.begin();
+        sets.end()!=i; ++i) {
+      common.push_back("--set");
+      common.push_back(*i);
+    }
+  }
+  
+  // Locate the batch log directory
+  fs::path base;
+  if( opt_val.count("log-dir") )
+    base = opt_val["log-dir"].as<std::string>();
+  else {
+    char *log_dir = getenv("TREX_LOG_DIR");
+    char stamp[32];
+    time_t cur_time;
+    
+    if( NULL==log_dir ) {
+      std::cerr<<"$TREX_LOG_DIR is not set: use --log-dir"<<std::endl;
+      exit(1);
+    }
+    time(&cur_time);
+    strftime(stamp, sizeof(stamp), "batch.%Y.%j.%H%M%S", gmtime(&cur_time));
+    base = log_dir;
+    base /= stamp;
+  }
+  base = fs::absolute(base);
+  for(size_t i=0; i<runs.size(); ++i) {
+    std::ostringstream oss;
+    oss<<std::setw(3)<<std::setfill('0')<<(i+1)<<'-'
+       <<fs::path(runs[i].mission).stem().string();
+    runs[i].dir = base/oss.str();
+  }
+  std::cout<<"Running "<<runs.size()<<" missions ("<<jobs
+           <<" at a time) in "<<base<<std::endl;
+  
+  // Execute the runs on at most jobs workers
+  std::map<pid_t, size_t> running;
+  size_t next = 0, done = 0, failed = 0;
+  wall_clock::time_point batch_start = wall_clock::now();
+  
+  while( done<runs.size() ) {
+    for( ; next<runs.size() && running.size()<jobs; ++next) {
+      spawn(argv[0], runs[next], common);
+      running[runs[next].pid] = next;
+    }
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if( pid<0 ) {
+      if( EINTR==errno )
+        continue;
+      std::cerr<<"waitpid failed: "<<strerror(errno)<<std::endl;
+      exit(2);
+    }
+    std::map<pid_t, size_t>::iterator pos = running.find(pid);
+    if( running.end()==pos )
+      continue;
+    batch_run &run = runs[pos->second];
+    running.erase(pos);
+    run.wall = wall_clock::now()-run.start;
+    run.status = status;
+    run.load_stats();
+    ++done;
+    if( !run.succeeded() )
+      ++failed;
+    std::cout<<'['<<done<<'/'<<runs.size()<<"] "<<run.dir.filename().string()
+             <<": "<<run.status_str()<<" after "<<run.ticks<<" ticks in "
+             <<run.seconds()<<"s"<<std::endl;
+  }
+  double total = CHRONO::duration_cast< CHRONO::duration<double> >(wall_clock::now()-batch_start).count();
+  
+  // Print the summary
+  std::cout<<"\n"<<std::left<<std::setw(24)<<"run"<<std::right
+           <<std::setw(12)<<"status"
+           <<std::setw(10)<<"ticks"
+           <<std::setw(12)<<"wall(s)"
+           <<std::setw(12)<<"ticks/s"
+           <<std::setw(14)<<"delib(ms)"<<'\n';
+  for(std::vector<batch_run>::const_iterator i=runs.begin(); runs.end()!=i; ++i) {
+    double secs = i->seconds();
+    std::cout<<std::left<<std::setw(24)<<i->dir.filename().string()<<std::right
+             <<std::setw(12)<<i->status_str()
+             <<std::setw(10)<<i->ticks
+             <<std::setw(12)<<std::fixed<<std::setprecision(3)<<secs
+             <<std::setw(12)<<std::setprecision(1)<<(secs>0.0?i->ticks/secs:0.0)
+             <<std::setw(14)<<std::setprecision(3)<<(i->delib/1e6)<<'\n';
+  }
+  std::cout<<'\n'<<runs.size()<<" runs, "<<failed<<" failed, in "
+           <<std::setprecision(3)<<total<<"s"<<std::endl;
+  return failed>0?1:0;
+}
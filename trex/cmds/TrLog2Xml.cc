@@ -0,0 +1,144 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ * 
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ * 
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ * 
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ * 
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @defgroup trlogcmd trlog2xml command
+ * @brief Transaction log converter
+ *
+ * This module embeds all the code related to the @c trlog2xml program
+ *
+ * @h1 trlog2xml command usage
+ *
+ * @code
+ * trlog2xml <log>.tr.bin [-o <out>]
+ * @endcode
+ *
+ * Converts a binary transaction log -- as produced by a reactor with 
+ * the attribute @c log_format="binary" -- into the XML transaction log 
+ * this reactor would have produced otherwise. The result is written in 
+ * @c @<out@> if given or to the standard output. The binary log can also 
+ * be gzip compressed and/or split in multiple files.
+ *
+ * @sa TREX::transaction::tr_log::binary_reader
+ *
+ * @ingroup commands
+ */
+
+/** @file TrLog2Xml.cc
+ * @brief Binary transaction log to XML converter
+ *
+ * @ingroup trlogcmd
+ */
+#include <trex/utils/TREXversion.hh>
+#include <trex/utils/log_ifstream.hh>
+#include <trex/transaction/TransactionLog.hh>
+
+#include <fstream>
+
+#include <boost/program_options.hpp>
+
+using namespace TREX::transaction;
+
+namespace po=boost::program_options;
+
+int main(int argc, char **argv) {
+  std::string input;
+  po::options_description opt("Usage:\n"
+                              "  trlog2xml <log>.tr.bin [options]\n\n"
+                              "Allowed options"), 
+    hidden("Hidden options"), cmd_line;
+  
+  opt.add_options()
+  ("help,h", "produce help message and exit")
+  ("version,v", "print trex version and exit")
+  ("output,o", po::value<std::string>(), 
+   "Write the XML log into this file instead of the standard output");
+  hidden.add_options()("log", po::value<std::string>(&input),
+                       "The binary log file");
+  po::positional_options_description p;
+  p.add("log", 1);
+  
+  cmd_line.add(opt).add(hidden);
+  po::variables_map opt_val;
+  
+  try {
+    po::store(po::command_line_parser(argc, argv).options(cmd_line).positional(p).run(),
+              opt_val);
+    po::notify(opt_val);
+  } catch(po::error const &e) {
+    std::cerr<<"command line error: "<<e.what()<<'\n'
+    <<opt<<std::endl;
+    return 1;
+  }
+  
+  if( opt_val.count("help") ) {
+    std::cout<<"TREX binary transaction log converter\n"<<opt<<std::endl;
+    return 0;
+  }
+  if( opt_val.count("version") ) {
+    std::cout<<"trlog2xml for trex "<<TREX::version::full_str()<<std::endl;
+    return 0;
+  }
+  if( !opt_val.count("log") ) {
+    std::cerr<<"No log file specified\n"<<opt<<std::endl;
+    return 1;
+  }
+  
+  // the log may be compressed and/or split in multiple parts
+  TREX::utils::log_ifstream in(input);
+  if( !in ) {
+    std::cerr<<"Unable to open \""<<input<<"\""<<std::endl;
+    return 1;
+  }
+  
+  std::ofstream file;
+  if( opt_val.count("output") ) {
+    std::string const &name = opt_val["output"].as<std::string>();
+    file.open(name.c_str());
+    if( !file ) {
+      std::cerr<<"Unable to create \""<<name<<"\""<<std::endl;
+      return 1;
+    }
+  }
+  
+  tr_log::xml_writer out(file.is_open()?file:std::cout);
+  try {
+    tr_log::binary_reader log(in);
+    out.open();
+    log.convert(out);
+  } catch(TREX::utils::Exception const &e) {
+    out.flush();
+    std::cerr<<input<<": "<<e<<std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -39,6 +39,7 @@
  */
 # include <algorithm>
 # include <iterator>
+# include <typeinfo>
 
 # include "Variable.hh"
 
@@ -53,53 +54,84 @@ using namespace TREX::transaction;
 
 SingletonUse<DomainBase::xml_factory> Variable::s_dom_factory;
 
-DomainBase *Variable::clone
-(boost::call_traits<Variable::domain_ptr>::param_type dom) {
-  if( !dom )
-    return NULL;
-  else
-    return dom->copy();
-}
-
 // structors :
 
-Variable::Variable() {}
+Variable::Variable()
+  :m_kind(no_domain), m_domain(NULL) {}
 
 Variable::Variable(Symbol const &name, DomainBase *dom)
-  :m_name(name), m_domain(dom) {}
+  :m_name(name), m_kind(no_domain), m_domain(NULL) {
+  adopt(domain_ptr(dom));
+}
 
 Variable::Variable(Symbol const &name, DomainBase const &dom) 
-  :m_name(name), m_domain(dom.copy()) {
+  :m_name(name), m_kind(no_domain), m_domain(NULL) {
   if( m_name.empty() )
     throw VariableException("Empty variable names are not allowed");
+  set_domain(dom);
 }
 
 Variable::Variable(Variable const &other) 
-  :m_name(other.m_name), m_domain(clone(other.m_domain)) {}
+  :m_name(other.m_name), m_kind(no_domain), m_domain(NULL) {
+  copy_domain(other);
+}
 
 Variable::Variable(boost::property_tree::ptree::value_type &node)
-  :m_name(parse_attr<Symbol>(node.second, "name")) {
+  :m_name(parse_attr<Symbol>(node.second, "name")), 
+   m_kind(no_domain), m_domain(NULL) {
   if( m_name.empty() )
     throw XmlError(node, "Variable name is empty.");
   
   boost::property_tree::ptree::iterator i = node.second.begin();
-  if( !s_dom_factory->iter_produce(i, node.second.end(), m_domain) )
+  domain_ptr dom;
+  if( !s_dom_factory->iter_produce(i, node.second.end(), dom) )
     throw XmlError(node, "Missing variable domain on XML tag"); 
+  adopt(dom);
 }
 
-Variable::~Variable() {}
+Variable::~Variable() {
+  reset_domain();
+}
 
 // Modifiers :
 
 Variable &Variable::operator= (Variable const &other) {
-  m_name = other.m_name;
-  m_domain.reset(clone(other.m_domain));
+  if( this!=&other ) {
+    switch( other.m_kind ) {
+    case no_domain:
+      reset_domain();
+      break;
+    case integer_domain:
+    case float_domain:
+    case boolean_domain:
+      // copying an interval does not throw
+      reset_domain();
+      copy_domain(other);
+      break;
+    default:
+      if( heap_domain==m_kind || no_domain==m_kind ) {
+        // m_storage is free: copy_domain leaves this domain untouched 
+        // if it throws
+        copy_domain(other);
+        if( heap_domain!=m_kind )
+          m_heap.reset();
+      } else {
+        // m_storage holds this domain: copy the new one aside first
+        domain_ptr dom(other.m_domain->copy());
+        reset_domain();
+        m_heap.swap(dom);
+        m_domain = m_heap.get();
+        m_kind = heap_domain;
+      }
+    }
+    m_name = other.m_name;
+  }
   return *this;
 }
 
 Variable &Variable::restrict(DomainBase const &dom) {
-  if( !m_domain )
-    m_domain.reset(dom.copy());
+  if( NULL==m_domain )
+    set_domain(dom);
   else 
     m_domain->restrictWith(dom);
   return *this;
@@ -123,6 +155,78 @@ Variable &Variable::restrict(Variable const &var) {
   return *this;
 }
 
+// Domain storage :
+
+bool Variable::set_inline(DomainBase const &dom) {
+  std::type_info const &type = typeid(dom);
+  
+  if( typeid(IntegerDomain)==type )
+    emplace(static_cast<IntegerDomain const &>(dom), integer_domain);
+  else if( typeid(FloatDomain)==type )
+    emplace(static_cast<FloatDomain const &>(dom), float_domain);
+  else if( typeid(BooleanDomain)==type )
+    emplace(static_cast<BooleanDomain const &>(dom), boolean_domain);
+  else if( typeid(StringDomain)==type )
+    emplace(static_cast<StringDomain const &>(dom), string_domain);
+  else if( typeid(EnumDomain)==type )
+    emplace(static_cast<EnumDomain const &>(dom), enum_domain);
+  else
+    return false;
+  return true;
+}
+
+void Variable::set_domain(DomainBase const &dom) {
+  if( !set_inline(dom) ) {
+    m_heap.reset(dom.copy());
+    m_domain = m_heap.get();
+    m_kind = heap_domain;
+  }
+}
+
+void Variable::adopt(Variable::domain_ptr const &dom) {
+  if( dom && !set_inline(*dom) ) {
+    m_heap = dom;
+    m_domain = m_heap.get();
+    m_kind = heap_domain;
+  }
+}
+
+void Variable::copy_domain(Variable const &other) {
+  switch( other.m_kind ) {
+  case integer_domain:
+    emplace(other.inline_domain<IntegerDomain>(), integer_domain);
+    break;
+  case float_domain:
+    emplace(other.inline_domain<FloatDomain>(), float_domain);
+    break;
+  case boolean_domain:
+    emplace(other.inline_domain<BooleanDomain>(), boolean_domain);
+    break;
+  case string_domain:
+    emplace(other.inline_domain<StringDomain>(), string_domain);
+    break;
+  case enum_domain:
+    emplace(other.inline_domain<EnumDomain>(), enum_domain);
+    break;
+  case heap_domain:
+    m_heap.reset(other.m_domain->copy());
+    m_domain = m_heap.get();
+    m_kind = heap_domain;
+    break;
+  default:
+    break;
+  }
+}
+
+void Variable::reset_domain() {
+  if( heap_domain==m_kind ) 
+    m_heap.reset();
+  else if( NULL!=m_domain ) 
+    m_domain->~DomainBase();
+  m_domain = NULL;
+  m_kind = no_domain;
+}
+
 // Observers :
 
 DomainBase const &Variable::domain() const {
@@ -44,8 +44,16 @@
 # define H_Variable
 
 # include <functional>
+# include <new>
 
-# include "DomainBase.hh"
+# include <boost/aligned_storage.hpp>
+# include <boost/type_traits/alignment_of.hpp>
+
+# include "BooleanDomain.hh"
+# include "EnumDomain.hh"
+# include "FloatDomain.hh"
+# include "IntegerDomain.hh"
+# include "StringDomain.hh"
 
 namespace TREX {
   namespace transaction {
@@ -81,6 +89,20 @@ namespace TREX {
      * Goal excahnged between reactors. They are represented by a
      * symbolic name and its associated domain.
      *
+     * The domains of the built-in types (integer, float, bool, string 
+     * and enum) are stored within the variable itself which allows to 
+     * copy variables with no heap allocation for the domain object. Other 
+     * domain types are allocated on the heap.
+     *
+     * @note Only integer, float and bool domains are fully allocation 
+     * free. String and enum domains keep their values in a @c std::set 
+     * so copying them still allocates one node per value -- even for a 
+     * singleton -- plus the value itself when it does not fit in the 
+     * string small buffer.
+     * @note Only the copy of the domain is dispatched on its kind. All 
+     * the other domain operations (restrict, comparison, printing, ...) 
+     * still go through the DomainBase virtual methods.
+     *
      * @author Frederic Py <fpy@mbari.org>
      * @ingroup domains
      */
@@ -152,7 +174,8 @@ namespace TREX {
        * @param other Another instance
        *
        * This method copy the value of @e other in current
-       * instance.
+       * instance. If this copy fails the current instance is left
+       * unchanged.
        *
        * @return current instance after operation
        */
@@ -286,23 +309,127 @@ namespace TREX {
       
     private:
       typedef DomainBase::xml_factory::returned_type domain_ptr;
+      
+      /** @brief Domain storage kind
+       *
+       * Identifies how the domain of a variable is stored. The built-in 
+       * domain types are stored inline within the variable while any 
+       * other domain type is allocated on the heap.
+       */
+      enum domain_kind {
+        no_domain = 0,
+        integer_domain,
+        float_domain,
+        boolean_domain,
+        string_domain,
+        enum_domain,
+        heap_domain
+      };
+      
+      /** @brief Compile time maximum helper */
+      template<size_t A, size_t B>
+      struct static_max {
+        enum { value = (A<B)?B:A };
+      };
+      /** @brief Inline domain storage
+       *
+       * A raw storage large enough to hold any of the built-in domain 
+       * types
+       */
+      typedef boost::aligned_storage<
+        static_max<static_max<sizeof(IntegerDomain), sizeof(FloatDomain)>::value,
+                   static_max<sizeof(BooleanDomain), 
+                              static_max<sizeof(StringDomain), 
+                                         sizeof(EnumDomain)>::value>::value>::value,
+        static_max<static_max<boost::alignment_of<IntegerDomain>::value, 
+                              boost::alignment_of<FloatDomain>::value>::value,
+                   static_max<boost::alignment_of<BooleanDomain>::value, 
+                              static_max<boost::alignment_of<StringDomain>::value, 
+                                         boost::alignment_of<EnumDomain>::value>::value>::value>::value
+      > domain_storage;
+      
       /** @brief varaible name */
       TREX::utils::Symbol m_name;
-      /** @brief Variable domain */
-      domain_ptr m_domain;
+      /** @brief How the domain is stored */
+      domain_kind m_kind;
+      /** @brief Storage for built-in domains */
+      domain_storage m_storage;
+      /** @brief Storage for other domains */
+      domain_ptr m_heap;
+      /** @brief Variable domain 
+       *
+       * A pointer to the domain of this variable which is either in 
+       * m_storage or m_heap depending on m_kind. It is NULL when this 
+       * variable has no domain.
+       */
+      DomainBase *m_domain;
       
       std::ostream &print_to(std::ostream &out) const;
       
       /** @brief Entry point to domain XML parsing */
       static TREX::utils::SingletonUse< DomainBase::xml_factory > s_dom_factory;
       
-      /** @brief Domain duplication helper
+      /** @brief Inline domain construction
+       * @tparam Dom A built-in domain type
+       * @param dom A domain
+       * @param kind The kind associated to @p Dom
+       *
+       * Store a copy of @p dom inline
+       * @pre This variable has no domain
+       */
+      template<class Dom>
+      void emplace(Dom const &dom, domain_kind kind) {
+        m_domain = new(m_storage.address()) Dom(dom);
+        m_kind = kind;
+      }
+      /** @brief Inline domain access
+       * @tparam Dom A built-in domain type
+       * @pre This variable stores a @p Dom inline
+       */
+      template<class Dom>
+      Dom const &inline_domain() const {
+        return *static_cast<Dom const *>(m_storage.address());
+      }
+      /** @brief Try to store a domain inline
+       * @param dom A domain
+       *
+       * Store a copy of @p dom inline if its type is one of the built-in 
+       * domain types
+       * @pre This variable has no domain
+       * @retval true if @p dom was stored inline
+       * @retval false otherwise
+       */
+      bool set_inline(DomainBase const &dom);
+      /** @brief Set variable domain
        * @param dom A domain
-       * This method helps to duplicate a domain pointed by @e dom
-       * while managing the case where @e dom is NULL
-       * @return a pointer to a copy of @a *dom or a NULL pointer
+       *
+       * Set the domain of this variable to a copy of @p dom
+       * @pre This variable has no domain
+       */
+      void set_domain(DomainBase const &dom);
+      /** @brief Set variable domain
+       * @param dom A domain pointer
+       *
+       * Set the domain of this variable to @p dom. If the type of @p dom 
+       * is a built-in domain it is copied inline, otherwise this variable 
+       * shares @p dom
+       * @pre This variable has no domain
+       */
+      void adopt(domain_ptr const &dom);
+      /** @brief Domain duplication helper
+       * @param other Another variable
+       *
+       * Set the domain of this variable to a copy of the domain of 
+       * @p other. Built-in domains are copied based on the kind of 
+       * @p other with no virtual call nor allocation of the domain 
+       * object -- string and enum domains still allocate their values
+       * @pre This variable has no domain or its domain is on the heap
+       * @post If this call throws, the domain of this variable is 
+       *       unchanged
        */
-      static DomainBase *clone(boost::call_traits<Variable::domain_ptr>::param_type dom);
+      void copy_domain(Variable const &other);
+      /** @brief Destroy the domain of this variable */
+      void reset_domain();
       
       /** @brief Constructor
        * @param name A symbolic name
@@ -367,6 +367,8 @@ py_reactor::py_reactor(xml_arg_type arg)
 :TeleoReactor(arg, false, true) {
   try {
     boost::property_tree::ptree::value_type &node = xml_factory::node(arg);
+    // the python code has no way to notify its work: poll it by default
+    set_polled(parse_attr<bool>(true, node, "poll"));
     std::string class_name = parse_attr<std::string>(node, "python_class");
     boost::optional<std::string> source = parse_attr< boost::optional<std::string> >(node, "file");
     
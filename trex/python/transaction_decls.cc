@@ -78,8 +78,8 @@ namespace {
     return reinterpret_cast<unsigned long long>(g.get());
   }
   
-  observation_id obs_from_xml(boost::property_tree::ptree::value_type &node) {
-    return observation_id(new Observation(node));
+  SHARED_PTR<Observation> obs_from_xml(boost::property_tree::ptree::value_type &node) {
+    return SHARED_PTR<Observation>(new Observation(node));
   }
   goal_id goal_from_xml(boost::property_tree::ptree::value_type &node) {
     return goal_id(new Goal(node));
@@ -186,7 +186,7 @@ void export_transactions() {
    *    - __init__(self, predicate)
    *    - __init__(self, symbol, symbol)
    */
-  bp::class_<Observation, observation_id, bp::bases<Predicate> >
+  bp::class_<Observation, SHARED_PTR<Observation>, bp::bases<Predicate> >
   ("obs", "trex observation.\n\n"
    "A Trex observation is a predicate that applies to the current tick.\n"
    "It is the state value of the timeline self.object",
@@ -86,10 +86,9 @@ Goal::Goal(boost::property_tree::ptree::value_type &node)
    m_end(s_endName, s_dateDomain) {
   iterator iStart = find(s_startName), 
     iDuration, iEnd;
-  iterator const endi = end();
   IntegerDomain dStart(s_dateDomain), dDuration(s_durationDomain),
     dEnd(s_dateDomain);
-  if( endi!=iStart ) {
+  if( end()!=iStart ) {
     try {
       dStart.restrictWith(iStart->second.domain());
     } catch( EmptyDomain const &e ) {
@@ -98,7 +97,7 @@ Goal::Goal(boost::property_tree::ptree::value_type &node)
     remove(iStart);
   }
   iDuration = find(s_durationName);
-  if( endi!=iDuration ) {
+  if( end()!=iDuration ) {
     try {
       dDuration.restrictWith(iDuration->second.domain());
     } catch( EmptyDomain const &e ) {
@@ -107,7 +106,7 @@ Goal::Goal(boost::property_tree::ptree::value_type &node)
     remove(iDuration);
   }
   iEnd = find(s_endName);
-  if( endi!=iEnd ) {
+  if( end()!=iEnd ) {
     try {
       dEnd.restrictWith(iEnd->second.domain());
     } catch( EmptyDomain const &e ) {
@@ -32,6 +32,8 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  */
 #include "LogPlayer.hh"
+#include "private/log_stream.hh"
+
 #include <set>
 
 
@@ -536,82 +538,96 @@ TeleoReactor::xml_arg_type &LogPlayer::alter_cfg(TeleoReactor::xml_arg_type &arg
 // structors
 
 LogPlayer::LogPlayer(TeleoReactor::xml_arg_type arg)
-:TeleoReactor(arg, false, false) {
+:TeleoReactor(arg, false, false),
+m_loading(0),
+m_window(utils::parse_attr<TICK>(10, xml_factory::node(arg), "window")),
+m_start(utils::parse_attr<TICK>(0, xml_factory::node(arg), "start")),
+m_phases(0), m_partial(false), m_work(false), m_inited(false) {
   std::string
   file_name = utils::parse_attr<std::string>(getName().str()+".tr.log",
                                              xml_factory::node(arg),
                                              "file");
   bool found;
-  file_name = manager().use(file_name, found);
-  if( !found ) {
+  std::string located = manager().use(file_name, found);
+  if( !found ) // the log may have been compressed
+    located = manager().use(file_name+".gz", found);
+  if( found )
+    file_name = located;
+  else {
     syslog(null, error)<<"Unable to locate transaction log \""
     <<file_name<<"\".";
     throw ReactorException(*this,
                            "Unable to locate specified transaction log file.");
   }
-  boost::property_tree::ptree pt;
-  read_xml(file_name, pt, xml::no_comments|xml::trim_whitespace);
-  
-  if( pt.empty() ) {
-    syslog(null, error)<<"Transaction log \""<<file_name<<"\" is empty.";
-    throw ReactorException(*this, "Empty transaction log file.");
-  }
-  if( pt.size()!=1 ) {
-    syslog(null, error)<<"Transaction log \""<<file_name
-    <<"\" has multiple xml trees.";
-    throw ReactorException(*this, "Invalid transaction log file.");
-  }
-  if( pt.front().first!="Log" )
-    syslog(null, warn)<<"root tag \""<<pt.front().first<<"\" is not Log.";
-  pt = pt.front().second;
-  
-  // Play the header
-  boost::property_tree::ptree::assoc_iterator i, last;
-  boost::tie(i, last) = pt.equal_range("header");
-  if( last!=i ) {
-    typedef details::tr_event::factory                  tr_fact;
-    typedef boost::property_tree::ptree::iterator iter;
-    utils::SingletonUse<tr_fact> event_f;
-    iter pos = i->second.begin();
-    LogPlayer *me = this;
-    tr_fact::iter_traits<iter>::type
-    it = tr_fact::iter_traits<iter>::build(pos, me);
-    SHARED_PTR<details::tr_event> event;
-    while( event_f->iter_produce(it, i->second.end(), event) )
-      event->play();
-  }
+  if( m_window<1 )
+    throw utils::XmlError(xml_factory::node(arg),
+                          "LogPlayer window should be at least 1 tick.");
+  // replay the workRatio evaluations of the log instead of notifying work
+  set_polled(utils::parse_attr<bool>(true, xml_factory::node(arg), "poll"));
   
-  // Load the ticks
-  boost::tie(i, last) = pt.equal_range("tick");
-  bool first = true;
-  for( ; last!=i; ++i) {
-    TICK cur = utils::parse_attr<TICK>(*i, "value");
-    for(boost::property_tree::ptree::iterator j=i->second.begin();
-        i->second.end()!=j; ++j) {
-      if( s_init==j->first ) {
-        if( !first )
-          throw utils::XmlError(*j, s_init.str()+" tag can only be the first phase.");
-      } else if( "<xmlattr>"==j->first )
-        continue;
-      else if( s_new_tick!=j->first &&
-              s_synchronize!=j->first &&
-              s_has_work!=j->first &&
-              s_step!=j->first ) {
-        syslog(null, warn)<<"Skipping unknown phase \""<<j->first<<"\".";
-        continue;
+  if( utils::parse_attr<bool>(false, xml_factory::node(arg), "stream") ) {
+    boost::property_tree::ptree pt;
+    
+    m_stream.reset(new details::log_stream(file_name));
+    if( m_stream->header(pt) )
+      play_header(pt.front());
+    if( m_stream->next(pt) && load_tick(pt.front())<m_start ) {
+      // Only the init phase is kept: jump directly to m_start
+      std::string index;
+      if( utils::parse_attr<bool>(true, xml_factory::node(arg), "index") )
+        index = file_name+".idx";
+      if( index.empty() || !m_stream->load_index(index) ) {
+        syslog(null, info)<<"Indexing ticks of \""<<file_name<<"\".";
+        m_stream->build_index();
+        if( !index.empty() && !m_stream->save_index(index) )
+          syslog(null, warn)<<"Failed to write tick index \""<<index<<"\".";
       }
-      first = false;
-      SHARED_PTR<phase> p(new phase(this, *j));
-      m_log.push_back(std::make_pair(cur, p));
+      m_stream->seek_tick(m_start);
+      m_partial = true;
     }
+    syslog(null, info)<<"Streaming \""<<file_name<<"\" from tick "
+    <<m_start<<" with a look ahead of "<<m_window<<" ticks.";
+  } else {
+    boost::property_tree::ptree pt;
+    utils::log_ifstream in(file_name);
+    
+    if( !in )
+      throw ReactorException(*this, "Unable to open transaction log \""+
+                             file_name+"\".");
+    read_xml(in, pt, xml::no_comments|xml::trim_whitespace);
+    
+    if( pt.empty() ) {
+      syslog(null, error)<<"Transaction log \""<<file_name<<"\" is empty.";
+      throw ReactorException(*this, "Empty transaction log file.");
+    }
+    if( pt.size()!=1 ) {
+      syslog(null, error)<<"Transaction log \""<<file_name
+      <<"\" has multiple xml trees.";
+      throw ReactorException(*this, "Invalid transaction log file.");
+    }
+    if( pt.front().first!="Log" )
+      syslog(null, warn)<<"root tag \""<<pt.front().first<<"\" is not Log.";
+    pt = pt.front().second;
+    
+    // Play the header
+    boost::property_tree::ptree::assoc_iterator i, last;
+    boost::tie(i, last) = pt.equal_range("header");
+    if( last!=i )
+      play_header(*i);
+    
+    // Load the ticks
+    boost::tie(i, last) = pt.equal_range("tick");
+    for( ; last!=i; ++i)
+      load_tick(*i);
+    if( m_log.empty() )
+      syslog(null, warn)<<" this reactor has no event to play.";
+    else
+      syslog(null, info)<<"Loaded "<<m_log.size()<<" phases from tick "
+      <<m_log.front().first<<" to tick "
+      <<m_log.back().first;
+    // all the events are built: their goals are no longer needed here
+    m_goal_map.clear();
   }
-  if( m_log.empty() )
-    syslog(null, warn)<<" this reactor has no event to play.";
-  else
-    syslog(null, info)<<"Loaded "<<m_log.size()<<" phases from tick "
-    <<m_log.front().first<<" to tick "
-    <<m_log.back().first;
-  m_goal_map.clear();
 }
 
 LogPlayer::~LogPlayer() {
@@ -619,8 +635,96 @@ LogPlayer::~LogPlayer() {
 
 // manipulators
 
+void LogPlayer::play_header(boost::property_tree::ptree::value_type &node) {
+  typedef details::tr_event::factory                  tr_fact;
+  typedef boost::property_tree::ptree::iterator iter;
+  utils::SingletonUse<tr_fact> event_f;
+  iter pos = node.second.begin();
+  LogPlayer *me = this;
+  tr_fact::iter_traits<iter>::type
+  it = tr_fact::iter_traits<iter>::build(pos, me);
+  SHARED_PTR<details::tr_event> event;
+  while( event_f->iter_produce(it, node.second.end(), event) )
+    event->play();
+}
+
+TICK LogPlayer::load_tick(boost::property_tree::ptree::value_type &node) {
+  TICK cur = utils::parse_attr<TICK>(node, "value");
+  
+  m_loading = cur;
+  for(boost::property_tree::ptree::iterator j=node.second.begin();
+      node.second.end()!=j; ++j) {
+    if( s_init==j->first ) {
+      if( m_phases>0 )
+        throw utils::XmlError(*j, s_init.str()+" tag can only be the first phase.");
+    } else if( "<xmlattr>"==j->first )
+      continue;
+    else if( s_new_tick!=j->first &&
+            s_synchronize!=j->first &&
+            s_has_work!=j->first &&
+            s_step!=j->first ) {
+      syslog(null, warn)<<"Skipping unknown phase \""<<j->first<<"\".";
+      continue;
+    } else if( cur<m_start ) {
+      // only the init phase is replayed before m_start
+      m_partial = true;
+      continue;
+    }
+    SHARED_PTR<phase> p(new phase(this, *j));
+    m_log.push_back(std::make_pair(cur, p));
+    ++m_phases;
+  }
+  return cur;
+}
+
+bool LogPlayer::load_next() {
+  if( NULL!=m_stream.get() ) {
+    boost::property_tree::ptree pt;
+    if( m_stream->next(pt) ) {
+      load_tick(pt.front());
+      return true;
+    }
+    if( m_stream->truncated() )
+      syslog(null, warn)<<"Transaction log ends with an incomplete tick.";
+    m_stream.reset();
+  }
+  return false;
+}
+
+bool LogPlayer::fill(TICK tck) {
+  if( NULL!=m_stream.get() ) {
+    bool loaded = false;
+    
+    while( m_log.empty() && load_next() )
+      loaded = true;
+    if( !m_log.empty() ) {
+      // keep m_window ticks ahead of the earliest tick of interest
+      TICK start = std::min(tck, m_log.front().first);
+      while( m_log.back().first<start+m_window && load_next() )
+        loaded = true;
+      if( loaded )
+        forget_goals(start);
+    }
+  }
+  return !m_log.empty();
+}
+
+void LogPlayer::forget_goals(TICK tck) {
+  while( !m_created.empty() && m_created.front().tick<tck ) {
+    boost::unordered_map<std::string, goal_id>::iterator 
+      i = m_goal_map.find(m_created.front().key);
+    
+    // the goal may already be recalled or its key reused by a newer goal
+    if( m_goal_map.end()!=i && i->second==m_created.front().goal ) {
+      m_forgotten.insert(i->first);
+      m_goal_map.erase(i);
+    }
+    m_created.pop_front();
+  }
+}
+
 bool LogPlayer::next_phase(TICK tck, utils::Symbol const &kind) {
-  if( !m_log.empty() ) {
+  if( fill(tck) ) {
     if( m_log.front().first==tck  ) {
       SHARED_PTR<phase> nxt = m_log.front().second;
       if( nxt->type()==kind ) {
@@ -651,7 +755,7 @@ void LogPlayer::handleTickStart() {
   if( !next_phase(getCurrentTick(), s_new_tick) ) {
     size_t skipped =0;
     std::ostringstream oss;
-    while( !m_log.empty() && m_log.front().first<getCurrentTick() ) {
+    while( fill(getCurrentTick()) && m_log.front().first<getCurrentTick() ) {
       oss<<"\n\t- ["<<m_log.front().first<<"]: "
       <<m_log.front().second->type();
       size_t n = m_log.front().second->execute();
@@ -730,7 +834,8 @@ void LogPlayer::play_request(goal_id const &g) {
 }
 
 void LogPlayer::play_recall(goal_id const &g) {
-  postRecall(g);
+  if( g )
+    postRecall(g);
 }
 
 void LogPlayer::play_add(goal_id const &g) {
@@ -738,7 +843,8 @@ void LogPlayer::play_add(goal_id const &g) {
 }
 
 void LogPlayer::play_cancel(goal_id const &g) {
-  cancelPlanToken(g);
+  if( g )
+    cancelPlanToken(g);
 }
 
 using namespace TREX::transaction::details;
@@ -752,23 +858,56 @@ using namespace TREX::transaction::details;
 tr_event::tr_event(tr_event::factory::argument_type const &arg)
 :m_reactor(*(arg.second)) {}
 
+// observers
+
+bool tr_event::partial() const {
+  return m_reactor.m_partial;
+}
+
 // manipulators
 
 goal_id tr_event::get_goal(std::string const &key) {
-  std::map<std::string, goal_id>::const_iterator
+  boost::unordered_map<std::string, goal_id>::const_iterator
   i =  m_reactor.m_goal_map.find(key);
   if( m_reactor.m_goal_map.end()!=i )
     return i->second;
+  if( forgotten(key) )
+    m_reactor.syslog(null, info)<<"Goal "<<key
+    <<" is no longer tracked: ignored.";
+  else if( partial() )
+    m_reactor.syslog(null, warn)<<"Goal "<<key
+    <<" was created before the replay start: ignored.";
   return goal_id();
 }
 
 
 void tr_event::set_goal(std::string const &key, goal_id const &g) {
-  std::map<std::string, goal_id>::iterator i;
+  boost::unordered_map<std::string, goal_id>::iterator i;
   bool inserted;
   boost::tie(i, inserted) = m_reactor.m_goal_map.insert(std::make_pair(key, g));
   if( !inserted )
     i->second = g;
+  if( streaming() ) {
+    m_reactor.m_created.push_back(LogPlayer::created_goal(m_reactor.m_loading,
+                                                          key, g));
+    // the key now refers to this new goal
+    m_reactor.m_forgotten.erase(key);
+  }
+}
+
+void tr_event::forget_goal(std::string const &key) {
+  if( streaming() ) {
+    m_reactor.m_goal_map.erase(key);
+    m_reactor.m_forgotten.erase(key);
+  }
+}
+
+bool tr_event::forgotten(std::string const &key) const {
+  return m_reactor.m_forgotten.end()!=m_reactor.m_forgotten.find(key);
+}
+
+bool tr_event::streaming() const {
+  return NULL!=m_reactor.m_stream.get();
 }
 
 
@@ -804,8 +943,10 @@ tr_goal_event::tr_goal_event(tr_goal_event::factory::argument_type const &arg,
     set_goal(id, m_goal);
   } else {
     m_goal = get_goal(id);
-    if( !m_goal )
+    if( !( m_goal || partial() || forgotten(id) ) )
       throw utils::XmlError(factory::node(arg),
                             "Unable to find goal for id \""+id+"\".");
+    // a goal is recalled or cancelled only once
+    forget_goal(id);
   }
 }
@@ -36,6 +36,11 @@
 
 # include "TeleoReactor.hh"
 
+# include <boost/unordered_map.hpp>
+# include <boost/unordered_set.hpp>
+
+# include <deque>
+
 namespace TREX {
   namespace transaction {
 
@@ -43,6 +48,8 @@ namespace TREX {
 
     namespace details {
 
+      class log_stream;
+
       /** @brief Transaction event
        * 
        * And abstarct class that decibe a transaction event to be 
@@ -83,6 +90,14 @@ namespace TREX {
 	virtual void play() =0;
 
       protected:
+	/** @brief Partial replay
+	 *
+	 * @retval true if the LogPlayer skipped a part of the log
+	 * @retval false otherwise
+	 *
+	 * @sa LogPlayer::m_partial
+	 */
+	bool partial() const;
 	/** @brief Get a goal
 	 * 
 	 * @param[in] key A key identifiying the goal in the log
@@ -111,6 +126,31 @@ namespace TREX {
 	 * @sa LogPLayer::m_goal_map
 	 */
 	void set_goal(std::string const &key, goal_id const &g);
+	/** @brief Forget a goal
+	 *
+	 * @param[in] key A key
+	 *
+	 * Removes the association of @p key in streaming mode as the 
+	 * event being built is the last expected reference to it.
+	 *
+	 * @sa LogPlayer::forget_goals(TICK)
+	 */
+	void forget_goal(std::string const &key);
+	/** @brief Check for a forgotten goal
+	 *
+	 * @param[in] key A key
+	 *
+	 * @retval true if @p key referred to a goal that was removed by 
+	 *   LogPlayer::forget_goals(TICK) and has not been reused since
+	 * @retval false otherwise
+	 */
+	bool forgotten(std::string const &key) const;
+	/** @brief Check for streaming mode
+	 *
+	 * @retval true if the LogPlayer loads the log incrementally
+	 * @retval false otherwise
+	 */
+	bool streaming() const;
 
 	/** @briefAssociated LogPlayer
 	 * 
@@ -146,7 +186,8 @@ namespace TREX {
        * @p arg. The XML format is:
        * @code 
        * <LogPlayer name="<name>" latency="<latency>" lookahead="<lookahead>"
-       *            file="<logfile>" />
+       *            file="<logfile>" stream="<bool>" window="<ticks>"
+       *            start="<tick>" index="<bool>" />
        * @endcode 
        * Where:
        * @li @c <name> is the reactor name
@@ -155,7 +196,25 @@ namespace TREX {
        * @li @c <logfile> is an optional attribute pointing 
        *     to the transaction log file to replay. If this 
        *     is not specified then the reactor will olook for 
-       *     @c <name>.tr.log
+       *     @c <name>.tr.log. The log can be gzip compressed and/or 
+       *     split in multiple files as produced by amc when logs are 
+       *     compressed or rotated; @c <logfile>.gz is used if 
+       *     @c <logfile> does not exist.
+       * @li @c stream is an optional flag (default @c 0). When set the 
+       *     log is not loaded at once but read incrementally as the 
+       *     agent progress, which allows to replay very long logs 
+       *     with a bounded memory footprint. Goals are then only 
+       *     tracked until their first recall or until the tick they 
+       *     were posted leaves the window: a later recall or 
+       *     cancellation of such goal is ignored
+       * @li @c window is the number of ticks the streaming mode loads 
+       *     ahead of the current tick (default @c 10)
+       * @li @c start is an optional tick. All the ticks before it -- 
+       *     except the @c init phase -- are skipped. In streaming mode 
+       *     this is done without parsing these ticks.
+       * @li @c index indicates if the tick index file @c <logfile>.idx 
+       *     should be used, and created when missing or outdated, to 
+       *     locate @c start in streaming mode (default @c 1)
        * 
        * @pre the log file loaded is a valid transaction log file.
        *
@@ -311,7 +370,76 @@ namespace TREX {
 
       typedef std::pair< TICK, SHARED_PTR<phase> > tick_event;
       std::list<tick_event>    m_log;
-      std::map<std::string, goal_id> m_goal_map;
+      boost::unordered_map<std::string, goal_id> m_goal_map;
+
+      /** @brief Goal creation record
+       *
+       * Identifies a goal of m_goal_map along with the tick it was 
+       * created in the log.
+       */
+      struct created_goal {
+        created_goal(TICK t, std::string const &k, goal_id const &g)
+        :tick(t), key(k), goal(g) {}
+        
+        TICK        tick;
+        std::string key;
+        goal_id     goal;
+      };
+      /** @brief Goals created in the streaming window
+       *
+       * The goals created by the ticks loaded in streaming mode, 
+       * ordered by tick.
+       *
+       * @sa forget_goals(TICK)
+       */
+      std::deque<created_goal> m_created;
+      /** @brief Forgotten goals
+       *
+       * The keys of the goals removed by forget_goals(TICK). As these 
+       * keys are the addresses of the goals when the log was produced 
+       * they are reused over time which bounds this set.
+       */
+      boost::unordered_set<std::string> m_forgotten;
+      /** @brief Tick being loaded */
+      TICK m_loading;
+
+      /** @brief Incremental log reader
+       *
+       * The log being read in streaming mode. It is reset once 
+       * the end of the log is reached.
+       */
+      UNIQ_PTR<details::log_stream> m_stream;
+      /** @brief Streaming look ahead
+       *
+       * The number of ticks loaded ahead of the current tick 
+       * in streaming mode
+       */
+      TICK m_window;
+      /** @brief First replayed tick */
+      TICK m_start;
+      /** @brief Number of phases loaded so far */
+      size_t m_phases;
+      /** @brief Partial replay flag
+       *
+       * Indicates that a part of the log has been skipped. In that 
+       * case recalls or cancellation of goals that were created in 
+       * this part are ignored.
+       */
+      bool m_partial;
+
+      void play_header(boost::property_tree::ptree::value_type &node);
+      TICK load_tick(boost::property_tree::ptree::value_type &node);
+      bool load_next();
+      bool fill(TICK tck);
+      /** @brief Forget old goals
+       *
+       * @param[in] tck The start of the streaming window
+       *
+       * Remove from m_goal_map all the goals created before @p tck.
+       * This bounds the size of m_goal_map in streaming mode. A later 
+       * recall or cancellation of one of these goals is ignored.
+       */
+      void forget_goals(TICK tck);
 
       bool next_phase(TICK tck, utils::Symbol const &kind); 
       bool in_tick(TICK tck) const;
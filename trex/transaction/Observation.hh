@@ -113,7 +113,13 @@ namespace TREX {
     
     /** @brief An observation id
      *
-     * A type (not yet) used to refer to a specific observation.
+     * A type used to refer to a specific observation.
+     * This is the way observations are stored and passed within the 
+     * transaction layer: a single instance is shared between the timeline,
+     * all its clients and the transaction log. It gives therefore only a
+     * read access to the observation, which has to be fully built before
+     * being posted.
+     *
      * This class is part of a long term plan t orefactor observations
      * in a similar way goals are manipulated in ucrrent trex version.
      * While there is not plan yet on when this will be done, we do
@@ -123,8 +129,9 @@ namespace TREX {
      *
      * @relates class Observation
      * @sa goal_id
+     * @sa TeleoReactor::postObservation(observation_id const &, bool)
      */
-    typedef SHARED_PTR<Observation> observation_id;
+    typedef SHARED_PTR<Observation const> observation_id;
     
   } // TREX::transaction
 } // TREX
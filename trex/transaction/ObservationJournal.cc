@@ -0,0 +1,209 @@
+/** @file ObservationJournal.cc
+ * @brief Implementation of the observation journal
+ *
+ * @ingroup transaction
+ */
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "ObservationJournal.hh"
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <sstream>
+
+using namespace TREX::transaction::obs_journal;
+using TREX::utils::Symbol;
+using TREX::utils::async_ofstream;
+using TREX::transaction::TICK;
+
+namespace {
+  
+  void escape(std::ostream &out, std::string const &str) {
+    for(std::string::const_iterator i=str.begin(); str.end()!=i; ++i) {
+      switch( *i ) {
+        case '\t':
+          out<<"\\t";
+          break;
+        case '\n':
+          out<<"\\n";
+          break;
+        case '\\':
+          out<<"\\\\";
+          break;
+        default:
+          out.put(*i);
+      }
+    }
+  }
+  
+  std::string unescape(std::string const &str, size_t from) {
+    std::string ret;
+    ret.reserve(str.length()-from);
+    for(size_t i=from; i<str.length(); ++i) {
+      if( '\\'==str[i] && i+1<str.length() ) {
+        switch( str[++i] ) {
+          case 't':
+            ret.push_back('\t');
+            break;
+          case 'n':
+            ret.push_back('\n');
+            break;
+          default:
+            ret.push_back(str[i]);
+        }
+      } else
+        ret.push_back(str[i]);
+    }
+    return ret;
+  }
+  
+  TREX::utils::Exception bad_line(size_t line, std::string const &msg) {
+    std::ostringstream oss;
+    oss<<"obs_journal: line "<<line<<": "<<msg;
+    return TREX::utils::Exception(oss.str());
+  }
+  
+} // ::
+
+/*
+ * class TREX::transaction::obs_journal::writer
+ */
+
+// structors
+
+writer::writer(std::string const &file, boost::asio::io_service &io)
+:m_io(io), m_file(MAKE_SHARED<async_ofstream>(boost::ref(io), file)) {
+  *m_file<<"# tick\ttimeline\tpredicate\tattribute:type=domain ...\n";
+}
+
+writer::~writer() {
+  m_file->flush();
+}
+
+// manipulators
+
+void writer::write(TICK date, writer::batch_type const &batch) {
+  // formatting is done by the file writer
+  boost::asio::use_service<async_ofstream::service>(m_io).post(boost::bind(&writer::format, m_file, date, batch));
+}
+
+void writer::format(SHARED_PTR<async_ofstream> file, TICK date,
+                    writer::batch_type const &batch) {
+  async_ofstream::entry e = file->new_entry();
+  std::ostream &out = e.stream();
+  std::ostringstream dom;
+  
+  dom.precision(10);
+  for(batch_type::const_iterator o=batch.begin(); batch.end()!=o; ++o) {
+    out<<date<<'\t'<<(*o)->object()<<'\t'<<(*o)->predicate();
+    for(Predicate::const_iterator a=(*o)->begin(); (*o)->end()!=a; ++a) {
+      if( a->second.isComplete() ) {
+        DomainBase const &d = a->second.domain();
+        
+        out<<'\t'<<a->first<<':'<<d.getTypeName()<<'=';
+        dom.str(std::string());
+        dom<<d;
+        escape(out, dom.str());
+      }
+    }
+    out<<'\n';
+  }
+}
+
+/*
+ * class TREX::transaction::obs_journal::reader
+ */
+
+// structors
+
+reader::reader(std::string const &file)
+:m_in(file), m_from(std::numeric_limits<TICK>::min()),
+ m_to(std::numeric_limits<TICK>::max()), m_line(0) {
+  if( !m_in )
+    throw TREX::utils::Exception("Unable to open observation journal \""+file+"\".");
+}
+
+// manipulators
+
+bool reader::next(record &rec) {
+  std::string line;
+  
+  while( std::getline(m_in, line) ) {
+    ++m_line;
+    if( line.empty() || '#'==line[0] )
+      continue;
+    size_t tl = line.find('\t'), pred;
+    if( std::string::npos==tl ||
+        std::string::npos==(pred=line.find('\t', tl+1)) )
+      throw bad_line(m_line, "missing columns");
+    TICK date;
+    try {
+      date = boost::lexical_cast<TICK>(line.substr(0, tl));
+    } catch(boost::bad_lexical_cast const &) {
+      throw bad_line(m_line, "invalid tick \""+line.substr(0, tl)+"\"");
+    }
+    if( date<m_from )
+      continue;
+    if( date>m_to )
+      return false; // records are sorted by tick
+    Symbol timeline(line.substr(tl+1, pred-tl-1));
+    if( !( m_timelines.empty() || m_timelines.count(timeline) ) )
+      continue;
+    
+    size_t end = line.find('\t', pred+1);
+    rec.tick = date;
+    rec.timeline = timeline;
+    rec.predicate = Symbol(line.substr(pred+1, end-pred-1));
+    rec.attributes.clear();
+    while( std::string::npos!=end ) {
+      size_t first = end+1, colon, eq;
+      std::string field;
+      
+      end = line.find('\t', first);
+      field = line.substr(first, end-first);
+      colon = field.find(':');
+      eq = field.find('=', colon);
+      if( std::string::npos==colon || std::string::npos==eq )
+        throw bad_line(m_line, "invalid attribute \""+field+"\"");
+      attribute attr;
+      attr.name = Symbol(field.substr(0, colon));
+      attr.type = Symbol(field.substr(colon+1, eq-colon-1));
+      attr.domain = unescape(field, eq+1);
+      rec.attributes.push_back(attr);
+    }
+    return true;
+  }
+  return false;
+}
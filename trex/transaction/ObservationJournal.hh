@@ -0,0 +1,222 @@
+/** @file trex/transaction/ObservationJournal.hh
+ * @brief Agent observation journal
+ *
+ * This file defines the journal used to record all the observations 
+ * of an agent along with a reader to iterate through it.
+ *
+ * @ingroup transaction
+ */
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef H_trex_transaction_ObservationJournal
+# define H_trex_transaction_ObservationJournal
+
+# include "Observation.hh"
+# include "Tick.hh"
+
+# include <trex/utils/asio_fstream.hh>
+# include <trex/utils/log_ifstream.hh>
+
+# include <limits>
+# include <set>
+# include <vector>
+
+namespace TREX {
+  namespace transaction {
+    /** @brief Observation journal
+     *
+     * The journal records all the observations produced by the reactors 
+     * of an agent in a single machine friendly file. Each observation 
+     * is one line of tab separated columns:
+     * @code
+     * <tick>	<timeline>	<predicate>	<attr>:<type>=<domain>	...
+     * @endcode
+     * with one column per attribute of the observation. Tabs, new lines 
+     * and backslashes appearing in a domain are escaped with a 
+     * backslash. Lines starting with @c # are comments.
+     *
+     * The records are sorted by tick: all the observations produced 
+     * by a reactor during its synchronization are written together 
+     * after it completed.
+     *
+     * @ingroup transaction
+     */
+    namespace obs_journal {
+      
+      /** @brief Journal attribute
+       *
+       * The value of an observation attribute as recorded in the journal
+       */
+      struct attribute {
+        /** @brief attribute name */
+        utils::Symbol name;
+        /** @brief attribute domain type name */
+        utils::Symbol type;
+        /** @brief textual domain */
+        std::string   domain;
+      }; // TREX::transaction::obs_journal::attribute
+      
+      /** @brief Journal record
+       *
+       * A single observation as recorded in the journal
+       */
+      struct record {
+        /** @brief tick of the observation */
+        TICK                   tick;
+        /** @brief timeline observed */
+        utils::Symbol          timeline;
+        /** @brief predicate observed */
+        utils::Symbol          predicate;
+        /** @brief observation attributes sorted by name */
+        std::vector<attribute> attributes;
+      }; // TREX::transaction::obs_journal::record
+      
+      /** @brief Observation journal writer
+       *
+       * Write observation batches into the journal. The batches are 
+       * formatted and written asynchronously by the async_ofstream 
+       * service so the reactors do not pay for it during their 
+       * synchronization.
+       *
+       * @ingroup transaction
+       */
+      class writer :boost::noncopyable {
+      public:
+        typedef std::vector<observation_id> batch_type;
+        
+        /** @brief Constructor
+         *
+         * @param[in] file The journal file name
+         * @param[in] io The asio service used to write the file
+         */
+        writer(std::string const &file, boost::asio::io_service &io);
+        /** @brief Destructor */
+        ~writer();
+        
+        /** @brief Write a batch
+         *
+         * @param[in] date The tick of the observations
+         * @param[in] batch A set of observations
+         *
+         * Queue the observations in @p batch to be written in the 
+         * journal as observed at @p date
+         */
+        void write(TICK date, batch_type const &batch);
+        
+      private:
+        static void format(SHARED_PTR<utils::async_ofstream> file, TICK date,
+                           batch_type const &batch);
+        
+        boost::asio::io_service          &m_io;
+        SHARED_PTR<utils::async_ofstream> m_file;
+      }; // TREX::transaction::obs_journal::writer
+      
+      /** @brief Observation journal reader
+       *
+       * Iterates through the records of a journal, optionally 
+       * restricted to a set of timelines and a tick range. The journal 
+       * can be compressed and/or rotated.
+       *
+       * @code
+       * obs_journal::reader r("observations.tsv");
+       * obs_journal::record rec;
+       *
+       * r.select("navigator");
+       * r.range(100, 200);
+       * while( r.next(rec) ) 
+       *   std::cout<<rec.tick<<' '<<rec.predicate<<std::endl;
+       * @endcode
+       *
+       * @ingroup transaction
+       */
+      class reader :boost::noncopyable {
+      public:
+        /** @brief Constructor
+         *
+         * @param[in] file The journal file name
+         *
+         * @throw utils::Exception Unable to open @p file
+         */
+        explicit reader(std::string const &file);
+        /** @brief Destructor */
+        ~reader() {}
+        
+        /** @brief Select a timeline
+         *
+         * @param[in] tl A timeline name
+         *
+         * Add @p tl to the timelines to iterate. If no timeline was 
+         * selected all of them are iterated
+         */
+        void select(utils::Symbol const &tl) {
+          m_timelines.insert(tl);
+        }
+        /** @brief Set tick range
+         *
+         * @param[in] from first tick
+         * @param[in] to last tick
+         *
+         * Restrict the iteration to the records in [@p from, @p to]
+         */
+        void range(TICK from, TICK to=std::numeric_limits<TICK>::max()) {
+          m_from = from;
+          m_to = to;
+        }
+        
+        /** @brief Next record
+         *
+         * @param[out] rec A record
+         *
+         * Read the next record of the journal that matches the current 
+         * selection and range into @p rec
+         *
+         * @retval true if a record was read
+         * @retval false if no record is left in the selection
+         *
+         * @throw utils::Exception A line of the journal is malformed
+         */
+        bool next(record &rec);
+        
+      private:
+        utils::log_ifstream     m_in;
+        std::set<utils::Symbol> m_timelines;
+        TICK                    m_from, m_to;
+        size_t                  m_line;
+      }; // TREX::transaction::obs_journal::reader
+      
+    } // TREX::transaction::obs_journal
+  } // TREX::transaction
+} // TREX
+
+#endif // H_trex_transaction_ObservationJournal
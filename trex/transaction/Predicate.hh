@@ -50,6 +50,7 @@
 
 // put it this way to avoid conflict with Europa
 # include <trex/domain/Variable.hh>
+# include <trex/utils/flat_map.hh>
 
 namespace TREX {
   namespace transaction {
@@ -96,8 +97,23 @@ namespace TREX {
      */
     class Predicate :public TREX::utils::ostreamable, public TREX::utils::ptree_convertible {
     protected:
-      /** @brief Type used to store predicate attributes */
-      typedef std::map<TREX::utils::Symbol, Variable> attr_set;
+      /** @brief Type used to store predicate attributes 
+       *
+       * Attributes are stored sorted by name in a flat array which keeps 
+       * the first few of them inline. Most predicates have only a handful 
+       * of attributes which then require no extra allocation.
+       *
+       * The lexical order is kept on purpose instead of Symbol::id_less: 
+       * the attributes are listed in this order in the XML and JSON 
+       * output and in the transaction logs, while symbol ids depend on 
+       * creation order which can vary between runs. Lookups do not pay 
+       * for it as long as the predicate has at most 16 attributes since 
+       * they then use a linear scan comparing symbols by identity.
+       *
+       * @note Unlike the @c std::map used previously, adding an 
+       * attribute invalidates the iterators on the attributes.
+       */
+      typedef TREX::utils::flat_map<TREX::utils::Symbol, Variable, 4> attr_set;
       
     public:
       /** @brief Predicate attributes' iterator */
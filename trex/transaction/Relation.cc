@@ -57,11 +57,11 @@ utils::Symbol const timeline::s_failed(Predicate::failed_pred());
 
 timeline::timeline(TICK date, utils::Symbol const &name)
   :m_name(name), m_owner(NULL), m_plan_listeners(0),
-   m_last_obs(Observation(name, Predicate::failed_pred())), m_obs_date(date), m_shouldPrint(false) {}
+   m_last_obs(MAKE_SHARED<Observation>(name, Predicate::failed_pred())), m_obs_date(date), m_shouldPrint(false) {}
 
 timeline::timeline(TICK date, utils::Symbol const &name, TeleoReactor &serv, transaction_flags const &flags)
   :m_name(name), m_owner(&serv), m_transactions(flags), m_plan_listeners(0), 
-   m_last_obs(Observation(name, Predicate::failed_pred())), m_obs_date(date), m_shouldPrint(false)  {}
+   m_last_obs(MAKE_SHARED<Observation>(name, Predicate::failed_pred())), m_obs_date(date), m_shouldPrint(false)  {}
 
 timeline::~timeline() {
   // maybe some clean-up to do (?)
@@ -127,7 +127,7 @@ TeleoReactor *timeline::unassign(TICK date) {
     m_owner->unassigned(this);
     m_owner = NULL;
     m_transactions.reset();
-    postObservation(Observation(name(), Predicate::failed_pred()));
+    postObservation(MAKE_SHARED<Observation>(name(), Predicate::failed_pred()));
     synchronize(date);
     latency_update(ret->getExecLatency());
   }
@@ -176,9 +176,12 @@ void timeline::unsubscribe(Relation const &rel) {
   m_clients.erase(rel.m_pos);
 }
 
-void timeline::postObservation(Observation const &obs,
+void timeline::postObservation(observation_id const &obs,
 			       bool verbose) {
-  verbose = verbose || ( owned() && owner().is_verbose() );
+  // Observations are echoed in the syslog only when requested or if
+  // there is no journal to record them
+  verbose = verbose || ( owned() && ( owner().is_verbose() || 
+                                      !owner().getGraph().has_journal() ) );
 
 #if 0
   if( m_next_obs && owned() )
@@ -194,12 +197,17 @@ void timeline::synchronize(TICK date) {
     m_last_obs = m_next_obs;
     m_obs_date = date;
     m_next_obs.reset();
-    if( owned() )
-      owner().syslog(name(), TeleoReactor::obs)<<(*m_last_obs);
-    else {
+    if( owned() ) {
+      if( m_shouldPrint )
+        owner().syslog(name(), TeleoReactor::obs)<<(*m_last_obs);
+      m_shouldPrint = false;
+    } else {
       static utils::SingletonUse<utils::LogManager> s_log;
       s_log->syslog(date, name(), utils::log::error)<<(*m_last_obs);
     }
+    // let the clients know that they have a new observation
+    for(client_set::const_iterator i=m_clients.begin(); m_clients.end()!=i; ++i)
+      i->first->external_updated(this);
   }
 }
 
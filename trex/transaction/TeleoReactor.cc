@@ -37,15 +37,19 @@
  *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  *  POSSIBILITY OF SUCH DAMAGE.
  */
+#include <algorithm>
 #include <utility>
 #include <cmath>
 
 // #include <boost/chrono/clock_string.hpp>
 
 #include "TeleoReactor.hh"
+#include "TransactionLog.hh"
 #include <trex/domain/FloatDomain.hh>
 
+#include <boost/exception/diagnostic_information.hpp>
 #include <boost/scope_exit.hpp>
+#include <boost/thread/tss.hpp>
 
 #include <bitset>
 
@@ -55,9 +59,87 @@ namespace utils=TREX::utils;
 namespace TREX {
   namespace transaction {
     
+    namespace {
+      
+      void no_cleanup(TeleoReactor *) {}
+      
+      /** @brief Reactor currently batching in this thread
+       *
+       * The reactor which is executing either synchronize() or resume()
+       * in the current thread if any.
+       */
+      boost::thread_specific_ptr<TeleoReactor> s_batching(&no_cleanup);
+      
+      typedef utils::SharedVar< boost::unordered_set<size_t> > name_snapshot;
+      
+      bool snapshot_contains(name_snapshot &names, Symbol const &name) {
+        name_snapshot::scoped_lock lock(names);
+        return names->end()!=names->find(name.id());
+      }
+      
+    }
+    
+    /** @brief Transactions batching scope
+     *
+     * Marks the current thread as executing @p r. During the lifetime of
+     * this instance the batchable transactions posted by @p r from this 
+     * thread are queued into its outbox. The owner calls flush() once the 
+     * reactor callback has completed, which applies them to the graph 
+     * and rethrows the first exception they produced. 
+     *
+     * If the scope is left through an exception the outbox is still 
+     * applied on destruction but its own errors are only logged as the 
+     * callback exception is already being reported.
+     *
+     * @ingroup transaction
+     */
+    class TeleoReactor::batch_scope :boost::noncopyable {
+    public:
+      explicit batch_scope(TeleoReactor &r)
+        :m_reactor(r), m_prev(s_batching.get()), m_active(true) {
+        s_batching.reset(&m_reactor);
+      }
+      ~batch_scope() {
+        if( m_active ) {
+          s_batching.reset(m_prev);
+          try {
+            m_reactor.flush_outbox();
+          } catch(utils::Exception const &e) {
+            m_reactor.syslog(error)<<"Exception caught while applying pending transactions: "<<e;
+          } catch(std::exception const &se) {
+            m_reactor.syslog(error)<<"C++ exception caught while applying pending transactions: "
+              <<se.what();
+          } catch(...) {
+            m_reactor.syslog(error)<<"Unknown exception caught while applying pending transactions.";
+          }
+        }
+      }
+      
+      /** @brief End of the batch
+       *
+       * @param[in] publish Also publish the updated observations
+       *
+       * Stop batching and apply the queued transactions
+       *
+       * @sa TeleoReactor::flush_outbox(bool)
+       * @throw The first exception produced while applying them
+       */
+      void flush(bool publish=false) {
+        m_active = false;
+        s_batching.reset(m_prev);
+        m_reactor.flush_outbox(publish);
+      }
+      
+    private:
+      TeleoReactor &m_reactor;
+      TeleoReactor *m_prev;
+      bool          m_active;
+    };
+    
     class TeleoReactor::Logger {
     public:
-      Logger(std::string const &dest, boost::asio::io_service &io);
+      Logger(std::string const &dest, boost::asio::io_service &io,
+             bool binary);
       ~Logger();
       
       void provide(Symbol const &name, bool goals, bool plan);
@@ -75,7 +157,7 @@ namespace TREX {
       void work(bool ret);
       void step();
       
-      void observation(Observation const &obs);
+      void observation(observation_id const &obs);
       void request(goal_id const &goal);
       void recall(goal_id const &goal);
       
@@ -87,8 +169,34 @@ namespace TREX {
       void horizon_updated(TICK val);
       
     private:
-      boost::asio::strand           m_strand;
-      utils::async_ofstream         m_file;
+      /** @brief Log file sink
+       *
+       * The device used to write the log output into the log file. 
+       * As the stream using it is buffered, each write here is a whole 
+       * buffer of the stream that is passed to the file as a single 
+       * entry.
+       */
+      class file_sink {
+      public:
+        typedef char                       char_type;
+        typedef boost::iostreams::sink_tag category;
+        
+        explicit file_sink(utils::async_ofstream &dest)
+        :m_dest(&dest) {}
+        
+        std::streamsize write(char_type const *s, std::streamsize n) {
+          m_dest->new_entry().write(s, n);
+          return n;
+        }
+        
+      private:
+        utils::async_ofstream *m_dest;
+      };
+      
+      boost::asio::strand                  m_strand;
+      utils::async_ofstream                m_file;
+      boost::iostreams::stream<file_sink>  m_stream;
+      UNIQ_PTR<tr_log::writer>             m_out;
       
       enum {
         header      = 0,
@@ -100,19 +208,11 @@ namespace TREX {
       
       std::bitset<5> m_flags;
       
-      enum tick_phase {
-        in_init,
-        in_new_tick,
-        in_synchronize,
-        in_work,
-        in_step
-      };
-      
-      tick_phase m_phase;
+      tr_log::phase m_phase;
       TICK m_current;
       
-      void obs(Observation o);
-      void goal_event(std::string tag, goal_id g, bool full);
+      void obs(observation_id o);
+      void goal_event(tr_log::goal_event kind, goal_id g);
       
       void post_event(boost::function<void ()> fn);
       void phase_event(boost::function<void ()> fn);
@@ -122,10 +222,8 @@ namespace TREX {
       void close_phase();
       void close_tick();
       
-      void set_tick(TICK val, tick_phase p);
-      void set_phase(tick_phase p);
-      void direct_write(std::string const &content, bool nl);
-      
+      void set_tick(TICK val, tr_log::phase p);
+      void set_phase(tr_log::phase p);
     };
     
   }
@@ -160,19 +258,56 @@ std::string DispatchError::build_msg(goal_id const &g, std::string const &msg) t
 
 
 /*
- * class TREX::transaction::details::external
+ * class TREX::transaction::details::goal_queue
  */
 
-bool TREX::transaction::details::external::cmp_goals(IntegerDomain const &a, IntegerDomain const &b) {
-  // sorting order
-  //   - based on upperBound
-  //   - if same upperBound : sorted based on lower bound
-  //
-  // this way I can safely update lower bounds without impacting tokens order
-  return a.upperBound()<b.upperBound() ||
-    ( a.upperBound()==b.upperBound() && a.lowerBound()<b.lowerBound() );
+// modifiers
+
+bool details::goal_queue::insert(goal_id const &g) {
+  index_type::iterator pos = m_index.find(g);
+  
+  if( m_index.end()==pos ) {
+    IntegerDomain const &start(g->getStart());
+    // sorting order
+    //   - based on upperBound
+    //   - if same upperBound : sorted based on lower bound
+    //
+    // this way I can safely update lower bounds without impacting tokens order
+    key_type key(start_type(start.upperBound(), start.lowerBound()), m_seq++);
+    
+    // as for the former list this insert g after the goals with the same 
+    // start as its insertion number is the largest
+    m_index.insert(std::make_pair(g, key));
+    m_queue.insert(slot(key), entry_type(key, value_type(g, true)));
+    return true;
+  }
+  return false;
+}
+
+bool details::goal_queue::erase(goal_id const &g) {
+  index_type::iterator pos = m_index.find(g);
+  
+  if( m_index.end()!=pos ) {
+    m_queue.erase(slot(pos->second));
+    m_index.erase(pos);
+    return true;
+  }
+  return false;
 }
 
+details::goal_queue::iterator details::goal_queue::erase(details::goal_queue::iterator pos) {
+  m_index.erase(pos->second.first);
+  return m_queue.erase(pos);
+}
+
+void details::goal_queue::clear() {
+  m_index.clear();
+  m_queue.clear();
+}
+
+/*
+ * class TREX::transaction::details::external
+ */
 
 // structors
 
@@ -187,53 +322,40 @@ TREX::transaction::details::external::external(details::external_set::iterator c
                                                details::external_set::iterator const &last)
   :m_pos(pos), m_last(last) {}
 
-// manipulators
-
-details::goal_queue::iterator details::external::lower_bound(IntegerDomain const &dom) {
-  details::goal_queue::iterator i = m_pos->second.begin();
-
-  for(; m_pos->second.end()!=i && cmp_goals(i->first->getStart(), dom); ++i);
-  return i;
-}
-
 // modifiers
 
 bool details::external::post_goal(goal_id const &g) {
-  IntegerDomain const &g_start(g->getStart());
-  // locate goal position
-  details::goal_queue::iterator i = lower_bound(g_start);
-
-  // check that it is not already posted
-  for( ; m_pos->second.end()!=i && !cmp_goals(g_start, i->first->getStart()); ++i)
-    if( g==i->first )
-      return false;
-  // insert the new goal
-  m_pos->second.insert(i, std::make_pair(g, true));
-  if( m_pos->first.client().is_verbose() ) {
-    syslog(info)<<m_pos->first.client().getName()
-      <<" added "<<g->predicate()<<'['<<g<<"] to the pending queue of "
-      <<m_pos->first.name();
-  }
+  if( !m_pos->second.insert(g) )
+    return false;
+  // only formatted for a verbose reactor or in debug mode
+  syslog(m_pos->first.client().is_verbose()?info:utils::log::debug)
+    <<m_pos->first.client().getName()
+    <<" added "<<g->predicate()<<'['<<g<<"] to the pending queue of "
+    <<m_pos->first.name();
   return true;
 }
 
+bool details::external::pending(goal_id const &g) {
+  return m_pos->second.contains(g);
+}
+
 void details::external::dispatch(TICK current, details::goal_queue &sent) {
   details::goal_queue::iterator i=m_pos->second.begin();
   IntegerDomain dispatch_w = m_pos->first.dispatch_window(current);
 
-  for( ; m_pos->second.end()!=i && i->first->startsBefore(dispatch_w.upperBound());  ) {
-    bool future = i->first->startsAfter(current);
+  for( ; m_pos->second.end()!=i && i->second.first->startsBefore(dispatch_w.upperBound());  ) {
+    goal_id const &g = i->second.first;
+    bool future = g->startsAfter(current);
 
-    if( future || i->first->endsAfter(current+1) ) {
+    if( future || g->endsAfter(current+1) ) {
       // Need to check for dispatching
-        if( i->second && m_pos->first.accept_goals() ) {
-          if( m_pos->first.client().is_verbose() )
-            syslog(info)<<"Dispatching "<<i->first->predicate()
-                        <<'['<<(i->first)<<"] on \""
-                        <<m_pos->first.name()<<"\".";
+        if( i->second.second && m_pos->first.accept_goals() ) {
+          syslog(m_pos->first.client().is_verbose()?info:utils::log::debug)
+            <<"Dispatching "<<g->predicate()<<'['<<g<<"] on \""
+            <<m_pos->first.name()<<"\".";
           bool posted = false;
           try {
-            m_pos->first.request(i->first);
+            m_pos->first.request(g);
             posted = true;
             i = m_pos->second.erase(i);
           } catch(utils::Exception const &e) {
@@ -246,13 +368,13 @@ void details::external::dispatch(TICK current, details::goal_queue &sent) {
           }
           if( !posted ) {
             syslog(warn)<<"Marking goal as non-postable.";
-            i->second = false;
+            i->second.second = false;
           }
         } else
           ++i;
     } else if( !future ) {
-      syslog(warn)<<"Goal "<<i->first->predicate()<<'['<<(i->first)
-                  <<"] is in the past: removing it\n\t"<<(*(i->first));
+      syslog(warn)<<"Goal "<<g->predicate()<<'['<<g
+                  <<"] is in the past: removing it\n\t"<<(*g);
       i = m_pos->second.erase(i);
     } else if( !m_pos->first.accept_goals() )
       break; // no need to  look further ... this guy do not accept goals
@@ -263,23 +385,14 @@ void details::external::unblock() {
   // just mark all the 
   for(details::goal_queue::iterator i=m_pos->second.begin();
       m_pos->second.end()!=i; ++i) 
-    i->second = true;
+    i->second.second = true;
 }
 
 void details::external::recall(goal_id const &g) {
-  IntegerDomain const &g_start(g->getStart());
-  // locate goal position
-  details::goal_queue::iterator i = lower_bound(g_start);
-  for( ; m_pos->second.end()!=i && !cmp_goals(g_start, i->first->getStart()); 
-       ++i) {
-    if( g==i->first ) {
-      // was still pending => just remove it
-      m_pos->second.erase(i);
-      return;
-    }
-  }
-  // not found => send a recall
-  m_pos->first.recall(g);
+  // was still pending => just remove it
+  if( !m_pos->second.erase(g) ) 
+    // not found => send a recall
+    m_pos->first.recall(g);
 }
 
 void details::external::increment() {
@@ -321,6 +434,7 @@ TeleoReactor::TeleoReactor(TeleoReactor::xml_arg_type &arg, bool loadTL,
    m_have_goals(0),
    m_verbose(utils::parse_attr<bool>(arg.second->is_verbose(),
                                      xml_factory::node(arg), "verbose")),
+   m_polled(utils::parse_attr<bool>(false, xml_factory::node(arg), "poll")),
    m_trLog(NULL),
    m_name(utils::parse_attr<Symbol>(xml_factory::node(arg), "name")),
    m_latency(utils::parse_attr<TICK>(xml_factory::node(arg), "latency")),
@@ -335,9 +449,17 @@ TeleoReactor::TeleoReactor(TeleoReactor::xml_arg_type &arg, bool loadTL,
   m_stat_log<<"tick, tick_ns, tick_rt_ns, synch_ns, synch_rt_ns, delib_ns, delib_rt_ns, n_steps\n";
      
   if( utils::parse_attr<bool>(log_default, node, "log") ) {
-    std::string base = getName().str()+".tr.log";
+    std::string format = utils::parse_attr<std::string>("xml", node,
+                                                        "log_format");
+    bool binary = ("binary"==format);
+    
+    if( !( binary || "xml"==format ) )
+      throw utils::XmlError(node, "Unknown transaction log format \""+
+                            format+"\"");
+    
+    std::string base = getName().str()+(binary?".tr.bin":".tr.log");
     fname = manager().file_name(base);
-    m_trLog = new Logger(fname.string(), manager().service());
+    m_trLog = new Logger(fname.string(), manager().service(), binary);
     utils::LogManager::path_type cfg = manager().file_name("cfg"), 
       pwd = boost::filesystem::current_path(), 
       short_name(base), location("../"+base);
@@ -376,7 +498,8 @@ TeleoReactor::TeleoReactor(graph *owner, Symbol const &name,
                            TICK latency, TICK lookahead, bool log)
   :m_inited(false), m_firstTick(true), m_graph(*owner),
    m_have_goals(0),
-   m_verbose(owner->is_verbose()), m_trLog(NULL), m_name(name),
+   m_verbose(owner->is_verbose()), m_polled(false), m_trLog(NULL),
+   m_name(name),
    m_latency(latency), m_maxDelay(0), m_lookahead(lookahead),
    m_nSteps(0), m_stat_log(m_log->service()) {
   utils::LogManager::path_type fname = file_name("stat.csv");
@@ -384,7 +507,7 @@ TeleoReactor::TeleoReactor(graph *owner, Symbol const &name,
      
   if( log ) {
     fname = manager().file_name(getName().str()+".tr.log");
-    m_trLog = new Logger(fname.string(), manager().service());
+    m_trLog = new Logger(fname.string(), manager().service(), false);
     syslog(info)<<"Transactions logged to "<<fname;
 
   }
@@ -475,6 +598,11 @@ void TeleoReactor::queue(std::list<goal_id> &l, goal_id g) {
     *m_have_goals += 1;
   }
   l.push_back(g);
+  notifyWork();
+}
+
+void TeleoReactor::notifyWork() {
+  m_graph.work_available(this);
 }
 
 
@@ -504,10 +632,9 @@ double TeleoReactor::workRatio() {
 
   if( have_goals() ) {
     // Start to flush goals
-    boost::function<void ()> fn(boost::bind(&TeleoReactor::goal_flush, this,
-                                            boost::ref(m_sync_goals),
-                                            boost::ref(tmp)));
-    utils::strand_run(m_graph.strand(), fn);
+    utils::strand_run(m_graph.strand(),
+                      boost::bind(&TeleoReactor::goal_flush, this,
+                                  boost::ref(m_sync_goals), boost::ref(tmp)));
     
     while( !tmp.empty() ) {
       handleRequest(tmp.front());
@@ -516,10 +643,9 @@ double TeleoReactor::workRatio() {
   }
   if( have_goals() ) {
     // Start to flush recalls
-    boost::function<void ()> fn(boost::bind(&TeleoReactor::goal_flush, this,
-                                            boost::ref(m_sync_recalls),
-                                            boost::ref(tmp)));
-    utils::strand_run(m_graph.strand(), fn);
+    utils::strand_run(m_graph.strand(),
+                      boost::bind(&TeleoReactor::goal_flush, this,
+                                  boost::ref(m_sync_recalls), boost::ref(tmp)));
     while( !tmp.empty() ) {
       handleRecall(tmp.front());
       tmp.pop_front();
@@ -527,10 +653,9 @@ double TeleoReactor::workRatio() {
   }
   if( have_goals() ) {
     // Start to flush plan tokens
-    boost::function<void ()> fn(boost::bind(&TeleoReactor::goal_flush, this,
-                                            boost::ref(m_sync_toks),
-                                            boost::ref(tmp)));
-    utils::strand_run(m_graph.strand(), fn);
+    utils::strand_run(m_graph.strand(),
+                      boost::bind(&TeleoReactor::goal_flush, this,
+                                  boost::ref(m_sync_toks), boost::ref(tmp)));
     while( !tmp.empty() ) {
       newPlanToken(tmp.front());
       tmp.pop_front();
@@ -538,10 +663,9 @@ double TeleoReactor::workRatio() {
   }
   if( have_goals() ) {
     // Start to flush plan tokens
-    boost::function<void ()> fn(boost::bind(&TeleoReactor::goal_flush, this,
-                                            boost::ref(m_sync_cancels),
-                                            boost::ref(tmp)));
-    utils::strand_run(m_graph.strand(), fn);
+    utils::strand_run(m_graph.strand(),
+                      boost::bind(&TeleoReactor::goal_flush, this,
+                                  boost::ref(m_sync_cancels), boost::ref(tmp)));
     while( !tmp.empty() ) {
       cancelPlanToken(tmp.front());
       tmp.pop_front();
@@ -574,16 +698,9 @@ double TeleoReactor::workRatio() {
       }
       return 1.0/ret;
     } else {
-      // Dispatched goals management
-      details::external i = ext_begin();
-      details::goal_queue dispatched; // store the goals that got dispatched 
-                                      // on this tick ...
-                                      // I do nothing with it for now
-      
-      // Manage goal dispatching
-      for( ; i.valid(); ++i )
-        i.dispatch(getCurrentTick()+1, dispatched);
-        
+      // Deliberation is over: send the goals that are now ready
+      utils::strand_run(m_graph.strand(),
+                        boost::bind(&TeleoReactor::dispatch_sync, this));
     }
   } catch(std::exception const &se) {
     syslog(warn)<<"Exception during hasWork question: "<<se.what();
@@ -600,22 +717,34 @@ double TeleoReactor::workRatio() {
   return NAN;
 }
 
-void TeleoReactor::observation_sync(Observation o, bool verbose) {
-  internal_set::iterator i = m_internals.find(o.object());
+void TeleoReactor::observation_sync(observation_id o, bool verbose) {
+  internal_set::iterator i = m_internals.find(o->object());
   
   if( m_internals.end()==i )
     throw boost::enable_current_exception(SynchronizationError(*this, "attempted to post observation on "+
-                               o.object().str()+" which is not Internal."));
+                               o->object().str()+" which is not Internal."));
   
   (*i)->postObservation(o, verbose);
   m_updates.insert(*i);
 }
 
 void TeleoReactor::postObservation(Observation const &obs, bool verbose) {
-  boost::function<void ()> fn(boost::bind(&TeleoReactor::observation_sync,
-                                          this, obs, verbose));
-  // m_graph.strand().dispatch(fn);
-  utils::strand_run(m_graph.strand(), fn);
+  postObservation(MAKE_SHARED<Observation>(obs), verbose);
+}
+
+void TeleoReactor::postObservation(observation_id const &obs, bool verbose) {
+  if( !obs )
+    throw SynchronizationError(*this, "attempted to post an invalid observation.");
+  if( batching() ) {
+    // check ownership now as the transaction is applied later
+    if( !snapshot_contains(m_int_names, obs->object()) )
+      throw SynchronizationError(*this, "attempted to post observation on "+
+                                 obs->object().str()+" which is not Internal.");
+    m_outbox.push_back(outbox_entry(obs, verbose));
+  } else {
+    utils::strand_run(m_graph.strand(),
+                      boost::bind(&TeleoReactor::observation_sync, this, obs, verbose));
+  }
 }
 
 bool TeleoReactor::goal_sync(goal_id g) {
@@ -629,10 +758,27 @@ bool TeleoReactor::goal_sync(goal_id g) {
 }
 
 
+void TeleoReactor::dispatch_sync() {
+  details::external i = ext_begin();
+  details::goal_queue dispatched; // store the goals that got dispatched 
+                                  // on this tick ...
+                                  // I do nothing with it for now
+  
+  // Manage goal dispatching
+  for( ; i.valid(); ++i )
+    i.dispatch(getCurrentTick()+1, dispatched);
+}
+
 bool TeleoReactor::postGoal(goal_id const &g) {
   if( !g )
     throw DispatchError(*this, g, "Invalid goal Id");
-
+  if( batching() ) {
+    // check ownership now as the transaction is applied later
+    if( !snapshot_contains(m_ext_names, g->object()) )
+      throw DispatchError(*this, g, "Goals can only be posted on External timelines");
+    m_outbox.push_back(outbox_entry(outbox_entry::goal, g));
+    return true;
+  }
   boost::function<bool ()> fn(boost::bind(&TeleoReactor::goal_sync,
                                           this, g));
   return utils::strand_run(m_graph.strand(), fn);
@@ -669,6 +815,13 @@ bool TeleoReactor::recall_sync(goal_id g) {
 bool TeleoReactor::postRecall(goal_id const &g) {
   if( !g )
     return false;
+  if( batching() ) {
+    // check ownership now as the transaction is applied later
+    if( !snapshot_contains(m_ext_names, g->object()) )
+      return false;
+    m_outbox.push_back(outbox_entry(outbox_entry::recall, g));
+    return true;
+  }
   boost::function<bool ()> fn(boost::bind(&TeleoReactor::recall_sync,
                                           this, g));
   return utils::strand_run(m_graph.strand(), fn);
@@ -702,7 +855,16 @@ void TeleoReactor::cancel_sync(goal_id tok) {
 bool TeleoReactor::postPlanToken(goal_id const &t) {
   if( !t )
     throw DispatchError(*this, t, "Invalid token id");
-  
+  if( batching() ) {
+    // check ownership now as the transaction is applied later
+    if( !snapshot_contains(m_int_names, t->object()) )
+      throw DispatchError(*this, t, "plan tokens can only be posted on Internal timelines.");
+    // the tick does not change during the batch
+    if( t->getEnd().upperBound() <= getCurrentTick() )
+      return false;
+    m_outbox.push_back(outbox_entry(outbox_entry::plan, t));
+    return true;
+  }
   boost::function<bool ()> fn(boost::bind(&TeleoReactor::plan_sync,
                                           this, t));
   return utils::strand_run(m_graph.strand(), fn);
@@ -719,12 +881,83 @@ goal_id TeleoReactor::postPlanToken(Goal const &g) {
 
 void TeleoReactor::cancelPlanToken(goal_id const &g) {
   if( g ) {
-    boost::function<void ()> fn(boost::bind(&TeleoReactor::cancel_sync,
-                                            this, g));
-    utils::strand_run(m_graph.strand(), fn);
+    if( batching() )
+      m_outbox.push_back(outbox_entry(outbox_entry::cancel, g));
+    else {
+      boost::function<void ()> fn(boost::bind(&TeleoReactor::cancel_sync,
+                                              this, g));
+      utils::strand_run(m_graph.strand(), fn);
+    }
   }
 }
 
+bool TeleoReactor::batching() const {
+  return this==s_batching.get();
+}
+
+void TeleoReactor::flush_outbox(bool publish) {
+  publish = publish && !(m_outbox.empty() && m_updates.empty());
+  if( publish || !m_outbox.empty() ) {
+    boost::exception_ptr err = utils::strand_run(m_graph.strand(),
+                                                 boost::bind(&TeleoReactor::outbox_sync,
+                                                             this, publish));
+    if( err )
+      boost::rethrow_exception(err);
+  }
+}
+
+boost::exception_ptr TeleoReactor::outbox_sync(bool publish) {
+  boost::exception_ptr first;
+  
+  for(std::vector<outbox_entry>::const_iterator i=m_outbox.begin();
+      m_outbox.end()!=i; ++i) {
+    try {
+      switch( i->type ) {
+        case outbox_entry::observation:
+          observation_sync(i->obs, i->verbose);
+          break;
+        case outbox_entry::goal:
+          if( !goal_sync(i->id) )
+            syslog(warn)<<"Ignored goal "<<i->id->predicate()<<'['<<i->id
+              <<"] on "<<i->id->object()<<" which was already posted.";
+          break;
+        case outbox_entry::plan:
+          plan_sync(i->id);
+          break;
+        case outbox_entry::recall:
+          if( !recall_sync(i->id) )
+            syslog(warn)<<"Ignored recall of a goal on "<<i->id->object()
+              <<" which is not External.";
+          break;
+        default:
+          cancel_sync(i->id);
+      }
+    } catch(...) {
+      // keep the first error for the caller, only log the others
+      if( !first )
+        first = boost::current_exception();
+      else
+        syslog(error)<<"Additional error while applying pending transactions: "
+          <<boost::diagnostic_information(boost::current_exception());
+    }
+  }
+  m_outbox.clear();
+  if( publish && !first ) {
+    TICK now = getCurrentTick();
+    
+    m_published.reserve(m_updates.size());
+    for(internal_set::iterator i=m_updates.begin();
+        m_updates.end()!=i; ++i) {
+      (*i)->synchronize(now);
+      m_published.push_back((*i)->lastObservationId());
+      if( NULL!=m_trLog )
+        m_trLog->observation(m_published.back());
+    }
+    m_updates.clear();
+  }
+  return first;
+}
+
 
 TICK TeleoReactor::getFinalTick() const {
   TICK g_final = m_graph.finalTick();
@@ -861,28 +1094,37 @@ bool TeleoReactor::newTick() {
   return false;
 }
 
-void TeleoReactor::collect_obs_sync(std::list<Observation> &l) {
-  for(external_set::iterator i = m_externals.begin();
-      m_externals.end()!=i; ++i) {
-    // syslog(info)<<"Checking for new observation on "<<i->first.name();
-    if( i->first.lastObsDate()==getCurrentTick() ) {
-      // syslog(info)<<"Collecting new obs: "<<i->first.lastObservation();
-      l.push_back( i->first.lastObservation() );
-    } //else
-     // syslog(info)<<"Last observation date ("<<i->first.lastObsDate()<<") is before current tick";
-  }
+void TeleoReactor::external_updated(details::timeline *tl) {
+  m_ext_updates.push_back(tl);
+}
+
+void TeleoReactor::collect_obs_sync(std::list<observation_id> &l) {
+  TICK now = getCurrentTick();
   
+  if( m_ext_updates.size()>1 ) {
+    // put them back in the same order as m_externals and remove duplicates
+    utils::id_cmp<details::tl_ptr_id_traits> cmp((std::less<Symbol>()));
+    std::sort(m_ext_updates.begin(), m_ext_updates.end(), cmp);
+    m_ext_updates.erase(std::unique(m_ext_updates.begin(), m_ext_updates.end()),
+                        m_ext_updates.end());
+  }
+  for(std::vector<details::timeline *>::const_iterator i=m_ext_updates.begin();
+      m_ext_updates.end()!=i; ++i) {
+    // skip the ones that were updated after my last notification
+    if( (*i)->lastObsDate()==now )
+      l.push_back( (*i)->lastObservationId() );
+  }
+  m_ext_updates.clear();
 }
 
 
 void TeleoReactor::doNotify() {
-  std::list<Observation> obs;
-  boost::function<void ()> fn(boost::bind(&TeleoReactor::collect_obs_sync,
-                                          this, boost::ref(obs)));
-  utils::strand_run(m_graph.strand(), fn);
-  for(std::list<Observation>::const_iterator i=obs.begin(); obs.end()!=i; ++i) {
-    // syslog("NOTIFY")<<(*i);
-    notify(*i);
+  std::list<observation_id> obs;
+  utils::strand_run(m_graph.strand(),
+                    boost::bind(&TeleoReactor::collect_obs_sync, this, boost::ref(obs)));
+  for(std::list<observation_id>::const_iterator i=obs.begin(); obs.end()!=i; ++i) {
+    // syslog("NOTIFY")<<(**i);
+    notify(**i);
   }
 }
 
@@ -903,7 +1145,11 @@ bool TeleoReactor::doSynchronize() {
         // measure timing only for synchronization call
         utils::chronograph<rt_clock> real_time(m_synch_rt);
         utils::chronograph<stat_clock> usage(m_synch_usage);
+        batch_scope batch(*this);
         success = synchronize();
+        // apply the transactions and, on success, publish the new 
+        // observations in the same strand pass
+        batch.flush(success);
       }
       m_stat_log<<now<<", "<<m_start_usage.count()
       <<", "<<m_start_rt.count()
@@ -911,23 +1157,10 @@ bool TeleoReactor::doSynchronize() {
       <<", "<<m_synch_rt.count();
       stat_logged = true;
     }
-    if( success ) {
-      for(internal_set::iterator i=m_updates.begin();
-          m_updates.end()!=i; ++i) {
-        bool echo;
-        
-        boost::function<void ()> fn(boost::bind(&details::timeline::synchronize,
-                                                *i, now));
-        utils::strand_run(m_graph.strand(), fn);
-
-        Observation const &observ = (*i)->lastObservation(echo);
-        
-        // if( echo || is_verbose() || NULL==m_trLog )
-        //   syslog(obs)<<observ;
-        if( NULL!=m_trLog )
-          m_trLog->observation(observ);
-      }
-      m_updates.clear();
+    if( !m_published.empty() ) {
+      // record all the new observations at once
+      m_graph.journal(now, m_published);
+      m_published.clear();
     }
     m_obsTick = m_obsTick+1;
     
@@ -956,7 +1189,9 @@ void TeleoReactor::step() {
   {
     utils::chronograph<rt_clock> rt_chron(delta_rt);
     utils::chronograph<stat_clock> stat_chron(delta);
+    batch_scope batch(*this);
     resume();
+    batch.flush();
   }
   m_deliberation_usage += delta;
   m_delib_rt += delta_rt;
@@ -1077,11 +1312,16 @@ void TeleoReactor::clear_externals() {
 
 void TeleoReactor::assigned(details::timeline *tl) {
   m_internals.insert(tl);
+  {
+    name_snapshot::scoped_lock lock(m_int_names);
+    m_int_names->insert(tl->name().id());
+  }
   if( is_verbose() )
     syslog(null, info)<<"Declared \""<<tl->name()<<"\" with rights "<<tl->rights()<<".";
   if( NULL!=m_trLog ) {
     m_trLog->provide(tl->name(), tl->accept_goals(), tl->publish_plan());
   }
+  m_graph.structure_updated();
   for(graph::listen_set::const_iterator i=m_graph.m_listeners.begin();
       m_graph.m_listeners.end()!=i; ++i)
     (*i)->declared(*tl);
@@ -1090,11 +1330,16 @@ void TeleoReactor::assigned(details::timeline *tl) {
 void TeleoReactor::unassigned(details::timeline *tl) {
   internal_set::iterator i = m_internals.find(tl);
   m_internals.erase(i);
+  {
+    name_snapshot::scoped_lock lock(m_int_names);
+    m_int_names->erase(tl->name().id());
+  }
   if( is_verbose() )
     syslog(null, info)<<"Undeclared \""<<tl->name()<<"\".";
   if( NULL!=m_trLog ) {
     m_trLog->unprovide(tl->name());
   }
+  m_graph.structure_updated();
   for(graph::listen_set::const_iterator i=m_graph.m_listeners.begin();
       m_graph.m_listeners.end()!=i; ++i)
     (*i)->undeclared(*tl);
@@ -1104,6 +1349,12 @@ void TeleoReactor::subscribed(Relation const &r) {
   external_set::value_type tmp;
   tmp.first = r;
   m_externals.insert(tmp);
+  {
+    name_snapshot::scoped_lock lock(m_ext_names);
+    m_ext_names->insert(r.name().id());
+  }
+  // the timeline may already have an observation for this tick
+  m_ext_updates.push_back(r.m_timeline);
   latency_updated(0, r.latency());
   if( is_verbose() )
     syslog(null, info)<<"Subscribed to \""<<r.name()<<"\" with rights "
@@ -1111,6 +1362,7 @@ void TeleoReactor::subscribed(Relation const &r) {
   if( NULL!=m_trLog ) {
     m_trLog->use(r.name(), r.accept_goals(), r.accept_plan_tokens());
   }
+  m_graph.structure_updated();
   for(graph::listen_set::const_iterator i=m_graph.m_listeners.begin();
       m_graph.m_listeners.end()!=i; ++i) 
     (*i)->connected(r);
@@ -1126,11 +1378,18 @@ void TeleoReactor::unsubscribed(Relation const &r) {
   }
   // remove this relation
   m_externals.erase(i);
+  {
+    name_snapshot::scoped_lock lock(m_ext_names);
+    m_ext_names->erase(r.name().id());
+  }
+  m_ext_updates.erase(std::remove(m_ext_updates.begin(), m_ext_updates.end(),
+                                  r.m_timeline), m_ext_updates.end());
   if( is_verbose() ) 
     syslog(null, info)<<"Unsubscribed from \""<<r.name()<<"\".";
   if( NULL!=m_trLog ) {
     m_trLog->unuse(r.name());
   }
+  m_graph.structure_updated();
   for(graph::listen_set::const_iterator i=m_graph.m_listeners.begin();
       m_graph.m_listeners.end()!=i; ++i) 
     (*i)->disconnected(r);
@@ -1172,154 +1431,123 @@ void TeleoReactor::unblock(Symbol const &name) {
 
 // structors
 
-TeleoReactor::Logger::Logger(std::string const &dest, boost::asio::io_service &io)
-:m_strand(io), m_file(io, dest) {
+TeleoReactor::Logger::Logger(std::string const &dest, 
+                             boost::asio::io_service &io, bool binary)
+:m_strand(io), 
+ // the log is flushed explicitly at the end of every tick
+ m_file(io, dest, utils::async_ofstream::flush_policy(65536, CHRONO::milliseconds::zero())),
+ m_stream(file_sink(m_file), 65536) {
+  if( binary )
+    m_out.reset(new tr_log::binary_writer(m_stream));
+  else 
+    m_out.reset(new tr_log::xml_writer(m_stream));
   m_flags.set(header);
-  m_strand.post(boost::bind(&Logger::direct_write, this, "<Log>\n <header>",
-                            true));
+  m_strand.post(boost::bind(&tr_log::writer::open, m_out.get()));
 }
 
 TeleoReactor::Logger::~Logger() {
-  //std::cerr<<"Destroy logger "<<std::endl;
-  //std::cerr<<" - schedulle : close potential tick tag"<<std::endl;
-  
   m_strand.post(boost::bind(&Logger::close_tick, this));
-  //std::cerr<<" - build task : close the main tag"<<std::endl;
-  boost::packaged_task<void> close_xml(boost::bind(&Logger::direct_write,
-                                                   this, "</Log>",
-                                                   true));
-  //std::cerr<<" - get future of the task"<<std::endl;
-  boost::unique_future<void> completed = close_xml.get_future();
-  //std::cerr<<" - scedulled task execution"<<std::endl;
+  boost::packaged_task<void> close_log(boost::bind(&tr_log::writer::close,
+                                                   m_out.get()));
+  boost::unique_future<void> completed = close_log.get_future();
   m_strand.post(boost::bind(&boost::packaged_task<void>::operator(),
-                            boost::ref(close_xml)));
-  //std::cerr<<" - wait for task completion"<<std::endl;
+                            boost::ref(close_log)));
   completed.wait();
-  //std::cerr<<" - close the file"<<std::endl;
   m_file.close();
 }
 
 // interface
 
 void TeleoReactor::Logger::comment(std::string const &msg) {
-  m_strand.post(boost::bind(&Logger::direct_write, this, "<!-- "+msg+" -->",
-                            true));
+  m_strand.post(boost::bind(&tr_log::writer::comment, m_out.get(), msg));
 }
 
 void TeleoReactor::Logger::init(TICK val) {
-  m_strand.post(boost::bind(&Logger::set_tick, this, val, in_init));
+  m_strand.post(boost::bind(&Logger::set_tick, this, val, tr_log::in_init));
 }
 
 void TeleoReactor::Logger::newTick(TICK val) {
-  m_strand.post(boost::bind(&Logger::set_tick, this, val, in_new_tick));
+  m_strand.post(boost::bind(&Logger::set_tick, this, val, 
+                            tr_log::in_new_tick));
 }
 
 void TeleoReactor::Logger::synchronize() {
-  m_strand.post(boost::bind(&Logger::set_phase, this, in_synchronize));
+  m_strand.post(boost::bind(&Logger::set_phase, this, tr_log::in_synchronize));
 }
 
 void TeleoReactor::Logger::failed() {
-  post_event(boost::bind(&Logger::direct_write,
-                         this, "   <failed/>", true));
+  post_event(boost::bind(&tr_log::writer::failed, m_out.get()));
 }
 
 void TeleoReactor::Logger::has_work() {
-  m_strand.post(boost::bind(&Logger::set_phase, this, in_work));
+  m_strand.post(boost::bind(&Logger::set_phase, this, tr_log::in_work));
 }
 
 void TeleoReactor::Logger::step() {
-  m_strand.post(boost::bind(&Logger::set_phase, this, in_step));
+  m_strand.post(boost::bind(&Logger::set_phase, this, tr_log::in_step));
 }
 
 void TeleoReactor::Logger::work(bool ret) {
-  std::ostringstream oss;
-  oss<<"   <work value=\""<<ret<<"\" />";
-  post_event(boost::bind(&Logger::direct_write,
-                         this, oss.str(), true));
+  post_event(boost::bind(&tr_log::writer::work, m_out.get(), ret));
 }
 
 void TeleoReactor::Logger::provide(Symbol const &name, bool goals, bool plan) {
-  std::ostringstream oss;
-  oss<<"   <provide name=\""<<name
-  <<"\" goals=\""<<goals
-  <<"\" plan=\""<<plan<<"\" />";
-  post_event(boost::bind(&Logger::direct_write,
-                         this, oss.str(), true));
+  post_event(boost::bind(&tr_log::writer::provide, m_out.get(), 
+                         name, goals, plan));
 }
 
 void TeleoReactor::Logger::unprovide(Symbol const &name) {
-  std::ostringstream oss;
-  oss<<"   <unprovide name=\""<<name<<"\" />";
-  post_event(boost::bind(&Logger::direct_write,
-                         this, oss.str(), true));  
+  post_event(boost::bind(&tr_log::writer::unprovide, m_out.get(), name));
 }
 
 void TeleoReactor::Logger::use(Symbol const &name, bool goals, bool plan) {
-  std::ostringstream oss;
-  oss<<"   <use name=\""<<name
-  <<"\" goals=\""<<goals
-  <<"\" plan=\""<<plan<<"\" />";
-  post_event(boost::bind(&Logger::direct_write,
-                         this, oss.str(), true));
+  post_event(boost::bind(&tr_log::writer::use, m_out.get(), 
+                         name, goals, plan));
 }
 
 void TeleoReactor::Logger::unuse(Symbol const &name) {
-  std::ostringstream oss;
-  oss<<"   <unuse name=\""<<name<<"\" />";
-  post_event(boost::bind(&Logger::direct_write,
-                         this, oss.str(), true));
+  post_event(boost::bind(&tr_log::writer::unuse, m_out.get(), name));
 }
 
 void TeleoReactor::Logger::latency_updated(TICK val) {
-  std::ostringstream oss;
-  oss<<"   <latency value=\""<<val<<"\"/>";
-  post_event(boost::bind(&Logger::direct_write,
-                         this, oss.str(), true));
+  post_event(boost::bind(&tr_log::writer::latency, m_out.get(), val));
 }
 
 void TeleoReactor::Logger::horizon_updated(TICK val) {
-  std::ostringstream oss;
-  oss<<"   <horizon value=\""<<val<<"\"/>";
-  post_event(boost::bind(&Logger::direct_write,
-                         this, oss.str(), true));
+  post_event(boost::bind(&tr_log::writer::horizon, m_out.get(), val));
 }
 
 
-void TeleoReactor::Logger::observation(Observation const &o) {
+void TeleoReactor::Logger::observation(observation_id const &o) {
   post_event(boost::bind(&Logger::obs, this, o));
 }
 
 void TeleoReactor::Logger::request(goal_id const &goal) {
-  post_event(boost::bind(&Logger::goal_event, this, "request", goal, true));
+  post_event(boost::bind(&Logger::goal_event, this, tr_log::request, goal));
 }
 
 void TeleoReactor::Logger::recall(goal_id const &goal) {
-  post_event(boost::bind(&Logger::goal_event, this, "recall", goal, false));
+  post_event(boost::bind(&Logger::goal_event, this, tr_log::recall, goal));
 }
 
 void TeleoReactor::Logger::notifyPlan(goal_id const &tok) {
-  post_event(boost::bind(&Logger::goal_event, this, "token", tok, true));
+  post_event(boost::bind(&Logger::goal_event, this, tr_log::token, tok));
 }
 
 void TeleoReactor::Logger::cancelPlan(goal_id const &tok) {
-  post_event(boost::bind(&Logger::goal_event, this, "cancel", tok, false));
+  post_event(boost::bind(&Logger::goal_event, this, tr_log::cancel, tok));
 }
 
 
 // asio methods
 
-void TeleoReactor::Logger::obs(Observation o) {
-  utils::async_ofstream::entry e = m_file.new_entry();
-  o.to_xml(e.stream())<<'\n';
+void TeleoReactor::Logger::obs(observation_id o) {
+  m_out->observation(*o);
 }
 
 
-void TeleoReactor::Logger::goal_event(std::string tag, goal_id g, bool full) {
-  m_file<<"   <"<<tag<<" id=\""<<g<<"\" ";
-  if( full )
-    g->to_xml(m_file<<">\n")<<"\n   </"<<tag<<">\n";
-  else
-    direct_write("/>", true);
+void TeleoReactor::Logger::goal_event(tr_log::goal_event kind, goal_id g) {
+  m_out->goal(kind, g);
 }
 
 void TeleoReactor::Logger::post_event(boost::function<void ()> fn) {
@@ -1331,7 +1559,7 @@ void TeleoReactor::Logger::phase_event(boost::function<void ()> fn) {
   fn();
 }
 
-void TeleoReactor::Logger::set_tick(TICK val, TeleoReactor::Logger::tick_phase p) {
+void TeleoReactor::Logger::set_tick(TICK val, tr_log::phase p) {
   close_tick();
   m_current = val;
   m_phase = p;
@@ -1339,7 +1567,7 @@ void TeleoReactor::Logger::set_tick(TICK val, TeleoReactor::Logger::tick_phase p
   m_flags.set(in_phase);
 }
 
-void TeleoReactor::Logger::set_phase(TeleoReactor::Logger::tick_phase p) {
+void TeleoReactor::Logger::set_phase(tr_log::phase p) {
   close_phase();
   m_phase = p;
   m_flags.set(in_phase);
@@ -1348,25 +1576,7 @@ void TeleoReactor::Logger::set_phase(TeleoReactor::Logger::tick_phase p) {
 void TeleoReactor::Logger::open_phase() {
   if( m_flags.test(in_phase) && !m_flags.test(has_data) ) {
     open_tick();
-    switch( m_phase ) {
-      case in_init:
-        direct_write("  <init>", true);
-        break;
-      case in_new_tick:
-        direct_write("  <start>", true);
-        break;
-      case in_synchronize:
-        direct_write("  <synchronize>", true);
-        break;
-      case in_work:
-        direct_write("  <has_work>", true);
-        break;
-      case in_step:
-        direct_write("  <step>", true);
-        break;
-      default:
-        direct_write("  <unknown>", true);
-    }
+    m_out->open_phase(m_phase);
     m_flags.set(has_data);
   }
 }
@@ -1374,25 +1584,7 @@ void TeleoReactor::Logger::open_phase() {
 void TeleoReactor::Logger::close_phase() {
   if( m_flags.test(in_phase) ) {
     if( m_flags.test(has_data) ) {
-      switch( m_phase ) {
-        case in_init:
-          direct_write("  </init>", true);
-          break;
-        case in_new_tick:
-          direct_write("  </start>", true);
-          break;
-        case in_synchronize:
-          direct_write("  </synchronize>", true);
-          break;
-        case in_work:
-          direct_write("  </has_work>", true);
-          break;
-        case in_step:
-          direct_write("  </step>", true);
-          break;
-        default:
-          direct_write("  </unknown>", true);
-      }
+      m_out->close_phase(m_phase);
       m_flags.reset(has_data);
     }
     m_flags.reset(in_phase);
@@ -1401,7 +1593,7 @@ void TeleoReactor::Logger::close_phase() {
 
 void TeleoReactor::Logger::open_tick() {
   if( m_flags.test(tick) && !m_flags.test(tick_opened) ) {
-    m_file<<" <tick value=\""<<m_current<<"\">";
+    m_out->open_tick(m_current);
     m_flags.set(tick_opened);
   }
 }
@@ -1410,22 +1602,15 @@ void TeleoReactor::Logger::close_tick() {
   if( m_flags.test(tick) ) {
     if( m_flags.test(tick_opened) ) {
       close_phase();
-      direct_write(" </tick>", true);
-      // std::flush(m_file); // Flush the buffer at every tick
+      m_out->close_tick();
+      m_out->flush(); // Flush the buffer at every tick
+      m_file.flush();
     }
   } else if( m_flags.test(header) ) {
-    direct_write(" </header>", true);
+    m_out->end_header();
     m_flags.reset(header);
     m_flags.reset(in_phase);
   }
   m_flags.reset(tick);
   m_flags.reset(tick_opened);
 }
-
-void TeleoReactor::Logger::direct_write(std::string const &content, bool nl) {
-  utils::async_ofstream::entry e = m_file.new_entry();
-  
-  e.stream().write(content.c_str(), content.length());
-  if( nl )
-    e.stream().put('\n');
-}
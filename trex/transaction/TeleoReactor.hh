@@ -52,6 +52,9 @@
 # include <trex/utils/cpu_clock.hh>
 # include <trex/utils/asio_fstream.hh>
 
+# include <boost/exception_ptr.hpp>
+# include <boost/unordered_set.hpp>
+
 # if !defined(CPP11_HAS_CHRONO) && defined(BOOST_CHRONO_HAS_THREAD_CLOCK)
 #  include <boost/chrono/thread_clock.hpp>
 # endif
@@ -155,7 +158,8 @@ namespace TREX {
        * A typical reactor  definition is as follow
        * @code
        * < <RType> name="<name>" lookahead="<lookahead>" latency="<latency>"
-       *           config="<config>" log="<logflag>" verbose="<verbflag>" >
+       *           config="<config>" log="<logflag>" log_format="<format>"
+       *           verbose="<verbflag>" poll="<pollflag>" >
        *      <External name="<ename>" goals="<post goal flag>" />
        *      <Internal name="<iname>" />
        * </ <RType> >
@@ -169,11 +173,19 @@ namespace TREX {
        * @li @c @<logflag@> An optional flag used to indicate that observations and commands
        *                   issued from this reactor should be logged or not
        *                   (default is @p log_default)
+       * @li @c @<format@> An optional format for this log: either @c xml
+       *                   (the default) which produces @c @<name@>.tr.log or
+       *                   @c binary which produces the more compact
+       *                   @c @<name@>.tr.bin
        * @li @c @<config@> An optional extra file that extends the defintions
        *                    of this tag
        * @li @c @<verbflag@> An optional flag to indicates wheether this reactor
        *                     should be verbose in TREX.log or not. Defulat is
        *                     graph::is_verbose()
+       * @li @c @<pollflag@> An optional flag to indicate that this reactor
+       *                     does not always call notifyWork() when it gets
+       *                     new work and should be polled by the agent.
+       *                     Default is @c false
        *
        * If @p loadTL is true then that class will also parse the External
        *              and Internal tags in order to declare internal and
@@ -368,6 +380,22 @@ namespace TREX {
       TICK getLookAhead() const {
         return m_lookahead;
       }
+      /** @brief Check if polled for work
+       *
+       * Checks if this reactor is polled for work. The agent only 
+       * re-evaluates the workRatio of an idle reactor when it calls 
+       * notifyWork(), except for polled reactors which are re-evaluated 
+       * after each deliberation step. This is meant for reactors which 
+       * can get new work without notifying it.
+       *
+       * @retval true if the reactor is polled
+       * @retval false otherwise
+       * @sa set_polled(bool)
+       * @sa notifyWork()
+       */
+      bool is_polled() const {
+        return m_polled;
+      }
       /** @btrief New observation callback
        *
        * @param[in] obs An observation
@@ -596,6 +624,16 @@ namespace TREX {
       void reset_verbose() {
         m_verbose = m_graph.is_verbose();
       }
+      /** @brief set polling
+       * @param[in] flag polling flag
+       *
+       * Sets whether this reactor is polled for work. This is the 
+       * default when the @c poll attribute of the reactor is @c true.
+       * @sa is_polled() const
+       */
+      void set_polled(bool flag=true) {
+        m_polled = flag;
+      }
       
       /** @brief Check if need to deliberate
        *
@@ -617,6 +655,22 @@ namespace TREX {
       virtual bool hasWork() {
         return false;
       }
+      /** @brief Notify of new work
+       *
+       * Informs the agent that this reactor may now have work to do. 
+       * Outside of synchronization, the agent only re-evaluates the 
+       * workRatio of an idle reactor after this call -- as done when 
+       * the reactor receives new goals, recalls or plan tokens. A 
+       * reactor that gets new work by other means has to either call 
+       * this method or be polled.
+       *
+       * @note This method is thread safe
+       *
+       * @sa hasWork()
+       * @sa workRatio()
+       * @sa is_polled() const
+       */
+      void notifyWork();
       
       
       /** @brief Produce an observation
@@ -636,11 +690,33 @@ namespace TREX {
        *
        * @throw SynchronizationError attempt to post an observation in a timeline
        *        which is not @e Internal to this reactor.
+       *
+       * @note When called from synchronize() or resume() the observation 
+       *       is queued and applied when the callback returns.
        * @sa class Observation
        * @sa isInternal(TREX::utils::Symbol const &) const
        * @sa doNotify()
        */
       void postObservation(Observation const &o, bool verbose=false);
+      /** @brief Produce a shared observation
+       *
+       * @param[in] o An observation
+       * @param[in] verbose Echo the observation in TREX.log
+       *
+       * Same as postObservation(Observation const &, bool) but without 
+       * any copy of the observation: @p o is directly shared with the 
+       * @e Internal timeline, its clients and the transaction log.
+       *
+       * @pre @p o is a valid observation
+       * @pre @c o->object() is internal to this reactor
+       *
+       * @warning @p o should not be modified after this call
+       *
+       * @throw SynchronizationError attempt to post an observation in a timeline
+       *        which is not @e Internal to this reactor or @p o is not valid
+       * @sa postObservation(Observation const &, bool)
+       */
+      void postObservation(observation_id const &o, bool verbose=false);
       
       /** @brief Post a goal
        *
@@ -655,8 +731,12 @@ namespace TREX {
        *        timeline of this reactor
        *
        * @return true the goal has been succesfully posted and is queued for
-       *              dispatching
-       * @return false this goal id is already in the dispatching queue
+       *              dispatching. When called during synchronize() or 
+       *              resume() true only means that the goal was queued 
+       *              to be posted at the end of the call
+       * @return false this goal id is already in the dispatching queue. 
+       *              This is never returned when called during 
+       *              synchronize() or resume()
        *
        * @note sucessfully posting a goal do not gauarantee that this goal
        *       will be duispatched and even less executed. It can be already
@@ -664,6 +744,12 @@ namespace TREX {
        *       to be executed in current situation. As of today, the only way to
        *       check a goal has been executed is to wait for the corresponding
        *       observation unitl the maximum start time has been passed.
+       * @note When called during synchronize() or resume() the goal is 
+       *       only posted at the end of the call. A goal already in the 
+       *       dispatching queue is then ignored with a warning in the log
+       *       even though this call returned true. A caller that needs 
+       *       the actual outcome should call postGoal outside of these 
+       *       callbacks.
        *
        * @sa isExternal(TREX::utils::Symbol const &) const
        * @sa postRecall(goal_id const &)
@@ -711,6 +797,10 @@ namespace TREX {
        * @return false this token id is already broadcasted or its end time is
        *         in the past
        *
+       * @note When called during synchronize() or resume() the token is 
+       *       only posted at the end of the call and this call returns 
+       *       true even if the token was already broadcasted.
+       *
        * @sa isInternal(TREX::utils::Symbol const &) const
        * @sa cancelPlanToken(goal_id const &)
        */
@@ -745,6 +835,13 @@ namespace TREX {
        * @retval true the goal was sucessfully recalled
        * @retval false the goal was not valid or is not on an @e External timeline
        *
+       * @note When called from synchronize() or resume() the recall is 
+       *       queued and applied when the callback returns. True then 
+       *       only means that the goal is valid and on an @e External 
+       *       timeline of this reactor when the recall was queued. A 
+       *       recall that can no longer be applied at the end of the 
+       *       callback is ignored with a warning in the log.
+       *
        * @note The goal_id g should be @e execatly the one passed to postGoal (or returned
        *       by it).
        * @note As for postGoal sucessfully recalling a goal does not mean that it will
@@ -1045,13 +1142,110 @@ namespace TREX {
       void provide_sync(TREX::utils::Symbol name, details::transaction_flags f);
       bool unprovide_sync(TREX::utils::Symbol name);
      
-      void observation_sync(Observation o, bool verbose);
+      void observation_sync(observation_id o, bool verbose);
       bool goal_sync(goal_id g);
       bool recall_sync(goal_id g);
+      /** @brief Dispatch pending goals
+       *
+       * Send the goals posted by this reactor that are now in the dispatch
+       * window of their @e External timeline. This is done when the 
+       * reactor has no more deliberation to do.
+       *
+       * @sa workRatio()
+       */
+      void dispatch_sync();
       
       bool plan_sync(goal_id tok);
       void cancel_sync(goal_id tok);
-      
+
+      /** @brief Pending transaction
+       *
+       * A transaction posted by this reactor during either synchronize()
+       * or resume() which has not yet been applied to the graph.
+       *
+       * @sa m_outbox
+       */
+      struct outbox_entry {
+        enum kind {
+          observation,
+          goal,
+          plan,
+          recall,
+          cancel
+        };
+
+        outbox_entry(observation_id const &o, bool v)
+          :type(observation), obs(o), verbose(v) {}
+        outbox_entry(kind k, goal_id const &g)
+          :type(k), id(g), verbose(false) {}
+
+        kind                        type;
+        observation_id              obs;
+        goal_id                     id;
+        bool                        verbose;
+      }; // TREX::transaction::TeleoReactor::outbox_entry
+
+      class batch_scope;
+      friend class batch_scope;
+
+      /** @brief Check for batching context
+       *
+       * @retval true if the calling thread is currently executing either
+       *   synchronize() or resume() for this reactor
+       * @retval false otherwise
+       *
+       * When this call is true postObservation, postGoal, postRecall, 
+       * postPlanToken and cancelPlanToken are queued in m_outbox instead 
+       * of being immediately applied through the graph strand. The 
+       * timeline ownership is still checked by the call against 
+       * m_int_names and m_ext_names.
+       *
+       * @note A batched postGoal returns @c true even if the goal was 
+       *   already posted. This duplicate is only reported in the log 
+       *   when m_outbox is applied.
+       */
+      bool batching() const;
+      /** @brief Apply pending transactions
+       *
+       * @param[in] publish Publish the observations of this tick
+       *
+       * Apply all the transactions of m_outbox to the graph in a single
+       * pass of the graph strand. All of them are applied even if one 
+       * fails. If @p publish is true and none failed, the same pass 
+       * also synchronizes the updated @e Internal timelines and stores 
+       * their new observations in m_published.
+       *
+       * @throw The first exception produced by these transactions
+       */
+      void flush_outbox(bool publish=false);
+      /** @brief Apply pending transactions
+       *
+       * @param[in] publish Publish the observations of this tick
+       *
+       * @pre Executed by the graph strand
+       * @return the first exception produced by the transactions of 
+       *   m_outbox if any
+       * @sa flush_outbox(bool)
+       */
+      boost::exception_ptr outbox_sync(bool publish);
+
+      /** @brief Pending transactions
+       *
+       * The transactions posted by this reactor during the current
+       * synchronize() or resume() call. This queue is only accessed
+       * by the thread executing this reactor and therefore do not
+       * need any lock.
+       *
+       * @sa flush_outbox()
+       */
+      std::vector<outbox_entry> m_outbox;
+      /** @brief Observations published this tick
+       *
+       * Filled by outbox_sync() and recorded in the graph journal by 
+       * doSynchronize()
+       */
+      std::vector<observation_id> m_published;
+
       void clear_internals();
       void clear_externals();
       
@@ -1073,17 +1267,38 @@ namespace TREX {
       
       std::list<goal_id>     m_sync_goals, m_sync_recalls, m_sync_toks, m_sync_cancels;
       utils::SharedVar<size_t> m_have_goals;
+      /** @brief Timelines names snapshot
+       *
+       * The Symbol::id() of the names of the @e Internal and @e External 
+       * timelines of this reactor. They are updated along with m_internals 
+       * and m_externals on the graph strand and allow batched transactions 
+       * to check the timeline ownership without going through the strand.
+       *
+       * @sa batching() const
+       */
+      utils::SharedVar< boost::unordered_set<size_t> > m_int_names, m_ext_names;
       
       bool have_goals();
       
-      void collect_obs_sync(std::list<Observation> &l);
+      /** @brief External timeline update
+       *
+       * @param[in] tl An @e External timeline
+       *
+       * Notifies this reactor that @p tl received a new observation. 
+       * This call is made by @p tl within the graph strand.
+       *
+       * @sa m_ext_updates
+       * @sa doNotify()
+       */
+      void external_updated(details::timeline *tl);
+      void collect_obs_sync(std::list<observation_id> &l);
       
       /** @brief Request new observations
        *
        * This method is called at the beginnin of synchronizayion in order
        * for the reactor to collect its @e External observations
-       * This function identifies all the @e External timelines for which
-       * a postObservation has been called and will collect the last
+       * This function only visits the @e External timelines which 
+       * notified an update since the last call and will collect the last
        * obserbvation produced for this tick if it exist.
        *
        * @sa doSynchronize()
@@ -1093,13 +1308,15 @@ namespace TREX {
       void   doNotify();
       
       bool m_verbose;
+      bool m_polled;
       
       /** @brief Transaction logger
        *
        * A pointer to the transaction logger for this reactor. If the pointer
        * is not @c NULL. The this reactor will log all the transaction events
        * it produces during its lifetime in an output file named
-       * <reactor>.tr.log.
+       * <reactor>.tr.log -- or <reactor>.tr.bin when using the binary 
+       * format.
        * Such file can be used by a TransactionPlayer to reproduce this reactor
        * behavior inside the agent.
        *
@@ -1183,6 +1400,15 @@ namespace TREX {
       external_set m_externals;
       internal_set m_internals;
       internal_set m_updates;
+      /** @brief Updated @e External timelines
+       *
+       * The @e External timelines that received a new observation
+       * since the last doNotify(). This list is only manipulated within 
+       * the graph strand.
+       *
+       * @sa external_updated(details::timeline *)
+       */
+      std::vector<details::timeline *> m_ext_updates;
       
       /** @brief TREX log entry point
        *
@@ -0,0 +1,747 @@
+/** @file TransactionLog.cc
+ * @brief Implementation of the transaction log formats
+ *
+ * @ingroup transaction
+ */
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "TransactionLog.hh"
+
+#include <trex/domain/BooleanDomain.hh>
+#include <trex/domain/EnumDomain.hh>
+#include <trex/domain/FloatDomain.hh>
+#include <trex/domain/IntegerDomain.hh>
+#include <trex/domain/StringDomain.hh>
+#include <trex/utils/ptree_io.hh>
+
+#include <cstring>
+#include <typeinfo>
+
+#include <boost/cstdint.hpp>
+
+using namespace TREX::transaction::tr_log;
+using TREX::utils::Symbol;
+using TREX::transaction::TICK;
+
+namespace bp=boost::property_tree;
+namespace tr=TREX::transaction;
+
+char const details::magic[4] = { 'T', 'R', 'X', 'B' };
+
+namespace {
+
+  char const *const phase_tags[] = {
+    "init", "start", "synchronize", "has_work", "step"
+  };
+  char const *const goal_tags[] = {
+    "request", "recall", "token", "cancel"
+  };
+
+  enum interval_flags {
+    has_lower = 1,
+    has_upper = 2,
+    singleton = 4
+  };
+
+  char const *phase_tag(phase p) {
+    if( p<=in_step )
+      return phase_tags[p];
+    return "unknown";
+  }
+
+  /** @brief Zigzag encoding
+   *
+   * Map signed integers to unsigned ones so that values with a small
+   * magnitude -- positive or negative -- result in small varints.
+   */
+  unsigned long long zigzag(long long val) {
+    unsigned long long ret = static_cast<unsigned long long>(val)<<1;
+    return val<0?~ret:ret;
+  }
+  long long unzigzag(unsigned long long val) {
+    unsigned long long ret = val>>1;
+    return static_cast<long long>((val&1)?~ret:ret);
+  }
+
+}
+
+/*
+ * class TREX::transaction::tr_log::xml_writer
+ */
+
+void xml_writer::open() {
+  m_out<<"<Log>\n <header>\n";
+}
+
+void xml_writer::close() {
+  m_out<<"</Log>\n";
+  flush();
+}
+
+void xml_writer::flush() {
+  m_out.flush();
+}
+
+void xml_writer::end_header() {
+  m_out<<" </header>\n";
+}
+
+void xml_writer::open_tick(TICK val) {
+  // the phase tag will be written on the same line
+  m_out<<" <tick value=\""<<val<<"\">";
+}
+
+void xml_writer::close_tick() {
+  m_out<<" </tick>\n";
+}
+
+void xml_writer::open_phase(phase p) {
+  m_out<<"  <"<<phase_tag(p)<<">\n";
+}
+
+void xml_writer::close_phase(phase p) {
+  m_out<<"  </"<<phase_tag(p)<<">\n";
+}
+
+void xml_writer::comment(std::string const &msg) {
+  m_out<<"<!-- "<<msg<<" -->\n";
+}
+
+void xml_writer::failed() {
+  m_out<<"   <failed/>\n";
+}
+
+void xml_writer::work(bool ret) {
+  m_out<<"   <work value=\""<<ret<<"\" />\n";
+}
+
+void xml_writer::provide(Symbol const &name, bool goals, bool plan) {
+  m_out<<"   <provide name=\""<<name<<"\" goals=\""<<goals
+  <<"\" plan=\""<<plan<<"\" />\n";
+}
+
+void xml_writer::unprovide(Symbol const &name) {
+  m_out<<"   <unprovide name=\""<<name<<"\" />\n";
+}
+
+void xml_writer::use(Symbol const &name, bool goals, bool plan) {
+  m_out<<"   <use name=\""<<name<<"\" goals=\""<<goals
+  <<"\" plan=\""<<plan<<"\" />\n";
+}
+
+void xml_writer::unuse(Symbol const &name) {
+  m_out<<"   <unuse name=\""<<name<<"\" />\n";
+}
+
+void xml_writer::latency(TICK val) {
+  m_out<<"   <latency value=\""<<val<<"\"/>\n";
+}
+
+void xml_writer::horizon(TICK val) {
+  m_out<<"   <horizon value=\""<<val<<"\"/>\n";
+}
+
+void xml_writer::observation(tr::Observation const &obs) {
+  obs.to_xml(m_out)<<'\n';
+}
+
+void xml_writer::observation(bp::ptree const &pred) {
+  utils::write_xml(m_out, pred, false);
+  m_out<<'\n';
+}
+
+void xml_writer::goal(goal_event kind, tr::goal_id const &g) {
+  if( request==kind || token==kind ) {
+    bp::ptree pred = g->as_tree();
+    goal(kind, g.get(), &pred);
+  } else
+    goal(kind, g.get(), NULL);
+}
+
+void xml_writer::goal(goal_event kind, void const *id, bp::ptree const *pred) {
+  char const *tag = goal_tags[kind];
+
+  m_out<<"   <"<<tag<<" id=\""<<id<<"\" ";
+  if( NULL!=pred ) {
+    utils::write_xml(m_out<<">\n", *pred, false);
+    m_out<<"\n   </"<<tag<<">\n";
+  } else
+    m_out<<"/>\n";
+}
+
+/*
+ * class TREX::transaction::tr_log::binary_writer
+ */
+
+binary_writer::binary_writer(std::ostream &out)
+:m_out(out) {
+  m_record.reserve(256);
+}
+
+// binary encoding
+
+void binary_writer::begin(details::record_type type) {
+  m_record.clear();
+  put(type);
+}
+
+void binary_writer::end() {
+  write_uint(m_record.size());
+  m_out.write(&m_record[0], m_record.size());
+}
+
+void binary_writer::write_uint(unsigned long long val) {
+  char buf[10];
+  size_t len = 0;
+
+  for( ; val>=0x80; val >>= 7)
+    buf[len++] = static_cast<char>((val&0x7f)|0x80);
+  buf[len++] = static_cast<char>(val);
+  m_out.write(buf, len);
+}
+
+void binary_writer::put_uint(unsigned long long val) {
+  for( ; val>=0x80; val >>= 7)
+    put(static_cast<unsigned char>((val&0x7f)|0x80));
+  put(static_cast<unsigned char>(val));
+}
+
+void binary_writer::put_int(long long val) {
+  put_uint(zigzag(val));
+}
+
+void binary_writer::put_double(double val) {
+  boost::uint64_t bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  // always little endian
+  for(size_t i=0; i<sizeof(bits); ++i, bits >>= 8)
+    put(static_cast<unsigned char>(bits&0xff));
+}
+
+void binary_writer::put_string(std::string const &str) {
+  put_uint(str.length());
+  m_record.insert(m_record.end(), str.begin(), str.end());
+}
+
+void binary_writer::put_symbol(Symbol const &sym) {
+  symbol_table::const_iterator pos = m_symbols.find(sym);
+
+  if( m_symbols.end()==pos ) {
+    // First use: write its definition before the record being built
+    std::string const &str = sym.str();
+    size_t len = str.length(), n_len = 1;
+
+    for(size_t i=len; i>=0x80; i >>= 7, ++n_len);
+    write_uint(1+n_len+len);
+    m_out.put(static_cast<char>(details::symbol_def));
+    write_uint(len);
+    m_out.write(str.c_str(), len);
+
+    pos = m_symbols.insert(symbol_table::value_type(sym, m_symbols.size())).first;
+  }
+  put_uint(pos->second);
+}
+
+void binary_writer::put_tree(bp::ptree const &t) {
+  put_string(t.data());
+  put_uint(t.size());
+  for(bp::ptree::const_iterator i=t.begin(); t.end()!=i; ++i) {
+    put_symbol(i->first);
+    put_tree(i->second);
+  }
+}
+
+void binary_writer::put_var(tr::Variable const &var) {
+  put_symbol(var.name());
+  if( !var.isComplete() ) {
+    put(details::no_domain);
+    return;
+  }
+
+  tr::DomainBase const &dom = var.domain();
+  std::type_info const &type = typeid(dom);
+
+  if( typeid(tr::IntegerDomain)==type ) {
+    tr::IntegerDomain const &d = static_cast<tr::IntegerDomain const &>(dom);
+    put(details::int_domain);
+    if( d.isSingleton() ) {
+      put(singleton);
+      put_int(d.lowerBound().value());
+    } else {
+      put((d.hasLower()?has_lower:0)|(d.hasUpper()?has_upper:0));
+      if( d.hasLower() )
+        put_int(d.lowerBound().value());
+      if( d.hasUpper() )
+        put_int(d.upperBound().value());
+    }
+  } else if( typeid(tr::FloatDomain)==type ) {
+    tr::FloatDomain const &d = static_cast<tr::FloatDomain const &>(dom);
+    put(details::float_domain);
+    if( d.isSingleton() ) {
+      put(singleton);
+      put_double(d.lowerBound().value());
+    } else {
+      put((d.hasLower()?has_lower:0)|(d.hasUpper()?has_upper:0));
+      if( d.hasLower() )
+        put_double(d.lowerBound().value());
+      if( d.hasUpper() )
+        put_double(d.upperBound().value());
+    }
+  } else if( typeid(tr::BooleanDomain)==type ) {
+    put(details::bool_domain);
+    if( dom.isFull() )
+      put(2);
+    else
+      put(dom.getTypedSingleton<bool, false>()?1:0);
+  } else if( typeid(tr::StringDomain)==type ) {
+    tr::StringDomain const &d = static_cast<tr::StringDomain const &>(dom);
+    put(details::string_domain);
+    put_uint(d.getSize());
+    for(tr::StringDomain::iterator i=d.begin(); d.end()!=i; ++i)
+      put_string(*i);
+  } else if( typeid(tr::EnumDomain)==type ) {
+    tr::EnumDomain const &d = static_cast<tr::EnumDomain const &>(dom);
+    put(details::enum_domain);
+    put_uint(d.getSize());
+    for(tr::EnumDomain::iterator i=d.begin(); d.end()!=i; ++i)
+      put_symbol(*i);
+  } else {
+    // Not a domain we know: store its generic XML form
+    put(details::tree_domain);
+    put_symbol(dom.getTypeName());
+    put_tree(dom.as_tree().front().second);
+  }
+}
+
+void binary_writer::put_predicate(tr::Predicate const &pred) {
+  std::list<Symbol> vars;
+
+  put_symbol(pred.object());
+  put_symbol(pred.predicate());
+  pred.listAttributes(vars, false);
+  put_uint(vars.size());
+  for( ; !vars.empty(); vars.pop_front())
+    put_var(pred.getAttribute(vars.front()));
+}
+
+void binary_writer::timeline(details::record_type type, Symbol const &name,
+                             bool goals, bool plan) {
+  begin(type);
+  put_symbol(name);
+  put((goals?1:0)|(plan?2:0));
+  end();
+}
+
+// writer interface
+
+void binary_writer::open() {
+  m_out.write(details::magic, sizeof(details::magic));
+  m_out.put(static_cast<char>(details::version));
+}
+
+void binary_writer::close() {
+  begin(details::log_end);
+  end();
+  flush();
+}
+
+void binary_writer::flush() {
+  m_out.flush();
+}
+
+void binary_writer::end_header() {
+  begin(details::header_end);
+  end();
+}
+
+void binary_writer::open_tick(TICK val) {
+  begin(details::tick_open);
+  put_int(val);
+  end();
+}
+
+void binary_writer::close_tick() {
+  begin(details::tick_close);
+  end();
+}
+
+void binary_writer::open_phase(phase p) {
+  begin(details::phase_open);
+  put(p);
+  end();
+}
+
+void binary_writer::close_phase(phase p) {
+  begin(details::phase_close);
+  put(p);
+  end();
+}
+
+void binary_writer::comment(std::string const &msg) {
+  begin(details::comment_rec);
+  put_string(msg);
+  end();
+}
+
+void binary_writer::failed() {
+  begin(details::failed_rec);
+  end();
+}
+
+void binary_writer::work(bool ret) {
+  begin(details::work_rec);
+  put(ret?1:0);
+  end();
+}
+
+void binary_writer::provide(Symbol const &name, bool goals, bool plan) {
+  timeline(details::provide_rec, name, goals, plan);
+}
+
+void binary_writer::unprovide(Symbol const &name) {
+  begin(details::unprovide_rec);
+  put_symbol(name);
+  end();
+}
+
+void binary_writer::use(Symbol const &name, bool goals, bool plan) {
+  timeline(details::use_rec, name, goals, plan);
+}
+
+void binary_writer::unuse(Symbol const &name) {
+  begin(details::unuse_rec);
+  put_symbol(name);
+  end();
+}
+
+void binary_writer::latency(TICK val) {
+  begin(details::latency_rec);
+  put_int(val);
+  end();
+}
+
+void binary_writer::horizon(TICK val) {
+  begin(details::horizon_rec);
+  put_int(val);
+  end();
+}
+
+void binary_writer::observation(tr::Observation const &obs) {
+  begin(details::observation_rec);
+  put_predicate(obs);
+  end();
+}
+
+void binary_writer::goal(goal_event kind, tr::goal_id const &g) {
+  begin(details::goal_rec);
+  put(kind);
+  put_uint(reinterpret_cast<size_t>(g.get()));
+  if( request==kind || token==kind )
+    put_predicate(*g);
+  end();
+}
+
+/*
+ * class TREX::transaction::tr_log::binary_reader
+ */
+
+binary_reader::binary_reader(std::istream &in)
+:m_in(in), m_pos(0) {
+  char head[sizeof(details::magic)+1];
+
+  if( !m_in.read(head, sizeof(head))
+     || 0!=std::memcmp(head, details::magic, sizeof(details::magic)) )
+    throw bad_format("not a binary transaction log");
+  if( details::version<static_cast<unsigned char>(head[sizeof(details::magic)]) )
+    throw bad_format("unsupported binary log version");
+}
+
+// binary decoding
+
+unsigned char binary_reader::get() {
+  if( m_pos>=m_record.size() )
+    throw bad_format("record is truncated");
+  return static_cast<unsigned char>(m_record[m_pos++]);
+}
+
+unsigned long long binary_reader::get_uint() {
+  unsigned long long ret = 0;
+  unsigned char c;
+
+  for(size_t shift=0; shift<64; shift += 7) {
+    c = get();
+    ret |= static_cast<unsigned long long>(c&0x7f)<<shift;
+    if( !(c&0x80) )
+      return ret;
+  }
+  throw bad_format("invalid varint");
+}
+
+long long binary_reader::get_int() {
+  return unzigzag(get_uint());
+}
+
+double binary_reader::get_double() {
+  boost::uint64_t bits = 0;
+  double ret;
+
+  for(size_t i=0; i<sizeof(bits); ++i)
+    bits |= static_cast<boost::uint64_t>(get())<<(8*i);
+  std::memcpy(&ret, &bits, sizeof(ret));
+  return ret;
+}
+
+std::string binary_reader::get_string() {
+  size_t len = get_uint();
+
+  if( m_record.size()-m_pos<len )
+    throw bad_format("string is truncated");
+  m_pos += len;
+  return std::string(&m_record[m_pos-len], len);
+}
+
+Symbol const &binary_reader::get_symbol() {
+  size_t id = get_uint();
+
+  if( id>=m_symbols.size() )
+    throw bad_format("reference to an undefined symbol");
+  return m_symbols[id];
+}
+
+void binary_reader::get_tree(bp::ptree &t) {
+  t.data() = get_string();
+  for(size_t n=get_uint(); n>0; --n) {
+    Symbol const &key = get_symbol();
+    get_tree(t.push_back(bp::ptree::value_type(key.str(),
+                                               bp::ptree()))->second);
+  }
+}
+
+bp::ptree binary_reader::get_var() {
+  Symbol const &name = get_symbol();
+  unsigned char flags;
+
+  switch( get() ) {
+    case details::no_domain:
+      {
+        bp::ptree ret;
+        utils::set_attr(ret, "type", "null");
+        utils::set_attr(ret, "name", name);
+        return ret;
+      }
+    case details::int_domain:
+      flags = get();
+      if( flags&singleton )
+        return tr::Variable(name, tr::IntegerDomain(get_int())).as_tree();
+      else {
+        tr::IntegerDomain::bound lo(tr::IntegerDomain::minus_inf),
+          hi(tr::IntegerDomain::plus_inf);
+        if( flags&has_lower )
+          lo = get_int();
+        if( flags&has_upper )
+          hi = get_int();
+        return tr::Variable(name, tr::IntegerDomain(lo, hi)).as_tree();
+      }
+    case details::float_domain:
+      flags = get();
+      if( flags&singleton )
+        return tr::Variable(name, tr::FloatDomain(get_double())).as_tree();
+      else {
+        tr::FloatDomain::bound lo(tr::FloatDomain::minus_inf),
+          hi(tr::FloatDomain::plus_inf);
+        if( flags&has_lower )
+          lo = get_double();
+        if( flags&has_upper )
+          hi = get_double();
+        return tr::Variable(name, tr::FloatDomain(lo, hi)).as_tree();
+      }
+    case details::bool_domain:
+      flags = get();
+      if( flags>1 )
+        return tr::Variable(name, tr::BooleanDomain()).as_tree();
+      return tr::Variable(name, tr::BooleanDomain(1==flags)).as_tree();
+    case details::string_domain:
+      {
+        std::list<std::string> vals;
+        for(size_t n=get_uint(); n>0; --n)
+          vals.push_back(get_string());
+        return tr::Variable(name,
+                            tr::StringDomain(vals.begin(), vals.end())).as_tree();
+      }
+    case details::enum_domain:
+      {
+        std::list<Symbol> vals;
+        for(size_t n=get_uint(); n>0; --n)
+          vals.push_back(get_symbol());
+        return tr::Variable(name,
+                            tr::EnumDomain(vals.begin(), vals.end())).as_tree();
+      }
+    case details::tree_domain:
+      {
+        Symbol const &type = get_symbol();
+        bp::ptree ret;
+        get_tree(ret.push_back(bp::ptree::value_type(type.str(),
+                                                     bp::ptree()))->second);
+        utils::set_attr(ret, "type", type);
+        utils::set_attr(ret, "name", name);
+        return ret;
+      }
+    default:
+      throw bad_format("unknown domain type");
+  }
+}
+
+bp::ptree binary_reader::get_predicate(std::string const &tag) {
+  bp::ptree ret;
+  bp::ptree &val = ret.add_child(tag, bp::ptree());
+
+  utils::set_attr(val, "on", get_symbol());
+  utils::set_attr(val, "pred", get_symbol());
+
+  size_t n = get_uint();
+  if( n>0 ) {
+    bp::ptree &vars = val.add_child("Variable", bp::ptree());
+    for( ; n>0; --n)
+      vars.push_back(bp::ptree::value_type("", get_var()));
+  }
+  return ret;
+}
+
+// reader interface
+
+bool binary_reader::next(xml_writer &out) {
+  while( true ) {
+    unsigned long long len = 0;
+    int c;
+
+    // read the record length
+    for(size_t shift=0; ; shift += 7) {
+      c = m_in.get();
+      if( std::istream::traits_type::eof()==c ) {
+        if( 0==shift )
+          return false;
+        throw bad_format("record length is truncated");
+      }
+      if( shift>=64 )
+        throw bad_format("invalid record length");
+      len |= static_cast<unsigned long long>(c&0x7f)<<shift;
+      if( !(c&0x80) )
+        break;
+    }
+    if( 0==len )
+      throw bad_format("empty record");
+    if( len>details::max_record_size )
+      throw bad_format("record too large");
+    m_record.resize(len);
+    if( !m_in.read(&m_record[0], len) )
+      throw bad_format("record is truncated");
+    m_pos = 0;
+
+    switch( get() ) {
+      case details::symbol_def:
+        m_symbols.push_back(Symbol(get_string()));
+        break;
+      case details::header_end:
+        out.end_header();
+        return true;
+      case details::tick_open:
+        out.open_tick(get_int());
+        return true;
+      case details::tick_close:
+        out.close_tick();
+        return true;
+      case details::phase_open:
+        out.open_phase(static_cast<phase>(get()));
+        return true;
+      case details::phase_close:
+        out.close_phase(static_cast<phase>(get()));
+        return true;
+      case details::comment_rec:
+        out.comment(get_string());
+        return true;
+      case details::failed_rec:
+        out.failed();
+        return true;
+      case details::work_rec:
+        out.work(0!=get());
+        return true;
+      case details::provide_rec:
+      case details::use_rec:
+        {
+          bool provide = (details::provide_rec==m_record[0]);
+          Symbol const &name = get_symbol();
+          unsigned char flags = get();
+          if( provide )
+            out.provide(name, flags&1, flags&2);
+          else
+            out.use(name, flags&1, flags&2);
+        }
+        return true;
+      case details::unprovide_rec:
+        out.unprovide(get_symbol());
+        return true;
+      case details::unuse_rec:
+        out.unuse(get_symbol());
+        return true;
+      case details::latency_rec:
+        out.latency(get_int());
+        return true;
+      case details::horizon_rec:
+        out.horizon(get_int());
+        return true;
+      case details::observation_rec:
+        out.observation(get_predicate("Observation"));
+        return true;
+      case details::goal_rec:
+        {
+          unsigned char kind = get();
+          void const *id = reinterpret_cast<void const *>(static_cast<size_t>(get_uint()));
+          if( kind>cancel )
+            throw bad_format("unknown goal event");
+          if( request==kind || token==kind ) {
+            bp::ptree pred = get_predicate("Goal");
+            out.goal(static_cast<goal_event>(kind), id, &pred);
+          } else
+            out.goal(static_cast<goal_event>(kind), id, NULL);
+        }
+        return true;
+      case details::log_end:
+        out.close();
+        return true;
+      default:
+        // records unknown to this version are skipped
+        break;
+    }
+  }
+}
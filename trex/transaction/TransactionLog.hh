@@ -0,0 +1,426 @@
+/** @file trex/transaction/TransactionLog.hh
+ * @brief Reactor transaction log formats
+ *
+ * This file defines the output formats supported by the transactions
+ * log of a TeleoReactor along with a reader for the binary format
+ * that allows to convert it back into the XML form.
+ *
+ * @ingroup transaction
+ */
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef H_trex_transaction_TransactionLog
+# define H_trex_transaction_TransactionLog
+
+# include "Observation.hh"
+# include "Goal.hh"
+
+# include <iostream>
+# include <vector>
+
+# include <boost/unordered_map.hpp>
+
+namespace TREX {
+  namespace transaction {
+    namespace tr_log {
+
+      /** @brief Transaction log format exception
+       *
+       * Exception thrown when a transaction log does not conform
+       * to the expected format
+       *
+       * @ingroup transaction
+       */
+      class bad_format :public utils::Exception {
+      public:
+        explicit bad_format(std::string const &msg) throw()
+        :utils::Exception("transaction log: "+msg) {}
+        ~bad_format() throw() {}
+      }; // TREX::transaction::tr_log::bad_format
+
+      /** @brief Reactor execution phase
+       *
+       * The phases of a tick in which a transaction can be logged
+       */
+      enum phase {
+        in_init,
+        in_new_tick,
+        in_synchronize,
+        in_work,
+        in_step
+      }; // TREX::transaction::tr_log::phase
+
+      /** @brief Goal transaction kind */
+      enum goal_event {
+        request,
+        recall,
+        token,
+        cancel
+      }; // TREX::transaction::tr_log::goal_event
+
+      /** @brief Transaction log writer
+       *
+       * The abstract interface used by the TeleoReactor transaction
+       * logger to produce its output. Implementations define the
+       * actual format of the log while the logger itself handles
+       * when ticks and phases are opened or closed: a phase is only
+       * written when at least one transaction occurred during it.
+       *
+       * All the calls are made from the logger strand and therefore
+       * implementations do not need to be thread safe.
+       *
+       * @ingroup transaction
+       */
+      class writer :boost::noncopyable {
+      public:
+        /** @brief Destructor */
+        virtual ~writer() {}
+
+        /** @brief Start of the log */
+        virtual void open() =0;
+        /** @brief End of the log
+         *
+         * Indicates that no more transactions will be written
+         * and all the pending output should be written
+         */
+        virtual void close() =0;
+        /** @brief Write pending output */
+        virtual void flush() =0;
+
+        /** @brief End of the header
+         *
+         * Indicates that the transactions that occurred before the
+         * first tick are all written.
+         */
+        virtual void end_header() =0;
+        virtual void open_tick(TICK val) =0;
+        virtual void close_tick() =0;
+        virtual void open_phase(phase p) =0;
+        virtual void close_phase(phase p) =0;
+
+        virtual void comment(std::string const &msg) =0;
+        virtual void failed() =0;
+        virtual void work(bool ret) =0;
+
+        virtual void provide(utils::Symbol const &name,
+                             bool goals, bool plan) =0;
+        virtual void unprovide(utils::Symbol const &name) =0;
+        virtual void use(utils::Symbol const &name,
+                         bool goals, bool plan) =0;
+        virtual void unuse(utils::Symbol const &name) =0;
+
+        virtual void latency(TICK val) =0;
+        virtual void horizon(TICK val) =0;
+
+        virtual void observation(Observation const &obs) =0;
+        /** @brief Goal transaction
+         *
+         * @param[in] kind The type of transaction
+         * @param[in] g    The goal
+         *
+         * The goal is identified in the log by its address. Its full
+         * content is only written for @c request and @c token events.
+         */
+        virtual void goal(goal_event kind, goal_id const &g) =0;
+
+      protected:
+        writer() {}
+      }; // TREX::transaction::tr_log::writer
+
+      /** @brief XML transaction log
+       *
+       * The historical format of the transaction logs. Each transaction
+       * is written as an XML tag with the observations and goals using
+       * their standard XML form.
+       *
+       * @ingroup transaction
+       */
+      class xml_writer :public writer {
+      public:
+        /** @brief Constructor
+         *
+         * @param[in] out The output stream
+         */
+        explicit xml_writer(std::ostream &out)
+        :m_out(out) {}
+        ~xml_writer() {}
+
+        void open();
+        void close();
+        void flush();
+
+        void end_header();
+        void open_tick(TICK val);
+        void close_tick();
+        void open_phase(phase p);
+        void close_phase(phase p);
+
+        void comment(std::string const &msg);
+        void failed();
+        void work(bool ret);
+
+        void provide(utils::Symbol const &name, bool goals, bool plan);
+        void unprovide(utils::Symbol const &name);
+        void use(utils::Symbol const &name, bool goals, bool plan);
+        void unuse(utils::Symbol const &name);
+
+        void latency(TICK val);
+        void horizon(TICK val);
+
+        void observation(Observation const &obs);
+        void goal(goal_event kind, goal_id const &g);
+
+        /** @brief Write a predicate tree
+         *
+         * @param[in] pred The XML tree of an observation
+         *
+         * Write the observation described by @p pred. This is used
+         * when converting a log where the observation is not available
+         * anymore but only its XML form.
+         *
+         * @sa Predicate::as_tree() const
+         */
+        void observation(boost::property_tree::ptree const &pred);
+        /** @brief Write a goal tree
+         *
+         * @param[in] kind The type of transaction
+         * @param[in] id   The goal identifier in the log
+         * @param[in] pred The XML tree of the goal or NULL
+         */
+        void goal(goal_event kind, void const *id,
+                  boost::property_tree::ptree const *pred);
+
+      private:
+        std::ostream &m_out;
+      }; // TREX::transaction::tr_log::xml_writer
+
+      namespace details {
+
+        /** @brief Maximum binary record size
+         *
+         * The largest record length accepted when reading a binary
+         * log. Actual records are a single transaction well below this
+         * size, a larger length indicates a corrupted file.
+         */
+        size_t const max_record_size = 1<<24;
+
+        /** @brief binary log record types
+         *
+         * Each record of the binary log is written as a varint with
+         * the number of bytes of the record followed by one of these
+         * codes and the record payload.
+         */
+        enum record_type {
+          symbol_def = 0,
+          header_end,
+          tick_open,
+          tick_close,
+          phase_open,
+          phase_close,
+          comment_rec,
+          failed_rec,
+          work_rec,
+          provide_rec,
+          unprovide_rec,
+          use_rec,
+          unuse_rec,
+          latency_rec,
+          horizon_rec,
+          observation_rec,
+          goal_rec,
+          log_end
+        }; // TREX::transaction::tr_log::details::record_type
+
+        /** @brief binary log domain types */
+        enum domain_type {
+          no_domain = 0,
+          int_domain,
+          float_domain,
+          bool_domain,
+          string_domain,
+          enum_domain,
+          tree_domain
+        }; // TREX::transaction::tr_log::details::domain_type
+
+        /** @brief Binary log magic number */
+        extern char const magic[4];
+        /** @brief Binary log format version */
+        unsigned char const version = 1;
+
+      } // TREX::transaction::tr_log::details
+
+      /** @brief Binary transaction log
+       *
+       * A compact form of the transaction log. Records are length
+       * prefixed, integers -- including ticks and integer domains --
+       * are written as varints and each symbol is written in full
+       * only once, the first time it is used, and then referred by
+       * its index in the log symbol table.
+       *
+       * Each record is encoded in a buffer that is reused from one
+       * record to the next and then written in one block to the output
+       * stream. The buffering of the output itself is left to this
+       * stream.
+       *
+       * Domains that are not one of the basic TREX domains are written
+       * as their generic XML tree.
+       *
+       * @ingroup transaction
+       * @sa class binary_reader
+       */
+      class binary_writer :public writer {
+      public:
+        /** @brief Constructor
+         *
+         * @param[in] out The output stream
+         */
+        explicit binary_writer(std::ostream &out);
+        ~binary_writer() {}
+
+        void open();
+        void close();
+        void flush();
+
+        void end_header();
+        void open_tick(TICK val);
+        void close_tick();
+        void open_phase(phase p);
+        void close_phase(phase p);
+
+        void comment(std::string const &msg);
+        void failed();
+        void work(bool ret);
+
+        void provide(utils::Symbol const &name, bool goals, bool plan);
+        void unprovide(utils::Symbol const &name);
+        void use(utils::Symbol const &name, bool goals, bool plan);
+        void unuse(utils::Symbol const &name);
+
+        void latency(TICK val);
+        void horizon(TICK val);
+
+        void observation(Observation const &obs);
+        void goal(goal_event kind, goal_id const &g);
+
+      private:
+        typedef boost::unordered_map<utils::Symbol, size_t> symbol_table;
+
+        void begin(details::record_type type);
+        void end();
+        void write_uint(unsigned long long val);
+
+        void put(unsigned char c) {
+          m_record.push_back(c);
+        }
+        void put_uint(unsigned long long val);
+        void put_int(long long val);
+        void put_double(double val);
+        void put_string(std::string const &str);
+        void put_symbol(utils::Symbol const &sym);
+        void put_tree(boost::property_tree::ptree const &t);
+        void put_var(Variable const &var);
+        void put_predicate(Predicate const &pred);
+
+        void timeline(details::record_type type, utils::Symbol const &name,
+                      bool goals, bool plan);
+
+        std::ostream     &m_out;
+        std::vector<char> m_record;
+        symbol_table      m_symbols;
+      }; // TREX::transaction::tr_log::binary_writer
+
+      /** @brief Binary transaction log reader
+       *
+       * A class that decodes a binary transaction log and replays it
+       * into an xml_writer. This allows to convert a binary log into
+       * the same XML log the reactor would have produced.
+       *
+       * @ingroup transaction
+       * @sa class binary_writer
+       */
+      class binary_reader :boost::noncopyable {
+      public:
+        /** @brief Constructor
+         *
+         * @param[in] in A binary log input stream
+         *
+         * @throw bad_format @p in is not a binary transaction log
+         */
+        explicit binary_reader(std::istream &in);
+        ~binary_reader() {}
+
+        /** @brief Read next record
+         *
+         * @param[in] out A destination log
+         *
+         * Read the next transaction of the log and write it into @p out
+         *
+         * @retval true if a transaction was read
+         * @retval false the end of the log was reached
+         *
+         * @throw bad_format the log is corrupted
+         */
+        bool next(xml_writer &out);
+        /** @brief Convert the log
+         *
+         * @param[in] out A destination log
+         *
+         * Write all the remaining transactions of the log into @p out
+         */
+        void convert(xml_writer &out) {
+          while( next(out) );
+        }
+
+      private:
+        unsigned char get();
+        unsigned long long get_uint();
+        long long get_int();
+        double get_double();
+        std::string get_string();
+        utils::Symbol const &get_symbol();
+        void get_tree(boost::property_tree::ptree &t);
+        boost::property_tree::ptree get_var();
+        boost::property_tree::ptree get_predicate(std::string const &tag);
+
+        std::istream                &m_in;
+        std::vector<char>            m_record;
+        size_t                       m_pos;
+        std::vector<utils::Symbol>   m_symbols;
+      }; // TREX::transaction::tr_log::binary_reader
+
+    } // TREX::transaction::tr_log
+  } // TREX::transaction
+} // TREX
+
+#endif // H_trex_transaction_TransactionLog
@@ -46,8 +46,12 @@
 # include "../Goal.hh"
 # include "timeline.hh"
 
+# include <algorithm>
+# include <vector>
+
 # include <boost/iterator_adaptors.hpp>
 # include <boost/iterator/filter_iterator.hpp>
+# include <boost/unordered_map.hpp>
 
 namespace TREX {
   namespace transaction {
@@ -59,10 +63,125 @@ namespace TREX {
        * process the set of goals being posted by a reactor and yet to
        * be dipatched to the owner of this timeline
        *
+       * Goals are sorted by their start domain -- based on its upper bound
+       * first and then its lower bound -- as it was when they were
+       * inserted. Goals with the same start are kept in insertion order.
+       * They are stored in a sorted vector which keeps the queue 
+       * contiguous in memory as it is scanned at every dispatch. A hash 
+       * index gives the sorting key of each goal so checking for a goal 
+       * is done in constant time and finding its slot in O(log n).
+       *
+       * Each element is a pair where @c first is the goal and @c second 
+       * is a flag indicating if this goal can be dispatched.
+       *
        * @ingroup transaction
        * @relates class external
        */
-      typedef std::list< std::pair<goal_id, bool> >  goal_queue;
+      class goal_queue {
+      public:
+        typedef std::pair<goal_id, bool> value_type;
+        
+      private:
+        typedef std::pair<IntegerDomain::bound, 
+                          IntegerDomain::bound>          start_type;
+        /** @brief Sorting key
+         *
+         * The start of the goal along with its insertion number which 
+         * makes each key unique and keeps the insertion order of the 
+         * goals with the same start.
+         */
+        typedef std::pair<start_type, size_t>            key_type;
+        typedef std::pair<key_type, value_type>          entry_type;
+        typedef std::vector<entry_type>                  queue_type;
+        typedef boost::unordered_map<goal_id, key_type>  index_type;
+        
+        /** @brief Key ordering for std::lower_bound */
+        struct entry_less {
+          bool operator()(entry_type const &e, key_type const &k) const {
+            return e.first<k;
+          }
+        };
+        
+      public:
+        typedef queue_type::iterator       iterator;
+        typedef queue_type::const_iterator const_iterator;
+        
+        goal_queue():m_seq(0) {}
+        ~goal_queue() {}
+        
+        bool empty() const {
+          return m_queue.empty();
+        }
+        size_t size() const {
+          return m_queue.size();
+        }
+        
+        iterator begin() {
+          return m_queue.begin();
+        }
+        iterator end() {
+          return m_queue.end();
+        }
+        const_iterator begin() const {
+          return m_queue.begin();
+        }
+        const_iterator end() const {
+          return m_queue.end();
+        }
+        
+        /** @brief Check for a goal
+         *
+         * @param[in] g A goal
+         *
+         * @retval true if @p g is in this queue
+         * @retval false otherwise
+         */
+        bool contains(goal_id const &g) const {
+          return m_index.end()!=m_index.find(g);
+        }
+        /** @brief Insert a goal
+         *
+         * @param[in] g A goal
+         *
+         * Add @p g to this queue as a dispatchable goal
+         *
+         * @retval true if @p g was inserted
+         * @retval false if @p g was already in this queue
+         */
+        bool insert(goal_id const &g);
+        /** @brief Remove a goal
+         *
+         * @param[in] g A goal
+         *
+         * @retval true if @p g was removed from this queue
+         * @retval false if @p g was not in this queue
+         */
+        bool erase(goal_id const &g);
+        /** @brief Remove a goal
+         *
+         * @param[in] pos An iterator to this queue
+         *
+         * Remove the goal pointed by @p pos
+         *
+         * @return An iterator to the element following @p pos
+         * @note As for @c std::vector this invalidates all the 
+         *   iterators from @p pos
+         */
+        iterator erase(iterator pos);
+        void clear();
+        
+      private:
+        iterator slot(key_type const &key) {
+          return std::lower_bound(m_queue.begin(), m_queue.end(), key, 
+                                  entry_less());
+        }
+        
+        queue_type m_queue;
+        index_type m_index;
+        /** @brief Next insertion number */
+        size_t     m_seq;
+      }; // TREX::transaction::details::goal_queue
+      
       /** @brief A external timeline proxy
        *
        * This type by a external class to represent an external timeline
@@ -84,7 +203,7 @@ namespace TREX {
        * @relates TeleoReactor
        * @sa class external
        */
-      typedef utils::list_set<pending_traits>              external_set;
+      typedef utils::hashed_list_set<pending_traits>       external_set;
       
       /** @brief An external timeline
        *
@@ -171,6 +290,18 @@ namespace TREX {
          * @sa recall(goal_id const &)
          */
         bool post_goal(goal_id const &g);
+        /** @brief Check for pending goal
+         *
+         * @param[in] g A goal
+         *
+         * @pre This instance is valid
+         *
+         * @retval true @p g is in the pending goal queue of this instance
+         * @retval false otherwise
+         *
+         * @sa post_goal(goal_id const &)
+         */
+        bool pending(goal_id const &g);
         /** @brief Goal dispatching management
          *
          * @param[in] current The current tick
@@ -222,9 +353,6 @@ namespace TREX {
                  external_set::iterator const &last);
         
         
-        static bool cmp_goals(IntegerDomain const &a, IntegerDomain const &b);
-        
-        goal_queue::iterator lower_bound(IntegerDomain const &dom);
 
 	void increment();
 	bool equal(external const &other) const;
@@ -250,6 +250,15 @@ namespace TREX {
 	  m_shouldPrint = false;
 	  return *m_last_obs;
 	}
+	/** @brief last observation handle
+	 *
+	 * @return A shared handle to the last observation
+	 *
+	 * @sa lastObservation() const
+	 */
+	observation_id const &lastObservationId() const {
+	  return m_last_obs;
+	}
 
 	/** @brief Timeline look ahead
 	 *
@@ -444,10 +453,13 @@ namespace TREX {
 	 * @post lastObsDate is updated to @p date
 	 * @post lastObservation is updated to @p obs
 	 *
+	 * @note @p obs is shared with the clients of this timeline and 
+	 * should not be modified after this call
+	 *
 	 * @sa lastObservation() const
 	 * @sa lastObsDate() const
 	 */
-	void postObservation(Observation const &obs, 
+	void postObservation(observation_id const &obs, 
 			     bool verbose = false);
         void synchronize(TICK date);
         
@@ -484,8 +496,8 @@ namespace TREX {
 	client_set    m_clients;
 	
 
-        boost::optional<Observation> m_last_obs;
-        boost::optional<Observation> m_next_obs;
+        observation_id m_last_obs;
+        observation_id m_next_obs;
         TICK m_last_synch;
         TICK m_obs_date;
 
@@ -521,7 +533,7 @@ namespace TREX {
       }; //TREX::transaction::details::timeline
 
       typedef utils::pointer_id_traits<details::timeline> tl_ptr_id_traits;
-      typedef utils::list_set<tl_ptr_id_traits>           timeline_set;
+      typedef utils::hashed_list_set<tl_ptr_id_traits>    timeline_set;
 
       /** @brief Iterator for reactors relations
        *
@@ -0,0 +1,285 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "log_stream.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+using namespace TREX::transaction;
+using namespace TREX::transaction::details;
+
+namespace xml = boost::property_tree::xml_parser;
+
+/*
+ * class TREX::transaction::details::log_stream
+ */
+
+namespace {
+  
+  /** @brief Size of the chunks read from the log file */
+  size_t const chunk_size = 65536;
+  
+  bool is_delim(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) || '/'==c || '>'==c;
+  }
+  
+} // ::
+
+// structors
+
+log_stream::log_stream(std::string const &file)
+:m_in(file), m_size(0), m_base(0), m_cur(0), m_truncated(false) {
+  if( !m_in )
+    throw utils::Exception("Unable to open transaction log \""+file+"\".");
+  // identifies the log for the index: the actual size is unknown when
+  // the log is compressed
+  m_size = m_in.rdbuf()->disk_size();
+}
+
+// manipulators
+
+bool log_stream::header(log_stream::ptree &pt) {
+  size_t pos;
+  
+  switch( next_element(pos) ) {
+    case header_elt:
+      return extract("header", pos, pt);
+    case tick_elt:
+      m_cur = pos;
+      return false;
+    default:
+      return false;
+  }
+}
+
+bool log_stream::next(log_stream::ptree &pt) {
+  size_t pos;
+  
+  for(element e=next_element(pos); end_elt!=e; e=next_element(pos)) {
+    if( tick_elt==e )
+      return extract("tick", pos, pt);
+    // a misplaced header: just skip it
+    if( !extract("header", pos, pt) )
+      break;
+  }
+  return false;
+}
+
+bool log_stream::load_index(std::string const &file) {
+  std::ifstream in(file.c_str());
+  std::streamoff size, off;
+  TICK val;
+  
+  m_index.clear();
+  // the index starts with the size of the log it was built from
+  if( !(in>>size) || size!=m_size )
+    return false;
+  while( in>>val>>off )
+    m_index.push_back(std::make_pair(val, off));
+  if( in.eof() )
+    return true;
+  m_index.clear();
+  return false;
+}
+
+void log_stream::build_index() {
+  std::streamoff cur = m_base+std::streamoff(m_cur);
+  size_t pos;
+  TICK val;
+  
+  m_index.clear();
+  seek(0);
+  for(element e=next_element(pos); end_elt!=e; e=next_element(pos)) {
+    if( tick_elt==e && tick_value(pos, val) )
+      m_index.push_back(std::make_pair(val, m_base+std::streamoff(pos)));
+    m_cur = pos+1;
+    if( m_cur>chunk_size )
+      discard();
+  }
+  seek(cur);
+}
+
+bool log_stream::save_index(std::string const &file) const {
+  std::ofstream out(file.c_str());
+  
+  out<<m_size<<'\n';
+  for(index_type::const_iterator i=m_index.begin(); m_index.end()!=i; ++i)
+    out<<i->first<<' '<<i->second<<'\n';
+  out.close();
+  return !out.fail();
+}
+
+void log_stream::seek_tick(TICK tck) {
+  index_type::const_iterator
+  pos = std::lower_bound(m_index.begin(), m_index.end(),
+                         std::make_pair(tck, std::streamoff(0)));
+  if( m_index.end()==pos ) {
+    // no tick left: move to the end of the log
+    m_in.setstate(std::ios::failbit);
+    m_buf.clear();
+    m_cur = 0;
+  } else
+    seek(pos->second);
+  index_type().swap(m_index);
+}
+
+bool log_stream::fetch() {
+  if( !m_in )
+    return false;
+  size_t len = m_buf.size();
+  m_buf.resize(len+chunk_size);
+  m_in.read(&m_buf[len], chunk_size);
+  m_buf.resize(len+m_in.gcount());
+  return m_buf.size()>len;
+}
+
+bool log_stream::ensure(size_t pos, size_t len) {
+  while( m_buf.size()<pos+len )
+    if( !fetch() )
+      return false;
+  return true;
+}
+
+bool log_stream::find(char const *pat, size_t from, size_t &pos) {
+  size_t len = std::strlen(pat);
+  
+  for(pos=m_buf.find(pat, from); std::string::npos==pos;
+      pos=m_buf.find(pat, from)) {
+    // a match may start at the end of the current buffer
+    if( m_buf.size()>=len )
+      from = std::max(from, m_buf.size()-len+1);
+    if( !fetch() )
+      return false;
+  }
+  return true;
+}
+
+bool log_stream::is_tag(size_t pos, std::string const &tag) {
+  size_t len = tag.length();
+  return ensure(pos, len+2) && 0==m_buf.compare(pos+1, len, tag)
+    && is_delim(m_buf[pos+1+len]);
+}
+
+bool log_stream::next_tag(size_t from, size_t &pos) {
+  while( find("<", from, pos) ) {
+    if( ensure(pos, 4) && 0==m_buf.compare(pos, 4, "<!--") ) {
+      if( !find("-->", pos+4, from) )
+        return false;
+    } else if( ensure(pos, 2) && '?'==m_buf[pos+1] ) {
+      if( !find("?>", pos+2, from) )
+        return false;
+    } else
+      return true;
+  }
+  return false;
+}
+
+log_stream::element log_stream::next_element(size_t &pos) {
+  for(size_t from=m_cur; next_tag(from, pos); from=pos+1) {
+    if( is_tag(pos, "tick") )
+      return tick_elt;
+    if( is_tag(pos, "header") )
+      return header_elt;
+    if( is_tag(pos, "/Log") )
+      break;
+  }
+  return end_elt;
+}
+
+bool log_stream::extract(std::string const &tag, size_t pos,
+                         log_stream::ptree &pt) {
+  size_t end;
+  
+  if( !find(">", pos, end) ) {
+    m_truncated = true;
+    return false;
+  }
+  if( '/'!=m_buf[end-1] ) {
+    // look for the closing tag
+    std::string const close = "/"+tag;
+    bool found = false;
+    
+    for(size_t from=end+1; !found && next_tag(from, end); from=end+1)
+      found = is_tag(end, close);
+    if( !( found && find(">", end, end) ) ) {
+      m_truncated = true;
+      return false;
+    }
+  }
+  ++end;
+  std::istringstream elt(m_buf.substr(pos, end-pos));
+  m_cur = end;
+  discard();
+  pt.clear();
+  read_xml(elt, pt, xml::no_comments|xml::trim_whitespace);
+  return true;
+}
+
+bool log_stream::tick_value(size_t pos, TICK &val) {
+  size_t end;
+  if( !find(">", pos, end) )
+    return false;
+  std::string const tag = m_buf.substr(pos, end-pos);
+  size_t first = tag.find("value=\"");
+  if( std::string::npos==first )
+    return false;
+  first += 7;
+  try {
+    val = boost::lexical_cast<TICK>(tag.substr(first,
+                                               tag.find('"', first)-first));
+    return true;
+  } catch(boost::bad_lexical_cast const &) {
+    return false;
+  }
+}
+
+void log_stream::discard() {
+  m_base += m_cur;
+  m_buf.erase(0, m_cur);
+  m_cur = 0;
+}
+
+void log_stream::seek(std::streamoff off) {
+  m_in.clear();
+  m_in.seekg(off, std::ios::beg);
+  m_buf.clear();
+  m_base = off;
+  m_cur = 0;
+}
@@ -0,0 +1,173 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef H_trex_transaction_log_stream
+# define H_trex_transaction_log_stream
+
+# include "../Tick.hh"
+
+# include <trex/utils/log_ifstream.hh>
+
+# include <string>
+# include <vector>
+
+# include <boost/property_tree/ptree.hpp>
+
+namespace TREX {
+  namespace transaction {
+    namespace details {
+
+      /** @brief Incremental transaction log reader
+       *
+       * A pull reader that extracts the @c header and @c tick elements 
+       * of an XML transaction log one at a time. Only the text of the 
+       * element being extracted is kept in memory and parsed into a 
+       * property tree, allowing to replay logs of any length.
+       *
+       * It also manages the tick index: a sidecar file that associates 
+       * to every tick of the log the offset of its element in the 
+       * file. This index allows to jump directly to a given tick.
+       *
+       * @relates LogPlayer
+       * @ingroup transaction
+       */
+      class log_stream :boost::noncopyable {
+      public:
+        typedef boost::property_tree::ptree ptree;
+
+        /** @brief Constructor
+         *
+         * @param[in] file A transaction log file
+         *
+         * @throw utils::Exception Unable to open @p file
+         */
+        explicit log_stream(std::string const &file);
+        /** @brief Destructor */
+        ~log_stream() {}
+
+        /** @brief Read log header
+         *
+         * @param[out] pt A property tree
+         *
+         * Read the header of the log into @p pt. This method should be 
+         * called before any call to next()
+         *
+         * @retval true if the log header was found
+         * @retval false otherwise
+         */
+        bool header(ptree &pt);
+        /** @brief Read next tick
+         *
+         * @param[out] pt A property tree
+         *
+         * Read the next @c tick element of the log into @p pt
+         *
+         * @retval true if a tick was read
+         * @retval false if the end of the log was reached
+         */
+        bool next(ptree &pt);
+        /** @brief Check for truncated log
+         *
+         * @retval true if the log ended in the middle of a tick
+         * @retval false otherwise
+         */
+        bool truncated() const {
+          return m_truncated;
+        }
+
+        /** @brief Load the tick index
+         *
+         * @param[in] file An index file
+         *
+         * @retval true if @p file was loaded
+         * @retval false if @p file does not exist or does not match 
+         *         this log
+         */
+        bool load_index(std::string const &file);
+        /** @brief Build the tick index
+         *
+         * Scan the whole log to build its tick index. The ticks are 
+         * only located, not parsed.
+         */
+        void build_index();
+        /** @brief Save the tick index
+         *
+         * @param[in] file An index file
+         *
+         * @retval true if the index was written into @p file
+         * @retval false otherwise
+         */
+        bool save_index(std::string const &file) const;
+        /** @brief Jump to a tick
+         *
+         * @param[in] tck A tick
+         *
+         * @pre the index has been loaded or built
+         *
+         * Move the reader to the first tick of the log which is not 
+         * before @p tck. The index is released afterward.
+         */
+        void seek_tick(TICK tck);
+
+      private:
+        enum element {
+          header_elt,
+          tick_elt,
+          end_elt
+        };
+        typedef std::vector< std::pair<TICK, std::streamoff> > index_type;
+
+        bool fetch();
+        bool ensure(size_t pos, size_t len);
+        bool find(char const *pat, size_t from, size_t &pos);
+        bool is_tag(size_t pos, std::string const &tag);
+        bool next_tag(size_t from, size_t &pos);
+        element next_element(size_t &pos);
+        bool extract(std::string const &tag, size_t pos, ptree &pt);
+        bool tick_value(size_t pos, TICK &val);
+        void discard();
+        void seek(std::streamoff off);
+
+        utils::log_ifstream m_in;
+        std::streamoff m_size, m_base;
+        std::string    m_buf;
+        size_t         m_cur;
+        bool           m_truncated;
+        index_type     m_index;
+      }; // TREX::transaction::details::log_stream
+
+    } // TREX::transaction::details
+  } // TREX::transaction
+} // TREX
+
+#endif // H_trex_transaction_log_stream
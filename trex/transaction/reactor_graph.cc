@@ -34,6 +34,7 @@
 #include "reactor_graph.hh"
 #include "private/graph_impl.hh"
 #include "TeleoReactor.hh"
+#include "ObservationJournal.hh"
 
 #include <boost/date_time/posix_time/posix_time_io.hpp>
 
@@ -166,7 +167,7 @@ graph::graph()
 #else 
 :m_impl(new details::graph_impl)
 #endif
-{}
+, m_updated(true) {}
 
 graph::graph(utils::Symbol const &name, TICK init, bool verbose)
 #ifdef WITH_MAKE_SHARED
@@ -174,7 +175,7 @@ graph::graph(utils::Symbol const &name, TICK init, bool verbose)
 #else 
 :m_impl(new details::graph_impl(name))
 #endif
-, m_verbose(verbose) {
+, m_verbose(verbose), m_updated(true) {
   m_impl->set_date(init);
 }
 
@@ -185,7 +186,7 @@ graph::graph(utils::Symbol const &name, boost::property_tree::ptree &conf,
 #else
 :m_impl(new details::graph_impl(name))
 #endif
-, m_verbose(verbose) {
+, m_verbose(verbose), m_updated(true) {
   m_impl->set_date(init);
   
   size_t number = add_reactors(conf);
@@ -246,6 +247,17 @@ TREX::utils::LogManager &graph::manager() const {
   return m_impl->manager();
 }
 
+void graph::open_journal(std::string const &file) {
+  std::string name = manager().file_name(file).string();
+  m_journal.reset(new obs_journal::writer(name, manager().service()));
+  syslog(null, info)<<"Observations recorded in \""<<name<<"\".";
+}
+
+void graph::journal(TICK date, std::vector<observation_id> const &batch) const {
+  if( m_journal )
+    m_journal->write(date, batch);
+}
+
 
 void graph::clear() {
   while( !m_reactors.empty() ) {
@@ -255,6 +267,19 @@ void graph::clear() {
     m_reactors.pop_front();
   } 
   m_quarantined.clear();
+  structure_updated();
+}
+
+void graph::structure_updated() const {
+  m_updated = true;
+}
+
+bool graph::structure_changed(bool reset) {
+  utils::SharedVar<bool>::scoped_lock lock(m_updated);
+  bool ret = *m_updated;
+  if( reset )
+    *m_updated = false;
+  return ret;
 }
 
 long graph::index(graph::reactor_id id) const {
@@ -273,9 +298,10 @@ graph::reactor_id graph::add_reactor(boost::property_tree::ptree::value_type &de
   SHARED_PTR<TeleoReactor> tmp(m_factory->produce(arg));
   std::pair<details::reactor_set::iterator, bool> ret = m_reactors.insert(tmp);
 
-  if( ret.second ) 
+  if( ret.second ) {
     syslog(info)<<"Reactor \""<<tmp->getName()<<"\" created.";
-  else
+    structure_updated();
+  } else
     throw MultipleReactors(*this, **(ret.first));			   
   return ret.first->get();
 }
@@ -284,6 +310,8 @@ graph::reactor_id graph::add_reactor(graph::reactor_id r) {
   SHARED_PTR<TeleoReactor> tmp(r);
   std::pair<details::reactor_set::iterator, bool> ret = m_reactors.insert(tmp);
   // As it is an internal call make is silent for now ...
+  if( ret.second )
+    structure_updated();
   return ret.first->get();
 }
 
@@ -332,6 +360,7 @@ bool graph::kill_reactor(graph::reactor_id r) {
       // std::cerr<<"Erase the reactor"<<std::endl;
       m_reactors.erase(pos);
       /// std::cerr<<"Done."<<std::endl;
+      structure_updated();
       return true;
     }
   }
@@ -345,6 +374,7 @@ graph::reactor_id graph::isolate(graph::reactor_id r) const {
       syslog(info)<<"Putting reactor\""<<r->getName()<<"\" in quarantine.";
       r->isolate();
       m_quarantined.insert(*pos);
+      structure_updated();
       return r;
     }
   }
@@ -38,6 +38,7 @@
 # include "bits/timeline.hh"
 
 # include <trex/utils/TimeUtils.hh>
+# include <trex/utils/SharedVar.hh>
 
 # include <boost/graph/graph_traits.hpp>
 # include <boost/graph/adjacency_iterator.hpp>
@@ -55,6 +56,10 @@ namespace TREX {
     using utils::log::warn;
     using utils::log::error;
     
+    namespace obs_journal {
+      class writer;
+    }
+    
     /** @brief Conflicting reactor names
      *
      * This mthod is throwned when multiple reactors in a graph have the
@@ -660,6 +665,20 @@ namespace TREX {
       void set_verbose(bool flag=true) {
         m_verbose = flag;
       }
+      /** @brief Check for observation journal
+       *
+       * @retval true if the observations of this graph are recorded in 
+       *         an observation journal
+       * @retval false otherwise
+       *
+       * When there is no journal all the observations are echoed in the 
+       * system log. Otherwise only the ones of verbose reactors are.
+       *
+       * @sa open_journal(std::string const &)
+       */
+      bool has_journal() const {
+        return NULL!=m_journal.get();
+      }
       
       goal_id parse_goal(boost::property_tree::ptree::value_type goal) const;
       boost::property_tree::ptree export_goal(goal_id const &g) const;
@@ -682,6 +701,17 @@ namespace TREX {
       
       void updateTick(TICK value, bool started=true);
       void set_name(TREX::utils::Symbol const &name);
+      /** @brief Create the observation journal
+       *
+       * @param[in] file The journal file name
+       *
+       * Start to record all the observations produced by the reactors of 
+       * this graph in the journal @p file located in the log directory
+       *
+       * @sa obs_journal::writer
+       * @sa has_journal() const
+       */
+      void open_journal(std::string const &file="observations.tsv");
       
       
       TREX::utils::LogManager &manager() const;
@@ -738,7 +768,55 @@ namespace TREX {
        */
       virtual void external_check(reactor_id r, details::timeline const &tl) {}
       
+      /** @brief Check for graph structure changes
+       *
+       * @param[in] reset reset flag
+       *
+       * Checks if the structure of this graph has been modified since 
+       * the last reset. The structure of the graph is considered modified 
+       * when a reactor is added, isolated or removed or when a timeline 
+       * is declared, undeclared, used or released by one of the reactors.
+       * 
+       * This allows derived classes to cache information computed from 
+       * the graph structure -- such as the reactors synchronization order 
+       * -- and update it only when needed.
+       *
+       * @param[in] reset If @c true the modification flag is reset by this 
+       *            call
+       *
+       * @retval true if the graph structure changed since the last reset
+       * @retval false otherwise
+       */
+      bool structure_changed(bool reset=true);
+      
+      /** @brief Work availability notification
+       *
+       * @param[in] r A reactor
+       *
+       * This callback is called whenever the reactor @p r received new 
+       * information that may require it to deliberate -- such as new 
+       * goals, recalls or plan tokens -- or when @p r explicitly 
+       * indicated that it has work to do.
+       *
+       * It allows derived classes to reevaluate the @c workRatio of 
+       * @p r without waiting for their next scheduling pass.
+       * The default implementation does nothing.
+       *
+       * @note This callback can be called from any thread
+       *
+       * @sa TeleoReactor::notifyWork()
+       */
+      virtual void work_available(reactor_id /*r*/) {}
+      
     private:
+      /** @brief Graph structure modification notifier
+       *
+       * Indicates that the structure of the graph has been modified
+       *
+       * @sa structure_changed(bool)
+       */
+      void structure_updated() const;
+      
       
       bool assign(reactor_id r, TREX::utils::Symbol const &timeline,
                   details::transaction_flags const &flags);
@@ -746,6 +824,15 @@ namespace TREX {
                      details::transaction_flags const &flags);
       
       details::timeline_set::iterator get_timeline(TREX::utils::Symbol const &tl);
+      /** @brief Record observations
+       *
+       * @param[in] date The current tick
+       * @param[in] batch The observations posted during a reactor 
+       *            synchronization
+       *
+       * Write @p batch in the observation journal, if any
+       */
+      void journal(TICK date, std::vector<observation_id> const &batch) const;
       
       details::reactor_set     m_reactors;
       details::timeline_set    m_timelines;
@@ -757,6 +844,8 @@ namespace TREX {
       TREX::utils::SingletonUse<xml_factory>             m_factory;
       
       mutable details::reactor_set m_quarantined;
+      mutable TREX::utils::SharedVar<bool> m_updated;
+      SHARED_PTR<obs_journal::writer>      m_journal;
       
       friend class TeleoReactor;
       friend class timelines_listener;
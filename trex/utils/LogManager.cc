@@ -65,6 +65,7 @@ using namespace boost::filesystem;
 // structors :
 
 LogManager::LogManager():m_inited(false), m_syslog(m_io.service()), m_level(TREX_LOG_LEVEL) {
+  m_syslog.verbosity(m_level);
   // Disabled following code as it is not thread safe
   /*
   // Capture standard output and error in TREX.log
@@ -81,12 +82,15 @@ LogManager::~LogManager() {
   m_out.reset();
   m_log.reset();
   m_err.reset();
+  flush();
 }
 
 // methods :
 
 void LogManager::flush() {
-  m_trex_log->flush();
+  m_syslog.flush();
+  if( m_trex_log )
+    m_trex_log->flush();
 }
 
 
@@ -170,7 +174,8 @@ LogManager::path_type const &LogManager::logPath() {
     
     trex_log /= TREX_LOG_FILE;
     m_trex_log.reset(new log::out_file(trex_log.string()));
-    m_syslog.direct_connect(m_syslog.stranded(*m_trex_log).track_foreign(m_trex_log));
+    // the log writer is already serialized: no need for a strand
+    m_syslog.direct_connect(log::text_log::slot_type(*m_trex_log).track_foreign(m_trex_log));
     
     thread_count(2);
     
@@ -265,6 +270,7 @@ bool LogManager::setLogLevel(LogLevel lvl) {
   SharedVar<bool>::scoped_lock guard(m_inited);
   if( !*m_inited ) {
     m_level = lvl;
+    m_syslog.verbosity(lvl);
     return true;
   }
   syslog("", log::error)<<"Cannot change verbosity level after init."<<std::endl;
@@ -175,10 +175,12 @@ namespace TREX {
     class LogManager :boost::noncopyable {
     public:
       
-      /** @brief Log verbosity level */
+      /** @brief Log verbosity level 
+       * @sa log::text_log::verbosity(unsigned)
+       */
       enum LogLevel {
-        LogMin = 0,  //!< Minimum verbosity
-        LogNormal,   //!< Normal level
+        LogMin = 0,  //!< Minimum verbosity (all but debug messages)
+        LogNormal,   //!< Normal level (all but debug messages)
         LogExtensive //!< High verbosity (usually for debugging)
       };
       typedef boost::filesystem::path path_type;
@@ -285,7 +287,8 @@ namespace TREX {
       /** @brief Set verbosity level
        * @param[in] lvl current verbosity level
        *
-       * Sets the verbosity level to @p lvl
+       * Sets the verbosity level to @p lvl. The messages below this 
+       * level are rejected by syslog() before being formatted.
        *
        * @pre The verbosity level cannot be changed after the
        * LogManager has been fully initialized
@@ -55,7 +55,12 @@
 
 # include <boost/flyweight.hpp>
 # include <boost/flyweight/no_tracking.hpp>
+# include <boost/flyweight/no_locking.hpp>
 # include <boost/flyweight/holder_tag.hpp>
+# include <boost/flyweight/factory_tag.hpp>
+# include <boost/detail/atomic_count.hpp>
+# include <boost/thread/mutex.hpp>
+# include <boost/unordered_set.hpp>
 
 # include "IOstreamable.hh"
 # include "Hashable.hh"
@@ -69,8 +74,10 @@ namespace TREX {
     class trex_holder_class {
     public:
       static C& get() {
-        static SingletonUse<C> hold;
-        return *hold;
+        // Never released: symbols can still be created by other
+        // singletons destructors during the program exit
+        static SingletonUse<C> *hold = new SingletonUse<C>;
+        return **hold;
       }
     };
     
@@ -81,6 +88,140 @@ namespace TREX {
       };
     };
     
+    namespace details {
+      
+      template<class Entry, class Key>
+      class symbol_factory_class;
+      
+      /** @brief Interned symbol value
+       *
+       * @tparam Str The string type
+       *
+       * The value stored for each distinct symbol. Along with the string 
+       * itself it carries its hash -- computed once on creation -- and 
+       * an integer identifier given when this value is first interned.
+       *
+       * Identifiers are unique and never change during the program 
+       * lifetime. The empty string has the identifier 0 while the others 
+       * are numbered from 1 in the order they were first interned.
+       *
+       * @ingroup utils
+       * @relates BasicSymbol
+       */
+      template<class Str>
+      class symbol_entry {
+      public:
+        symbol_entry()
+          :m_hash(boost::hash<Str>()(m_name)), m_id(0) {}
+        explicit symbol_entry(Str const &name)
+          :m_name(name), m_hash(boost::hash<Str>()(name)), m_id(0) {}
+        ~symbol_entry() {}
+        
+        Str const &name() const {
+          return m_name;
+        }
+        size_t hash() const {
+          return m_hash;
+        }
+        size_t id() const {
+          return m_id;
+        }
+        
+        bool operator==(symbol_entry const &other) const {
+          return m_hash==other.m_hash && m_name==other.m_name;
+        }
+        
+      private:
+        Str    m_name;
+        size_t m_hash;
+        /** @brief Symbol identifier
+         *
+         * This value is set by the factory when the entry is interned 
+         * and is not part of the entry value.
+         */
+        mutable size_t m_id;
+        
+        template<class Entry, class Key>
+        friend class symbol_factory_class;
+      }; // TREX::utils::details::symbol_entry<>
+      
+      /** @brief Sharded symbol factory
+       *
+       * @tparam Entry The flyweight entry type
+       * @tparam Key The flyweight key type which is a symbol_entry
+       *
+       * The flyweight factory used by symbols. Entries are distributed 
+       * among a fixed number of shards based on their precomputed hash 
+       * and each shard is protected by its own mutex. This factory is 
+       * therefore thread safe by itself and does not require the 
+       * flyweight locking policy: reactor threads creating symbols at 
+       * the same time will only contend when their symbols fall in the 
+       * same shard.
+       *
+       * This factory does not support entries removal which is fine as 
+       * symbols do not use tracking.
+       *
+       * @ingroup utils
+       * @relates BasicSymbol
+       */
+      template<class Entry, class Key>
+      class symbol_factory_class :public boost::flyweights::factory_marker {
+        struct entry_hash {
+          size_t operator()(Entry const &e) const {
+            return static_cast<Key const &>(e).hash();
+          }
+        };
+        struct entry_equal {
+          bool operator()(Entry const &a, Entry const &b) const {
+            return static_cast<Key const &>(a)==static_cast<Key const &>(b);
+          }
+        };
+        typedef boost::unordered_set<Entry, entry_hash, entry_equal> set_type;
+        
+        struct shard {
+          boost::mutex mtx;
+          set_type     entries;
+        };
+        
+        enum { shard_count = 16 };
+        
+      public:
+        typedef Entry const *handle_type;
+        
+        symbol_factory_class():m_last_id(0) {}
+        ~symbol_factory_class() {}
+        
+        handle_type insert(Entry const &x) {
+          Key const &key = x;
+          shard &s = m_shards[key.hash()%shard_count];
+          boost::mutex::scoped_lock lock(s.mtx);
+          std::pair<typename set_type::iterator, bool> ret = s.entries.insert(x);
+          Key const &inserted = *(ret.first);
+          
+          if( ret.second && !inserted.name().empty() )
+            inserted.m_id = ++m_last_id;
+          return &*(ret.first);
+        }
+        void erase(handle_type) {}
+        
+        static Entry const &entry(handle_type h) {
+          return *h;
+        }
+        
+      private:
+        shard                      m_shards[shard_count];
+        boost::detail::atomic_count m_last_id;
+      }; // TREX::utils::details::symbol_factory_class<>
+      
+    } // TREX::utils::details
+    
+    struct symbol_factory :boost::flyweights::factory_marker {
+      template<typename Entry, typename Key>
+      struct apply {
+        typedef details::symbol_factory_class<Entry, Key> type;
+      };
+    };
+    
   }
 }
 
@@ -89,6 +230,8 @@ namespace boost {
     
     template<>
     struct is_holder<TREX::utils::trex_holder_specifier> :boost::mpl::true_ {};
+    template<>
+    struct is_factory<TREX::utils::symbol_factory> :boost::mpl::true_ {};
     
   }
 }
@@ -109,6 +252,10 @@ namespace TREX {
      * on a unique reference memory managed by a reference counter
      * to ensure both equality efficiency and better memory management.
      *
+     * Each symbol value also carries its hash and a unique integer 
+     * id() computed once when it is first created. As a result hashing 
+     * a symbol is done in constant time and containers that do not need 
+     * lexical order can use id_less instead of @c std::less.
      *
      * @author Frederic Py <fpy@mbari.org>
      * @ingroup utils
@@ -132,10 +279,14 @@ namespace TREX {
        * can change it back by removing this.
        * @note @c intermodule_holder is used to support dynmic
        * libraries loading (and/or plug-ins)
+       * @note The symbol_factory does its own locking which is why 
+       * there's no locking policy here
        */
       typedef typename
-      boost::flyweight< str_type,
+      boost::flyweight< details::symbol_entry<str_type>,
       boost::flyweights::no_tracking,
+      boost::flyweights::no_locking,
+      symbol_factory,
       boost::flyweights::holder<trex_holder_specifier> > ref_type;
       
     public:
@@ -207,14 +358,14 @@ namespace TREX {
        * @sa size_t length() const
        */
       bool empty() const {
-        return m_name.get().empty();
+        return m_name.get().name().empty();
       }
       /** @brief Symbol length
        *
        * @return the length of the string representing this instance
        */
       size_t length() const {
-        return size_t(empty()?0:m_name.get().size());
+        return size_t(empty()?0:m_name.get().name().size());
       }
       
       /** @brief Equality test
@@ -309,13 +460,45 @@ namespace TREX {
        * @return the equivalent string value to this instance
        */
       str_type const &str() const {
-        return m_name.get();
+        return m_name.get().name();
       }
       
       CharT const *c_str() const {
         return str().c_str();
       }
       
+      /** @brief Symbol identifier
+       *
+       * An integer that uniquely identifies the value of this symbol 
+       * during the program lifetime. The empty symbol has the identifier 
+       * 0 and other symbols are numbered in the order they were first 
+       * created.
+       *
+       * @note This identifier depends on the order symbols were created 
+       * and should not be used for anything that outlives the program 
+       * such as logs.
+       *
+       * @sa struct id_less
+       */
+      size_t id() const {
+        return m_name.get().id();
+      }
+      
+      /** @brief Identifier based ordering
+       *
+       * A comparison functor that orders symbols based on their id(). 
+       * It is a valid alternative to @c std::less for containers that do 
+       * not need symbols in lexical order as it is done in constant time 
+       * while operator< requires a string comparison.
+       *
+       * @sa size_t id() const
+       */
+      struct id_less {
+        bool operator()(BasicSymbol const &a, BasicSymbol const &b) const {
+          return a.id()<b.id();
+        }
+      }; // TREX::utils::BasicSymbol<>::id_less
+      
       
     private:
       /** @brief symbol value */
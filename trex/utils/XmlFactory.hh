@@ -208,9 +208,12 @@ namespace TREX {
       
       /** @brief Subjacent factory
        *
-       * The factory used underneath to implement this XmlFactory
+       * The factory used underneath to implement this XmlFactory. 
+       * Producers are sorted by their symbol id as we only need to 
+       * look them up by name.
        */
-      typedef Factory<Product, Symbol, argument_type, Output> factory_type;
+      typedef Factory<Product, Symbol, argument_type, Output, 
+                      Symbol::id_less> factory_type;
       typedef typename factory_type::returned_type returned_type;
       
       
@@ -32,31 +32,119 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  */
 #include "asio_fstream.hh"
+#include "log_ifstream.hh"
 
 #include <boost/bind.hpp>
-#include "platform/chrono.hh"
-#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/asio/deadline_timer.hpp>
 
-#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#ifdef TREX_HAS_ZLIB
+# include <zlib.h>
+#endif // TREX_HAS_ZLIB
 
 namespace asio=boost::asio;
 
 namespace TREX {
   namespace utils {
-  
+    
+    /** @brief async_ofstream data buffer
+     *
+     * A fixed size chunk of text used to build the async_ofstream entries. 
+     * Buffers are chained together to form an entry or the list of data 
+     * pending to be written in a file. They are allocated from a shared 
+     * pool so they can be reused once written instead of being reallocated 
+     * for every entry.
+     */
+    class async_ofstream::buffer :boost::noncopyable {
+    public:
+      enum {
+        capacity = 4096 ///< Number of bytes a buffer can hold
+      };
+      
+      buffer *next;
+      size_t  size;
+      char    data[capacity];
+      
+      size_t available() const {
+        return capacity-size;
+      }
+      
+      /** @brief Get a new buffer
+       *
+       * Get an empty buffer from the pool or allocate a new one if the pool 
+       * is empty
+       */
+      static buffer *get();
+      /** @brief Release a buffer chain
+       *
+       * @param[in] first The head of the chain
+       *
+       * Give back all the buffers chained from @p first to the pool. Buffers 
+       * exceeding the pool capacity are freed.
+       */
+      static void release(buffer *first);
+      
+    private:
+      buffer():next(NULL), size(0) {}
+      ~buffer() {}
+      
+      struct pool;
+      static pool &get_pool();
+    };
+    
+    struct async_ofstream::buffer::pool {
+      enum {
+        max_free = 256 ///< Maximum number of idle buffers kept
+      };
+      
+      pool():idle(NULL), count(0) {}
+      
+      boost::mutex mtx;
+      buffer      *idle;
+      size_t       count;
+    };
     
     class async_ofstream::pimpl:public ENABLE_SHARED_FROM_THIS<async_ofstream::pimpl> {
     public:
       typedef async_ofstream::service service;
-      typedef CHRONO::system_clock    clock;
-      
       
-      pimpl(asio::io_service &io, std::string const &path)
-      :m_io(io), m_file(MAKE_SHARED<std::ofstream>()) {
-        get_service().post(boost::bind(&pimpl::open, m_file, path));
+      pimpl(asio::io_service &io, std::string const &path,
+            flush_policy const &policy, storage_policy const &storage)
+      :m_io(io), m_path(path), m_policy(policy), m_storage(storage),
+       m_part(0), m_written(0), m_timer(io), m_first(NULL), m_last(NULL),
+       m_pending(0), m_posted(false), m_armed(false), m_errno(0) {
+#ifdef TREX_HAS_ZLIB
+        if( m_storage.compress ) {
+          m_zip.zalloc = Z_NULL;
+          m_zip.zfree = Z_NULL;
+          m_zip.opaque = Z_NULL;
+          // 15+16 window bits produces a gzip stream
+          m_storage.compress = Z_OK==deflateInit2(&m_zip, Z_DEFAULT_COMPRESSION,
+                                                  Z_DEFLATED, 15+16, 8,
+                                                  Z_DEFAULT_STRATEGY);
+        }
+#else
+        m_storage.compress = false;
+#endif // TREX_HAS_ZLIB
+        open_part();
       }
       ~pimpl() {
-        get_service().post(boost::bind(&std::ofstream::close, m_file));
+        write_pending();
+        close_part();
+#ifdef TREX_HAS_ZLIB
+        if( m_storage.compress )
+          deflateEnd(&m_zip);
+#endif // TREX_HAS_ZLIB
         m_work.reset();
       }
     
@@ -64,38 +152,109 @@ namespace TREX {
         return boost::asio::use_service<service>(m_io);
       }
       
-      void async_write(std::string const &buffer) {
-        get_service().post(boost::bind(&pimpl::write, shared_from_this(), buffer, clock::now()));
-      }
-      void write(std::string buffer, clock::time_point tp) {
-        
-        m_file->write(buffer.c_str(), buffer.length());
-        if( !m_last ) {
-          m_last = tp;
-        }
-
-        CHRONO::milliseconds const limit(10), // force flush only at ~100Hz
-          delta = CHRONO::duration_cast<CHRONO::milliseconds>(clock::now()-*m_last);
-        if( delta>limit ) {
-          std::flush(*m_file);
-          m_last = tp;
-        }
-      }
-      
-      static void open(SHARED_PTR<std::ofstream> f, std::string p) {
-        f->open(p.c_str());
+      /** @brief Queue an entry
+       *
+       * @param[in] first The first buffer of the entry
+       *
+       * Append the buffers chained from @p first to the data pending to 
+       * be written. Small buffers are merged into the last pending buffer 
+       * when it has enough space left so the number of buffers written 
+       * stays close to the actual amount of data. The drain of the queue 
+       * is then scheduled according to the flush_policy.
+       */
+      void submit(buffer *first);
+      /** @brief Request a drain
+       *
+       * Schedule the write of all the pending data regardless of the 
+       * flush_policy.
+       */
+      void flush() {
+        boost::lock_guard<boost::mutex> lock(m_mtx);
+        if( NULL!=m_first )
+          schedule_drain();
       }
+      /** @brief Write pending data
+       *
+       * Synchronously write all the data pending for this file with as few 
+       * @c writev calls as possible.
+       */
+      void write_pending();
+      /** @brief Close the file
+       *
+       * Cancel the pending flush timer, then synchronously write all the 
+       * data pending for this file and finish it -- including the gzip 
+       * trailer of a compressed file. Data submitted after this call is 
+       * dropped.
+       */
+      void close();
       
       void set_work(SHARED_PTR<asio::io_service::work> wk) {
         m_work = wk;
       }
       
+      /** @brief Last error
+       *
+       * @return the @c errno value of the first failure to open or write 
+       *   this file or 0 if none occurred
+       */
+      int error() const {
+        boost::lock_guard<boost::mutex> lock(m_mtx);
+        return m_errno;
+      }
+      
     private:
-      asio::io_service   &m_io;
-      SHARED_PTR<std::ofstream> m_file;
-      SHARED_PTR<asio::io_service::work>    m_work;
+      void schedule_drain();
+      void drain();
+      void timeout(boost::system::error_code const &e);
+      /** @brief Write pending data
+       *
+       * @pre m_write_mtx is locked
+       * @sa write_pending()
+       */
+      void write_queue();
+      void write_all(buffer *first);
+      /** @brief Record an error
+       *
+       * @param[in] err An @c errno value
+       *
+       * Store @p err as the error of this file unless one was already 
+       * recorded
+       */
+      void failed(int err);
+      
+      void open_part();
+      void close_part();
+#ifdef TREX_HAS_ZLIB
+      /** @brief Compress data
+       *
+       * @param[in] in A buffer chain
+       * @param[in] mode zlib flush mode
+       *
+       * Feed the content of @p in to the gzip stream and apply @p mode
+       * once all of it is consumed.
+       *
+       * @return a new buffer chain with the compressed data produced
+       */
+      buffer *compress(buffer *in, int mode);
       
-      boost::optional<clock::time_point> m_last;
+      z_stream m_zip;
+#endif // TREX_HAS_ZLIB
+      
+      asio::io_service                   &m_io;
+      std::string                         m_path;
+      int                                 m_fd;
+      flush_policy                        m_policy;
+      storage_policy                      m_storage;
+      size_t                              m_part, m_written;
+      asio::deadline_timer                m_timer;
+      SHARED_PTR<asio::io_service::work>  m_work;
+
+      mutable boost::mutex m_mtx;
+      boost::mutex m_write_mtx;
+      buffer      *m_first, *m_last;
+      size_t       m_pending;
+      bool         m_posted, m_armed;
+      int          m_errno;
     };
         
   }
@@ -103,17 +262,330 @@ namespace TREX {
 
 using namespace TREX::utils;
 
+/*
+ * class TREX::utils::async_ofstream::buffer
+ */
+
+async_ofstream::buffer::pool &async_ofstream::buffer::get_pool() {
+  // never destroyed as buffers may still be released during exit
+  static pool *s_pool = new pool;
+  return *s_pool;
+}
+
+async_ofstream::buffer *async_ofstream::buffer::get() {
+  pool &p = get_pool();
+  {
+    boost::lock_guard<boost::mutex> lock(p.mtx);
+    if( NULL!=p.idle ) {
+      buffer *ret = p.idle;
+      p.idle = ret->next;
+      --p.count;
+      ret->next = NULL;
+      ret->size = 0;
+      return ret;
+    }
+  }
+  return new buffer;
+}
+
+void async_ofstream::buffer::release(async_ofstream::buffer *first) {
+  pool &p = get_pool();
+  buffer *extra = NULL;
+  {
+    boost::lock_guard<boost::mutex> lock(p.mtx);
+    while( NULL!=first && p.count<pool::max_free ) {
+      buffer *b = first;
+      first = b->next;
+      b->next = p.idle;
+      p.idle = b;
+      ++p.count;
+    }
+    extra = first;
+  }
+  while( NULL!=extra ) {
+    buffer *b = extra;
+    extra = b->next;
+    delete b;
+  }
+}
+
+/*
+ * class TREX::utils::async_ofstream::pimpl
+ */
+
+void async_ofstream::pimpl::submit(async_ofstream::buffer *first) {
+  boost::lock_guard<boost::mutex> lock(m_mtx);
+  
+  while( NULL!=first ) {
+    buffer *b = first;
+    first = b->next;
+    b->next = NULL;
+    m_pending += b->size;
+    if( NULL!=m_last && b->size<=m_last->available() ) {
+      // coalesce with the tail of the queue
+      std::memcpy(m_last->data+m_last->size, b->data, b->size);
+      m_last->size += b->size;
+      buffer::release(b);
+    } else {
+      if( NULL==m_last )
+        m_first = b;
+      else
+        m_last->next = b;
+      m_last = b;
+    }
+  }
+  if( m_pending>=m_policy.bytes )
+    schedule_drain();
+  else if( !(m_posted || m_armed) &&
+           m_policy.period>CHRONO::milliseconds::zero() ) {
+    m_armed = true;
+    m_timer.expires_from_now(boost::posix_time::milliseconds(m_policy.period.count()));
+    m_timer.async_wait(boost::bind(&pimpl::timeout, shared_from_this(),
+                                   asio::placeholders::error));
+  }
+}
+
+void async_ofstream::pimpl::schedule_drain() {
+  // m_mtx is expected to be locked
+  if( !m_posted ) {
+    m_posted = true;
+    get_service().post(boost::bind(&pimpl::drain, shared_from_this()));
+  }
+}
+
+void async_ofstream::pimpl::timeout(boost::system::error_code const &e) {
+  boost::lock_guard<boost::mutex> lock(m_mtx);
+  m_armed = false;
+  if( !e && NULL!=m_first )
+    schedule_drain();
+}
+
+void async_ofstream::pimpl::drain() {
+  {
+    boost::lock_guard<boost::mutex> lock(m_mtx);
+    m_posted = false;
+  }
+  write_pending();
+}
+
+void async_ofstream::pimpl::write_pending() {
+  // Hold the write lock while taking the queue so data is written in the
+  // order it was submitted
+  boost::lock_guard<boost::mutex> write_lock(m_write_mtx);
+  write_queue();
+}
+
+void async_ofstream::pimpl::close() {
+  {
+    boost::lock_guard<boost::mutex> lock(m_mtx);
+    m_timer.cancel();
+  }
+  boost::lock_guard<boost::mutex> write_lock(m_write_mtx);
+  write_queue();
+  close_part();
+}
+
+void async_ofstream::pimpl::write_queue() {
+  buffer *first;
+  {
+    boost::lock_guard<boost::mutex> lock(m_mtx);
+    first = m_first;
+    m_first = m_last = NULL;
+    m_pending = 0;
+  }
+  if( m_fd<0 ) {
+    // the file is closed or could not be opened: drop the data
+    buffer::release(first);
+  } else if( NULL!=first ) {
+#ifdef TREX_HAS_ZLIB
+    if( m_storage.compress ) {
+      // sync flush so all the data drained is readable from the file
+      buffer *gz = compress(first, Z_SYNC_FLUSH);
+      buffer::release(first);
+      first = gz;
+    }
+#endif // TREX_HAS_ZLIB
+    write_all(first);
+    buffer::release(first);
+    if( m_storage.rotate>0 && m_written>=m_storage.rotate ) {
+      close_part();
+      ++m_part;
+      open_part();
+    }
+  }
+}
+
+void async_ofstream::pimpl::open_part() {
+  m_written = 0;
+  m_fd = ::open(log_part(m_path, m_part, m_storage.compress).c_str(),
+                O_WRONLY|O_CREAT|O_TRUNC, 0666);
+  if( m_fd<0 )
+    failed(errno);
+}
+
+void async_ofstream::pimpl::failed(int err) {
+  boost::lock_guard<boost::mutex> lock(m_mtx);
+  if( 0==m_errno )
+    m_errno = err;
+}
+
+void async_ofstream::pimpl::close_part() {
+  if( m_fd<0 )
+    return; // already closed or never opened
+#ifdef TREX_HAS_ZLIB
+  if( m_storage.compress ) {
+    buffer *trailer = compress(NULL, Z_FINISH);
+    write_all(trailer);
+    buffer::release(trailer);
+    deflateReset(&m_zip);
+  }
+#endif // TREX_HAS_ZLIB
+  if( 0!=::close(m_fd) )
+    failed(errno);
+  m_fd = -1;
+}
+
+#ifdef TREX_HAS_ZLIB
+
+async_ofstream::buffer *async_ofstream::pimpl::compress(async_ofstream::buffer *in,
+                                                        int mode) {
+  buffer *first = NULL, *last = NULL;
+  
+  do {
+    int flush = Z_NO_FLUSH, ret;
+    
+    if( NULL==in ) {
+      m_zip.next_in = Z_NULL;
+      m_zip.avail_in = 0;
+    } else {
+      m_zip.next_in = reinterpret_cast<Bytef *>(in->data);
+      m_zip.avail_in = in->size;
+    }
+    if( NULL==in || NULL==in->next )
+      flush = mode;
+    do {
+      if( NULL==last || 0==last->available() ) {
+        buffer *b = buffer::get();
+        if( NULL==last )
+          first = b;
+        else
+          last->next = b;
+        last = b;
+      }
+      m_zip.next_out = reinterpret_cast<Bytef *>(last->data+last->size);
+      m_zip.avail_out = last->available();
+      ret = deflate(&m_zip, flush);
+      last->size = reinterpret_cast<char *>(m_zip.next_out)-last->data;
+    } while( Z_STREAM_ERROR!=ret &&
+             ( 0==m_zip.avail_out || (Z_FINISH==flush && Z_STREAM_END!=ret) ) );
+    if( NULL!=in )
+      in = in->next;
+  } while( NULL!=in );
+  return first;
+}
+
+#endif // TREX_HAS_ZLIB
+
+void async_ofstream::pimpl::write_all(async_ofstream::buffer *first) {
+#if defined(IOV_MAX) && IOV_MAX<256
+  int const max_iov = IOV_MAX;
+#else
+  int const max_iov = 256;
+#endif
+  struct iovec iov[max_iov];
+  
+  if( m_fd<0 )
+    return; // the error was recorded by open_part
+  while( NULL!=first ) {
+    int n = 0, i = 0;
+    
+    for( ; NULL!=first && n<max_iov; first=first->next, ++n ) {
+      iov[n].iov_base = first->data;
+      iov[n].iov_len = first->size;
+    }
+    while( i<n ) {
+      ssize_t ret = ::writev(m_fd, iov+i, n-i);
+      
+      if( ret<0 ) {
+        if( EINTR==errno )
+          continue;
+        // give up on this batch and keep the error for flush/close
+        failed(errno);
+        break;
+      }
+      m_written += ret;
+      // skip what has been written and adjust a partially written buffer
+      for( ; i<n && static_cast<size_t>(ret)>=iov[i].iov_len; ++i )
+        ret -= iov[i].iov_len;
+      if( i<n ) {
+        iov[i].iov_base = static_cast<char *>(iov[i].iov_base)+ret;
+        iov[i].iov_len -= ret;
+      }
+    }
+  }
+}
+
 /*
  * class TREX::utils::async_ofstream
  */
 
-void async_ofstream::open(std::string const &fname) {
-  m_impl = MAKE_SHARED<pimpl>(boost::ref(m_io), fname);
+namespace {
+  boost::mutex                          s_storage_mtx;
+  async_ofstream::storage_policy        s_storage;
+}
+
+bool async_ofstream::compression_supported() {
+#ifdef TREX_HAS_ZLIB
+  return true;
+#else
+  return false;
+#endif // TREX_HAS_ZLIB
+}
+
+async_ofstream::storage_policy async_ofstream::default_storage() {
+  boost::lock_guard<boost::mutex> lock(s_storage_mtx);
+  return s_storage;
+}
+
+void async_ofstream::default_storage(async_ofstream::storage_policy const &policy) {
+  boost::lock_guard<boost::mutex> lock(s_storage_mtx);
+  s_storage = policy;
+}
+
+void async_ofstream::open(std::string const &fname,
+                          async_ofstream::flush_policy const &policy) {
+  open(fname, policy, default_storage());
+}
+
+void async_ofstream::open(std::string const &fname,
+                          async_ofstream::flush_policy const &policy,
+                          async_ofstream::storage_policy const &storage) {
+  m_errno = 0;
+  m_impl = MAKE_SHARED<pimpl>(boost::ref(m_io), fname, policy, storage);
   m_impl->get_service().async_reserve(boost::bind(&pimpl::set_work, m_impl, _1));
 }
 
-void async_ofstream::close() {
-  m_impl.reset();
+bool async_ofstream::close() {
+  int err = 0;
+  
+  if( m_impl ) {
+    m_impl->close();
+    err = m_impl->error();
+    m_impl.reset();
+  }
+  m_errno = err;
+  return 0==err;
+}
+
+void async_ofstream::flush() {
+  if( m_impl )
+    m_impl->flush();
+}
+
+int async_ofstream::error() const {
+  if( m_impl )
+    return m_impl->error();
+  return m_errno;
 }
 
 async_ofstream::entry async_ofstream::new_entry() {
@@ -123,27 +595,48 @@ async_ofstream::entry async_ofstream::new_entry() {
 /*
  * class TREX::utils::async_ofstream::entry_sink
  */
-async_ofstream::entry_sink::entry_sink() {}
+async_ofstream::entry_sink::entry_sink()
+:m_first(NULL), m_last(NULL) {}
 
 async_ofstream::entry_sink::entry_sink(SHARED_PTR<async_ofstream::pimpl> const &dest)
-:m_dest(dest) {}
+:m_dest(dest), m_first(NULL), m_last(NULL) {}
 
-async_ofstream::entry_sink::entry_sink(async_ofstream::entry_sink const &other) {
+async_ofstream::entry_sink::entry_sink(async_ofstream::entry_sink const &other)
+:m_first(NULL), m_last(NULL) {
   std::swap(m_dest, other.m_dest);
-  std::swap(m_cache, other.m_cache);
+  std::swap(m_first, other.m_first);
+  std::swap(m_last, other.m_last);
 }
 
 void async_ofstream::entry_sink::flush() {
-  if( m_dest && !m_cache.empty() ) {
-    std::string tmp;
-    std::swap(tmp, m_cache);
-    m_dest->async_write(tmp);
+  if( NULL!=m_first ) {
+    if( m_dest )
+      m_dest->submit(m_first);
+    else
+      buffer::release(m_first);
+    m_first = m_last = NULL;
   }
 }
 
 std::streamsize async_ofstream::entry_sink::write(async_ofstream::entry_sink::char_type const *s, std::streamsize n) {
   if( m_dest ) {
-    m_cache.append(s, n);
+    std::streamsize left = n;
+    
+    while( left>0 ) {
+      if( NULL==m_last || 0==m_last->available() ) {
+        buffer *b = buffer::get();
+        if( NULL==m_last )
+          m_first = b;
+        else
+          m_last->next = b;
+        m_last = b;
+      }
+      size_t len = std::min(static_cast<size_t>(left), m_last->available());
+      std::memcpy(m_last->data+m_last->size, s, len);
+      m_last->size += len;
+      s += len;
+      left -= len;
+    }
     return n;
   }
   return 0;
@@ -38,6 +38,7 @@
 # include "platform/cpp11_deleted.hh"
 # include "SharedVar.hh"
 # include "asio_runner.hh"
+# include "platform/chrono.hh"
 
 # include <boost/ref.hpp>
 # include <boost/iostreams/stream.hpp>
@@ -107,26 +108,138 @@ namespace TREX {
      * asynchronously. All the write operations of the different instances are 
      * manage by a single strand service eensuring that all the ourtputs are 
      * written in a sequence with limited risk of IO block in the main thread.
+     *
+     * Entries are built into fixed size buffers taken from a shared pool. 
+     * Completed entries are queued on their file and all the buffers queued 
+     * are then written at once with a single @c writev call. When this 
+     * happens is decided by the file flush_policy.
+     *
+     * The output can also be gzip compressed and split into multiple 
+     * files of limited size as described by its storage_policy. Both 
+     * are done by the thread that writes the file. Such output can be 
+     * read back with log_ifstream.
+     *
+     * @sa log_ifstream
      */
     class async_ofstream :boost::noncopyable {
       class pimpl;
+      class buffer;
     public:
       typedef stranded_service<pimpl> service;
       
+      /** @brief File flush policy
+       *
+       * Indicates when the data queued for a file is written
+       * @li as soon as at least @c bytes are queued
+       * @li at most @c period after being queued, unless @c period is 
+       *     zero
+       * @li whenever async_ofstream::flush() is called.
+       *
+       * For example @c flush_policy(0) writes every entry as soon as 
+       * possible while @c flush_policy(65536,CHRONO::milliseconds::zero())
+       * along with a call to flush() at the end of every tick produces 
+       * one write per tick for most of the files.
+       */
+      struct flush_policy {
+        explicit flush_policy(size_t b=65536,
+                              CHRONO::milliseconds p=CHRONO::milliseconds(10))
+        :bytes(b), period(p) {}
+        
+        size_t               bytes;
+        CHRONO::milliseconds period;
+      };
+      
+      /** @brief File storage policy
+       *
+       * Indicates how the output is stored on disk
+       * @li if @c compress is @c true the file is gzip compressed and 
+       *     a @c .gz extension is added to its name
+       * @li if @c rotate is not zero the output continues on a new file 
+       *     each time approximately @c rotate bytes were written in the 
+       *     current one. The files following @c name are named @c name.1,
+       *     @c name.2, ...
+       *
+       * @sa log_part(std::string const &, size_t, bool)
+       */
+      struct storage_policy {
+        explicit storage_policy(bool gz=false, size_t r=0)
+        :compress(gz), rotate(r) {}
+        
+        bool   compress;
+        size_t rotate;
+      };
+      
+      /** @brief Compression support
+       *
+       * @retval true if TREX was compiled with zlib
+       * @retval false otherwise, in which case compression is ignored
+       */
+      static bool compression_supported();
+      /** @brief Default storage policy
+       *
+       * @return the storage_policy used by all the files opened without 
+       * an explicit one. The default is to write uncompressed files 
+       * without rotation
+       */
+      static storage_policy default_storage();
+      /** @brief Set default storage policy
+       *
+       * @param[in] policy A storage policy
+       *
+       * Set the policy used by the files opened without an explicit 
+       * storage_policy to @p policy. This is meant to be set once at 
+       * the start of the program, only the files opened after this 
+       * call are affected.
+       */
+      static void default_storage(storage_policy const &policy);
+      
       explicit async_ofstream(boost::asio::io_service &service)
-      :m_io(service) {}
-      async_ofstream(boost::asio::io_service &service, std::string const &fname)
-      :m_io(service) {
-        open(fname);
+      :m_io(service), m_errno(0) {}
+      async_ofstream(boost::asio::io_service &service, std::string const &fname,
+                     flush_policy const &policy=flush_policy())
+      :m_io(service), m_errno(0) {
+        open(fname, policy);
+      }
+      async_ofstream(boost::asio::io_service &service, std::string const &fname,
+                     flush_policy const &policy, storage_policy const &storage)
+      :m_io(service), m_errno(0) {
+        open(fname, policy, storage);
       }
       
       ~async_ofstream() {}
       
-      void open(std::string const &fname);
-      void close();
+      void open(std::string const &fname,
+                flush_policy const &policy=flush_policy());
+      void open(std::string const &fname, flush_policy const &policy,
+                storage_policy const &storage);
+      /** @brief Close the file
+       *
+       * Synchronously write all the entries completed so far and close 
+       * the file. Once this call returns the file is complete, including 
+       * the trailer of a compressed file.
+       *
+       * @retval true if all the data was written
+       * @retval false if the file could not be opened or a write failed, 
+       *   error() then gives the reason
+       */
+      bool close();
       bool is_open() const {
         return NULL!=m_impl.get();
       }
+      /** @brief Flush the file
+       *
+       * Request to write all the entries completed so far regardless of 
+       * the flush policy. The write is asynchronous: its failure is 
+       * reported by error() once it is done or by close().
+       */
+      void flush();
+      /** @brief File error
+       *
+       * @return the @c errno value of the first failure to open or write 
+       *   the file since it was opened or 0 if none occurred. Data that 
+       *   could not be written is dropped.
+       */
+      int error() const;
       
       class entry;
       
@@ -148,7 +261,7 @@ namespace TREX {
         void flush();
         
         mutable SHARED_PTR<pimpl> m_dest;
-        mutable std::string       m_cache;
+        mutable buffer           *m_first, *m_last;
         
         friend class entry;
       };
@@ -195,6 +308,7 @@ namespace TREX {
     private:
       boost::asio::io_service &m_io;
       SHARED_PTR<pimpl>        m_impl;
+      int                      m_errno;
     };
     
     
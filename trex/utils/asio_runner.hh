@@ -45,6 +45,7 @@
 # include <boost/asio.hpp>
 # include <boost/smart_ptr.hpp>
 # include <boost/thread.hpp>
+# include <boost/utility/result_of.hpp>
 
 namespace TREX {
   namespace utils {
@@ -143,6 +144,87 @@ namespace TREX {
       boost::thread_group m_threads;
     }; // TREX::utils::asio_runner
     
+    namespace details {
+      
+      /** @brief Check if running in a service
+       *
+       * @param s An asio service
+       *
+       * @retval true if the calling thread is currently executing a
+       *   handler of @p s
+       * @retval false otherwise
+       *
+       * The generic version cannot tell and always return @c false
+       *
+       * @ingroup utils
+       */
+      template<class Service>
+      bool running_in(Service &/*s*/) {
+        return false;
+      }
+      /** @brief Check if running in a strand
+       *
+       * @param s An asio strand
+       *
+       * Specialized version for the strand type returned by 
+       * graph::strand() which allows strand_run to execute its call 
+       * directly when already in @p s
+       *
+       * @retval true if the calling thread is currently executing a
+       *   handler of @p s
+       * @retval false otherwise
+       *
+       * @ingroup utils
+       */
+      inline bool running_in(boost::asio::io_service::strand &s) {
+        return s.running_in_this_thread();
+      }
+      
+      /** @brief Synchronous call helper
+       *
+       * @tparam Ret The return type of the call
+       *
+       * The implementation of strand_run. It is a class in order to
+       * isolate the @c void return type which needs a different
+       * treatment.
+       *
+       * @ingroup utils
+       */
+      template<typename Ret>
+      struct sync_call {
+        template<class Service, class Fn>
+        static Ret run(Service &s, Fn const &f) {
+          if( running_in(s) )
+            // dispatch would execute f right now anyway
+            return f();
+          boost::packaged_task<Ret> tsk(f);
+          boost::unique_future<Ret> result = tsk.get_future();
+          
+          s.dispatch(boost::bind(&boost::packaged_task<Ret>::operator(),
+                                 boost::ref(tsk)));
+          return result.get();
+        }
+      }; // TREX::utils::details::sync_call<>
+      
+      template<>
+      struct sync_call<void> {
+        template<class Service, class Fn>
+        static void run(Service &s, Fn const &f) {
+          if( running_in(s) )
+            f();
+          else {
+            boost::packaged_task<void> tsk(f);
+            boost::unique_future<void> result = tsk.get_future();
+            
+            s.dispatch(boost::bind(&boost::packaged_task<void>::operator(),
+                                   boost::ref(tsk)));
+            result.get();
+          }
+        }
+      }; // TREX::utils::details::sync_call<void>
+      
+    } // TREX::utils::details
+    
     /** @brief synchronize asynchronous call
      *
      * @param s Executing service
@@ -156,7 +238,7 @@ namespace TREX {
      * was completd by @p s.
      *
      * @note If the caller is executed by @p s then the call of @p f will 
-     * be done immediately within this thread.
+     * be done immediately within this thread without any extra allocation.
      *
      * @return the value returned by @p f
      *
@@ -164,27 +246,26 @@ namespace TREX {
      */
     template<class Service, typename Ret>
     Ret strand_run(Service &s, boost::function<Ret ()> const &f) {
-      boost::packaged_task<Ret> tsk(f);
-      boost::unique_future<Ret> result = tsk.get_future();
-      
-      s.dispatch(boost::bind(&boost::packaged_task<Ret>::operator(),
-                         boost::ref(tsk)));
-      return result.get();
-    }
-
-# ifndef DOXYGEN
-
-    template<class Service>
-    void strand_run(Service &s, boost::function<void ()> const &f) {
-      boost::packaged_task<void> tsk(f);
-      boost::unique_future<void> result = tsk.get_future();
-      
-      s.dispatch(boost::bind(&boost::packaged_task<void>::operator(),
-                         boost::ref(tsk)));
-      result.get();
+      return details::sync_call<Ret>::run(s, f);
     }
     
-# endif // DOXYGEN
+    /** @brief synchronize asynchronous call
+     *
+     * @param s Executing service
+     * @param f A functor
+     *
+     * Same as the boost::function version but accept directly any 
+     * functor -- such as the result of a boost::bind -- avoiding the 
+     * cost of converting it into a boost::function.
+     *
+     * @return the value returned by @p f
+     *
+     * @throw an exception rpduced by @p f if any
+     */
+    template<class Service, class Fn>
+    typename boost::result_of<Fn ()>::type strand_run(Service &s, Fn const &f) {
+      return details::sync_call<typename boost::result_of<Fn ()>::type>::run(s, f);
+    }
     
   } // TREX::utils
 } // TREX
@@ -74,13 +74,12 @@ bool BasicSymbol<CharT, Traits, Alloc>::operator<
 (BasicSymbol<CharT, Traits, Alloc> const &other) const {
   return !other.empty() &&
     ( empty() ||( m_name!=other.m_name &&
-		  m_name.get()<other.m_name.get() ) );
+		  str()<other.str() ) );
 }
 
 template<class CharT, class Traits, class Alloc> 
 size_t BasicSymbol<CharT, Traits, Alloc>::hash() const {
-  boost::hash<str_type> href;
-  return href(m_name.get());
+  return m_name.get().hash();
 }
 
 template<class CharT, class Traits, class Alloc> 
@@ -0,0 +1,311 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file trex/utils/flat_map.hh
+ * @brief A sorted vector based map with inline storage
+ *
+ * @ingroup utils
+ */
+#ifndef H_trex_utils_flat_map
+# define H_trex_utils_flat_map
+
+# include <algorithm>
+# include <functional>
+# include <new>
+# include <utility>
+
+# include <boost/aligned_storage.hpp>
+# include <boost/type_traits/alignment_of.hpp>
+
+namespace TREX {
+  namespace utils {
+    
+    /** @brief Flat associative container
+     *
+     * @tparam Key The key type
+     * @tparam Ty The mapped type
+     * @tparam N The number of elements stored inline
+     * @tparam Cmp Key ordering functor
+     *
+     * A map implemented as a sorted array of @c std::pair<Key, Ty>. The 
+     * first @p N elements are stored within the instance itself so a 
+     * small map does not require any heap allocation and is contiguous 
+     * in memory. Beyond @p N the elements are moved to a heap array.
+     *
+     * Elements are kept sorted by key using @p Cmp. Lookup is done with a 
+     * linear scan using the key @c operator== for maps of up to 16 (or 
+     * @p N if greater) elements -- which is much cheaper than @p Cmp for 
+     * keys such as Symbol where equality is an identity check -- and a 
+     * binary search otherwise.
+     *
+     * @note As for a @c std::vector, any insertion or removal invalidates 
+     * the iterators following the modified position -- and all of them if 
+     * the storage is relocated.
+     *
+     * @ingroup utils
+     */
+    template<class Key, class Ty, size_t N, class Cmp = std::less<Key> >
+    class flat_map {
+    public:
+      typedef Key                     key_type;
+      typedef Ty                      mapped_type;
+      typedef std::pair<Key, Ty>      value_type;
+      typedef value_type             *iterator;
+      typedef value_type const       *const_iterator;
+      typedef size_t                  size_type;
+      
+      /** @brief Constructor 
+       *
+       * Create an empty map
+       */
+      flat_map() 
+        :m_data(inline_data()), m_size(0), m_capacity(N) {}
+      /** @brief Copy constructor
+       *
+       * @param[in] other Another instance
+       *
+       * Create a copy of @p other
+       */
+      flat_map(flat_map const &other)
+        :m_data(inline_data()), m_size(0), m_capacity(N) {
+        try {
+          copy(other);
+        } catch(...) {
+          clear();
+          release();
+          throw;
+        }
+      }
+      /** @brief Destructor */
+      ~flat_map() {
+        clear();
+        release();
+      }
+      
+      flat_map &operator= (flat_map const &other) {
+        if( this!=&other ) {
+          clear();
+          copy(other);
+        }
+        return *this;
+      }
+      
+      bool empty() const {
+        return 0==m_size;
+      }
+      size_type size() const {
+        return m_size;
+      }
+      
+      iterator begin() {
+        return m_data;
+      }
+      iterator end() {
+        return m_data+m_size;
+      }
+      const_iterator begin() const {
+        return m_data;
+      }
+      const_iterator end() const {
+        return m_data+m_size;
+      }
+      
+      /** @brief First element not before a key
+       *
+       * @param[in] k A key
+       *
+       * @return An iterator to the first element which key is not 
+       *   ordered before @p k
+       * @{
+       */
+      iterator lower_bound(key_type const &k) {
+        return std::lower_bound(begin(), end(), k, key_cmp());
+      }
+      const_iterator lower_bound(key_type const &k) const {
+        return std::lower_bound(begin(), end(), k, key_cmp());
+      }
+      /** @} */
+      
+      /** @brief Find an element
+       *
+       * @param[in] k A key
+       *
+       * @return An iterator to the element with key @p k or end() if 
+       *   this map has no such element
+       * @{
+       */
+      iterator find(key_type const &k) {
+        return m_data+index_of(k);
+      }
+      const_iterator find(key_type const &k) const {
+        return m_data+index_of(k);
+      }
+      /** @} */
+      
+      /** @brief Insert an element
+       *
+       * @param[in] pos A position hint
+       * @param[in] v A value
+       *
+       * Insert @p v just before @p pos
+       *
+       * @pre @p pos is the lower_bound of the key of @p v and this map 
+       *   has no element with this key
+       *
+       * @return An iterator to the newly inserted element
+       *
+       * @warning Contrary to @c std::map::insert this invalidates all 
+       * the iterators at or after @p pos, and all of them if the 
+       * storage had to grow. If the assignment of an element throws
+       * while shifting the elements after @p pos, this map may hold 
+       * a duplicate of one of them.
+       */
+      iterator insert(iterator pos, value_type const &v) {
+        size_type idx = pos-m_data;
+        value_type tmp(v); // v may be one of my elements
+        
+        if( m_size==m_capacity )
+          grow(2*m_capacity);
+        if( idx==m_size ) {
+          new(m_data+m_size) value_type(tmp);
+          ++m_size;
+        } else {
+          new(m_data+m_size) value_type(m_data[m_size-1]);
+          // count the new slot now so it is destroyed even if an 
+          // assignment below throws
+          ++m_size;
+          for(size_type i=m_size-2; i>idx; --i)
+            m_data[i] = m_data[i-1];
+          m_data[idx] = tmp;
+        }
+        return m_data+idx;
+      }
+      /** @brief Remove an element
+       *
+       * @param[in] pos An iterator
+       *
+       * Remove the element pointed by @p pos
+       *
+       * @return An iterator to the element that followed @p pos
+       *
+       * @warning This invalidates all the iterators after @p pos
+       */
+      iterator erase(iterator pos) {
+        for(iterator i=pos+1; end()!=i; ++i)
+          *(i-1) = *i;
+        --m_size;
+        m_data[m_size].~value_type();
+        return pos;
+      }
+      /** @brief Remove all the elements
+       *
+       * @post this map is empty
+       * @note This do not release the heap storage if any
+       */
+      void clear() {
+        for( ; m_size>0; --m_size)
+          m_data[m_size-1].~value_type();
+      }
+      
+    private:
+      enum { scan_limit = (N>16)?N:16 };
+      
+      typedef boost::aligned_storage<sizeof(value_type)*N, 
+                                     boost::alignment_of<value_type>::value> buffer_type;
+      
+      struct key_cmp {
+        bool operator()(value_type const &v, key_type const &k) const {
+          return Cmp()(v.first, k);
+        }
+      }; // TREX::utils::flat_map<>::key_cmp
+      
+      value_type *inline_data() {
+        return static_cast<value_type *>(m_buffer.address());
+      }
+      
+      size_type index_of(key_type const &k) const {
+        if( m_size<=scan_limit ) {
+          size_type i = 0;
+          for( ; i<m_size && !(m_data[i].first==k); ++i);
+          return i;
+        } else {
+          const_iterator i = lower_bound(k);
+          if( end()==i || Cmp()(k, i->first) )
+            return m_size;
+          return i-m_data;
+        }
+      }
+      
+      void copy(flat_map const &other) {
+        if( other.m_size>m_capacity )
+          grow(other.m_size);
+        for( ; m_size<other.m_size; ++m_size)
+          new(m_data+m_size) value_type(other.m_data[m_size]);
+      }
+      
+      void grow(size_type n) {
+        value_type *tmp = static_cast<value_type *>(::operator new(n*sizeof(value_type)));
+        size_type i = 0;
+        
+        try {
+          for( ; i<m_size; ++i)
+            new(tmp+i) value_type(m_data[i]);
+        } catch(...) {
+          for( ; i>0; --i)
+            tmp[i-1].~value_type();
+          ::operator delete(tmp);
+          throw;
+        }
+        for(i=m_size; i>0; --i)
+          m_data[i-1].~value_type();
+        release();
+        m_data = tmp;
+        m_capacity = n;
+      }
+      
+      void release() {
+        if( inline_data()!=m_data )
+          ::operator delete(m_data);
+        m_data = inline_data();
+        m_capacity = N;
+      }
+      
+      buffer_type m_buffer;
+      value_type *m_data;
+      size_type   m_size, m_capacity;
+    }; // TREX::utils::flat_map<>
+    
+  } // TREX::utils
+} // TREX
+
+#endif // H_trex_utils_flat_map
@@ -38,7 +38,9 @@
 # include <list>
 
 # include <boost/call_traits.hpp>
+# include <boost/functional/hash.hpp>
 # include <boost/tuple/tuple.hpp>
+# include <boost/unordered_map.hpp>
 
 namespace TREX {
   namespace utils {
@@ -789,6 +791,304 @@ namespace TREX {
       
     }; // TREX::utils::list_set
     
+    /** @brief Hash indexed list based set
+     *
+     * @tparam IdTraits key extraction traits
+     * @tparam Cmp      key comparaison functor
+     * @tparam Hash     key hashing functor
+     *
+     * A list_set complemented by a hash index from each key to the 
+     * position of its element in the list. This container has the same 
+     * properties as list_set -- elements are sorted using @p Cmp and an 
+     * iterator remains valid until its element is removed -- but finding 
+     * an element by its key is done in constant time instead of linear 
+     * time. 
+     *
+     * Inserting a new element still needs to find its position in the 
+     * list and remains linear. This container is therefore well suited 
+     * for sets that are mostly queried such as the timelines of a 
+     * reactor.
+     *
+     * @ingroup utils
+     * @sa list_set
+     */
+    template< class IdTraits, class Cmp=std::less<typename IdTraits::id_type>,
+              class Hash=boost::hash<typename IdTraits::id_type> >
+    class hashed_list_set {
+      typedef list_set<IdTraits, Cmp> set_type;
+      
+    public:
+      typedef typename set_type::value_type      value_type;
+      typedef typename set_type::key_type        key_type;
+      typedef typename set_type::size_type       size_type;
+      typedef typename set_type::difference_type difference_type;
+      typedef typename set_type::iterator        iterator;
+      typedef typename set_type::const_iterator  const_iterator;
+      
+    private:
+      typedef boost::unordered_map<key_type, iterator, Hash> index_type;
+      
+      set_type   m_set;   //!< sorted elements 
+      index_type m_index; //!< key to element index
+      
+      void rebuild_index() {
+        m_index.clear();
+        for(iterator i=m_set.begin(); m_set.end()!=i; ++i)
+          m_index.insert(std::make_pair(IdTraits::get_id(*i), i));
+      }
+      
+    public:
+      /** @brief Default constructor
+       *
+       * Create an empty set
+       */
+      hashed_list_set() {}
+      /** @brief copy constructor
+       *
+       * @param[in] other Another instance
+       *
+       * Create a copy of @p other
+       */
+      hashed_list_set(hashed_list_set const &other)
+      :m_set(other.m_set) {
+        rebuild_index();
+      }
+      /** @brief Constructor
+       *
+       * @tparam Iter an iterator
+       * @param from start iterator
+       * @param to   end iterator
+       *
+       * Create A setby inserting all the elements in the interval
+       * [@p from, @p to)
+       * @note If multiple elements have the same key only the first
+       * found will be insserted
+       */
+      template<class Iter>
+      hashed_list_set(Iter from, Iter to) {
+        for( ; to!=from; ++from)
+          insert(*from);
+      }
+      /** @brief Destructor */
+      ~hashed_list_set() {}
+      
+      hashed_list_set &operator= (hashed_list_set const &other) {
+        if( this!=&other ) {
+          m_set = other.m_set;
+          rebuild_index();
+        }
+        return *this;
+      }
+      
+      bool empty() const {
+        return m_set.empty();
+      }
+      size_type size() const {
+        return m_set.size();
+      }
+      
+      iterator begin() {
+        return m_set.begin();
+      }
+      iterator end() {
+        return m_set.end();
+      }
+      const_iterator begin() const {
+        return m_set.begin();
+      }
+      const_iterator end() const {
+        return m_set.end();
+      }
+      
+      /** @brief Lower bound
+       *
+       * @param[in] k A key
+       *
+       * @return An iterator refering to the first element that is not
+       *         before @p k or end() if such element does not exist
+       * @note This method is linear
+       * @sa list_set::lower_bound(key_type const &)
+       * @{
+       */
+      iterator lower_bound(key_type const &k) {
+        return m_set.lower_bound(k);
+      }
+      const_iterator lower_bound(key_type const &k) const {
+        return m_set.lower_bound(k);
+      }
+      /** @} */
+      /** @brief Upper bound
+       *
+       * @param[in] k A key
+       *
+       * @return An iterator refering to the first element that is
+       *         after @p k or end() if such element does not exist
+       * @note This method is linear
+       * @sa list_set::upper_bound(key_type const &)
+       * @{
+       */
+      iterator upper_bound(key_type const &k) {
+        return m_set.upper_bound(k);
+      }
+      const_iterator upper_bound(key_type const &k) const {
+        return m_set.upper_bound(k);
+      }
+      /** @} */
+      
+      /** @brief Equal range
+       *
+       * @param[in] k A key
+       *
+       * @return a pair defining the iterator interval of all the elements
+       * whose key is @p k
+       * @note This method is in constant time when @p k is in this set
+       * @sa list_set::equal_range(key_type const &)
+       * @{
+       */
+      std::pair<iterator, iterator> equal_range(key_type const &k) {
+        iterator pos = find(k);
+        if( end()==pos ) {
+          pos = m_set.lower_bound(k);
+          return std::make_pair(pos, pos);
+        } 
+        iterator next = pos;
+        return std::make_pair(pos, ++next);
+      }
+      std::pair<const_iterator, const_iterator> equal_range(key_type const &k) const {
+        const_iterator pos = find(k);
+        if( end()==pos ) {
+          pos = m_set.lower_bound(k);
+          return std::make_pair(pos, pos);
+        } 
+        const_iterator next = pos;
+        return std::make_pair(pos, ++next);
+      }
+      /** @} */
+      
+      /** @brief Element insertion
+       *
+       * @param[in] v An element value
+       *
+       * Insert @p v in this set if there is no element with the same key 
+       * as @p v
+       *
+       * @return A pair with the @c first element being the iterator pointing
+       * to @p v position in thins set and @c second a @c bool which is @c true
+       * if @p v was inserted and @p false if an element with the same key as @p
+       * already exist
+       * @sa list_set::insert(value_type const &)
+       */
+      std::pair<iterator, bool> insert(value_type const &v) {
+        key_type const &k = IdTraits::get_id(v);
+        typename index_type::const_iterator i = m_index.find(k);
+        
+        if( m_index.end()!=i )
+          return std::make_pair(i->second, false);
+        std::pair<iterator, bool> ret = m_set.insert(v);
+        m_index.insert(std::make_pair(k, ret.first));
+        return ret;
+      }
+      
+      /** @brief Find element
+       *
+       * @param[in] k A key
+       *
+       * @return An iterator pointing to the element whose key is @p k
+       *         or end() if such element does not exist
+       * @{
+       */
+      iterator find(key_type const &k) {
+        typename index_type::const_iterator i = m_index.find(k);
+        if( m_index.end()==i )
+          return end();
+        return i->second;
+      }
+      const_iterator find(key_type const &k) const {
+        typename index_type::const_iterator i = m_index.find(k);
+        if( m_index.end()==i )
+          return end();
+        return i->second;
+      }
+      /** @} */
+      
+      /** @brief Find element
+       *
+       * @param[in] v An element value
+       *
+       * @return An iterator pointing to the element whose key is the
+       *         same as @p v or end() if such element does not exist
+       * @{
+       */
+      iterator find(value_type const &v) {
+        return find(IdTraits::get_id(v));
+      }
+      const_iterator find(value_type const &v) const {
+        return find(IdTraits::get_id(v));
+      }
+      /** @} */
+      
+      /** @brief Remove an element
+       *
+       * @param[in] pos element to remove
+       *
+       * @pre @p pos is a valid iterator for this instance
+       *
+       * @return the iterator after @p pos
+       */
+      iterator erase(iterator pos) {
+        m_index.erase(IdTraits::get_id(*pos));
+        return m_set.erase(pos);
+      }
+      /** @brief Remove elements
+       *
+       * @param[in] from first element to remove
+       * @param[to] to   first element to not remove after @p from
+       *
+       * @pre [@p pos, @p to) is a valid iterator interval for this instance
+       *
+       * @return @p to
+       */
+      iterator erase(iterator from, iterator to) {
+        while( to!=from )
+          from = erase(from);
+        return to;
+      }
+      /** @brief Remove an element
+       *
+       * @param[in] k A key
+       *
+       * Remove the element whose key is @p k if it exist
+       *
+       * @treturn the iterator after the expected position
+       * of element with key @p k
+       */
+      iterator erase(key_type const &k) {
+        iterator from, to;
+        
+        boost::tie(from ,to) = equal_range(k);
+        return erase(from, to);
+      }
+      
+      /** @brief clear container
+       *
+       * Remove all the elements stroed in this instance
+       */
+      void clear() {
+        m_index.clear();
+        m_set.clear();
+      }
+      
+      value_type const &front() const {
+        return m_set.front();
+      }
+      value_type &front() {
+        return m_set.front();
+      }
+      void pop_front() {
+        erase(begin());
+      }
+    }; // TREX::utils::hashed_list_set
+    
     
     
   } // TREX::utils
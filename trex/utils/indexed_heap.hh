@@ -0,0 +1,277 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2011, MBARI.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @file trex/utils/indexed_heap.hh
+ * @brief A priority queue with random access to its elements
+ *
+ * @ingroup utils
+ */
+#ifndef H_trex_utils_indexed_heap
+# define H_trex_utils_indexed_heap
+
+# include <functional>
+# include <vector>
+
+# include <boost/call_traits.hpp>
+# include <boost/functional/hash.hpp>
+# include <boost/unordered_map.hpp>
+
+namespace TREX {
+  namespace utils {
+    
+    /** @brief Indexed priority queue
+     *
+     * @tparam Priority the priority type
+     * @tparam Item the type of the elements stored
+     * @tparam Cmp priority comparison functor
+     * @tparam Hash Hash functor for @p Item
+     *
+     * A binary heap which maintains an index from its elements to their 
+     * position in the heap. This allows to check if an element is in the 
+     * queue, change its priority or remove it in logarithmic time.
+     *
+     * As for @c std::priority_queue, the top of the queue is the element 
+     * with the greatest priority according to @p Cmp. Elements with 
+     * equivalent priorities are given in the order they were given this 
+     * priority.
+     *
+     * @pre Each element of the queue is unique
+     *
+     * @ingroup utils
+     */
+    template< typename Priority, typename Item, 
+              class Cmp = std::less<Priority>,
+              class Hash = boost::hash<Item> >
+    class indexed_heap {
+    public:
+      typedef Priority priority_type;
+      typedef Item     value_type;
+      typedef size_t   size_type;
+      
+      /** @brief Constructor
+       *
+       * @param[in] cmp A priority comparator
+       *
+       * Create a new empty queue
+       */
+      explicit indexed_heap(Cmp const &cmp = Cmp())
+      :m_cmp(cmp), m_stamp(0) {}
+      /** @brief Destructor */
+      ~indexed_heap() {}
+      
+      /** @brief Check if empty
+       * @retval true if this queue is empty
+       * @retval false otherwise
+       */
+      bool empty() const {
+        return m_heap.empty();
+      }
+      /** @brief Size of the queue
+       * @return the number of elements in the queue
+       */
+      size_type size() const {
+        return m_heap.size();
+      }
+      /** @brief Check for an element
+       * @param[in] x An element
+       * @retval true if @p x is in the queue
+       * @retval false otherwise
+       */
+      bool contains(typename boost::call_traits<Item>::param_type x) const {
+        return m_index.end()!=m_index.find(x);
+      }
+      
+      /** @brief Top element
+       * @pre the queue is not empty
+       * @return the element with the highest priority
+       */
+      value_type const &top() const {
+        return m_heap.front().item;
+      }
+      /** @brief Top priority
+       * @pre the queue is not empty
+       * @return the priority of top()
+       */
+      priority_type const &top_priority() const {
+        return m_heap.front().priority;
+      }
+      
+      /** @brief Insert or update an element
+       *
+       * @param[in] x An element
+       * @param[in] p A priority
+       *
+       * Insert @p x with the priority @p p in this queue. If @p x was 
+       * already in the queue its priority is changed to @p p
+       *
+       * @retval true if @p x was inserted
+       * @retval false if @p x priority was updated
+       */
+      bool push(typename boost::call_traits<Item>::param_type x, 
+                typename boost::call_traits<Priority>::param_type p) {
+        typename index_type::iterator i = m_index.find(x);
+        if( m_index.end()==i ) {
+          size_type pos = m_heap.size();
+          m_heap.push_back(entry(x, p, m_stamp++));
+          m_index[x] = pos;
+          sift_up(pos);
+          return true;
+        } else {
+          update_at(i->second, p);
+          return false;
+        }
+      }
+      /** @brief Remove top element
+       *
+       * Removes the element with the highest priority
+       *
+       * @pre the queue is not empty
+       */
+      void pop() {
+        remove_at(0);
+      }
+      /** @brief Remove an element
+       *
+       * @param[in] x An element
+       *
+       * Remove @p x from this queue
+       *
+       * @retval true if @p x was in the queue
+       * @retval false otherwise
+       */
+      bool erase(typename boost::call_traits<Item>::param_type x) {
+        typename index_type::iterator i = m_index.find(x);
+        if( m_index.end()!=i ) {
+          remove_at(i->second);
+          return true;
+        }
+        return false;
+      }
+      /** @brief Clear the queue
+       *
+       * @post the queue is empty
+       */
+      void clear() {
+        m_heap.clear();
+        m_index.clear();
+      }
+      
+    private:
+      struct entry {
+        entry(typename boost::call_traits<Item>::param_type x,
+              typename boost::call_traits<Priority>::param_type p,
+              unsigned long s)
+        :item(x), priority(p), stamp(s) {}
+        
+        Item          item;
+        Priority      priority;
+        unsigned long stamp;
+      };
+      typedef boost::unordered_map<Item, size_type, Hash> index_type;
+      
+      // Indicates if the entry at a should be closer to the top than b
+      bool before(size_type a, size_type b) const {
+        entry const &ea = m_heap[a], &eb = m_heap[b];
+        if( m_cmp(eb.priority, ea.priority) )
+          return true;
+        else if( m_cmp(ea.priority, eb.priority) )
+          return false;
+        return ea.stamp<eb.stamp;
+      }
+      
+      void swap_at(size_type a, size_type b) {
+        std::swap(m_heap[a], m_heap[b]);
+        m_index[m_heap[a].item] = a;
+        m_index[m_heap[b].item] = b;
+      }
+      
+      void sift_up(size_type pos) {
+        while( pos>0 ) {
+          size_type parent = (pos-1)/2;
+          if( !before(pos, parent) )
+            break;
+          swap_at(pos, parent);
+          pos = parent;
+        }
+      }
+      
+      void sift_down(size_type pos) {
+        size_type const n = m_heap.size();
+        
+        while( true ) {
+          size_type best = pos, child = 2*pos+1;
+          
+          if( child<n && before(child, best) )
+            best = child;
+          ++child;
+          if( child<n && before(child, best) )
+            best = child;
+          if( best==pos )
+            break;
+          swap_at(pos, best);
+          pos = best;
+        }
+      }
+      
+      void update_at(size_type pos, 
+                     typename boost::call_traits<Priority>::param_type p) {
+        m_heap[pos].priority = p;
+        m_heap[pos].stamp = m_stamp++;
+        sift_up(pos);
+        sift_down(pos);
+      }
+      
+      void remove_at(size_type pos) {
+        size_type last = m_heap.size()-1;
+        
+        m_index.erase(m_heap[pos].item);
+        if( pos!=last ) {
+          m_heap[pos] = m_heap[last];
+          m_index[m_heap[pos].item] = pos;
+          m_heap.pop_back();
+          sift_up(pos);
+          sift_down(pos);
+        } else
+          m_heap.pop_back();
+      }
+      
+      Cmp                m_cmp;
+      std::vector<entry> m_heap;
+      index_type         m_index;
+      unsigned long      m_stamp;
+    }; // TREX::utils::indexed_heap
+    
+  } // TREX::utils
+} // TREX
+
+#endif // H_trex_utils_indexed_heap
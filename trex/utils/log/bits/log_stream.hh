@@ -104,6 +104,15 @@ namespace TREX {
            */
           ~entry_sink();
           
+          /** @brief Check if functional
+           *
+           * @retval true if this instance manages an entry
+           * @retval false otherwise
+           */
+          bool valid() const {
+            return NULL!=m_entry.get();
+          }
+          
           /** @brief Add content to the entry
            *
            * @param[in] s A string 
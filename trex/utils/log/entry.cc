@@ -34,8 +34,26 @@
 #include "bits/log_stream.hh"
 #include "text_log.hh"
 
+#include <boost/thread/tss.hpp>
+
 using namespace TREX::utils::log;
 
+namespace {
+  
+  /** @brief Size of the buffer of an entry construction stream */
+  std::streamsize const entry_buffer = 256;
+  
+  /** @brief Rejected entries stream
+   *
+   * The stream returned for entries rejected by the log. As it has no 
+   * buffer it is always in a bad state and does not format anything 
+   * written into it. Each thread gets its own so producers do not share
+   * its state, and it is allocated only once per thread.
+   */
+  boost::thread_specific_ptr<std::ostream> s_null;
+  
+}
+
 // manipulators
 
 std::streamsize details::entry_sink::write(details::entry_sink::char_type const *s, 
@@ -51,12 +69,22 @@ std::streamsize details::entry_sink::write(details::entry_sink::char_type const
 // structors 
 
 stream::stream(details::entry_sink const &dest)
-:m_out(new details::stream_impl(dest)) {}
+:m_out(dest.valid()?new details::stream_impl(dest, entry_buffer):NULL) {}
 
 // manipulators 
 
 std::ostream &stream::get_stream() {
-  return *m_out;
+  if( NULL!=m_out.get() )
+    return *m_out;
+  std::ostream *ret = s_null.get();
+  
+  if( NULL==ret ) {
+    ret = new std::ostream(NULL);
+    s_null.reset(ret);
+  }
+  // manipulators may have changed its state: make sure it stays bad
+  ret->setstate(std::ios_base::badbit);
+  return *ret;
 }
 
 /*
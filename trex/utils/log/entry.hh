@@ -171,10 +171,11 @@ namespace TREX {
         typedef msg_type::size_type  size_type;
         
         entry(id_type const &src, id_type const &kind)
-        :m_source(src), m_kind(kind), m_pending_nl(false) {}
+        :m_source(src), m_kind(kind), m_pending_nl(false), m_next(NULL) {}
         
         entry(date_type const &date, id_type const &src, id_type const &kind)
-        :m_date(date), m_source(src), m_kind(kind), m_pending_nl(false) {}
+        :m_date(date), m_source(src), m_kind(kind), m_pending_nl(false),
+         m_next(NULL) {}
         
         size_type write(char_type const *s, size_type n);
         
@@ -184,8 +185,18 @@ namespace TREX {
         id_type const m_kind;
         msg_type m_content;
         bool m_pending_nl;
+        
+        /** @brief Dispatch queue self reference
+         *
+         * Keeps this entry alive while it waits in the dispatch queue
+         * of its log.
+         */
+        pointer m_queued;
+        /** @brief Next entry in the dispatch queue */
+        entry  *m_next;
                 
         friend class TREX::utils::log::details::entry_sink;
+        friend class TREX::utils::log::details::sig_impl;
         friend class log_pipe;
       }; // class TREX::utils::log::entry
             
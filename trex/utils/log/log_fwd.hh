@@ -66,6 +66,7 @@ namespace TREX {
       extern id_type const info; //!< Infromation log message
       extern id_type const warn; //!< Warning log message
       extern id_type const error; //!< Error log message
+      extern id_type const debug; //!< Debugging log message
       
       class log_pipe;
       class text_log;
@@ -80,6 +81,7 @@ namespace TREX {
       namespace details {
         
         class entry_sink;
+        class sig_impl;
         
       } // TREX::utils::log::details
     } // TREX::utils::log    
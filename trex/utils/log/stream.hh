@@ -100,7 +100,9 @@ namespace TREX {
         /** @{
          * @brief base stream access
          *
-         * utiliy methodds to access to the real stream implementation
+         * utiliy methodds to access to the real stream implementation. 
+         * If the entry was rejected by the log this stream is in a bad 
+         * state and ignores all the output.
          *
          * @return A stancdarad C++ output stream
          */
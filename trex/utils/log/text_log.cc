@@ -38,7 +38,9 @@
 
 #include "../platform/chrono.hh"
 
+#include <boost/bind.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/signals2/shared_connection_block.hpp>
 #include <boost/signals2/signal.hpp>
 
@@ -52,10 +54,26 @@ namespace TREX {
       id_type const info("INFO");
       id_type const warn("WARNING");
       id_type const error("ERROR");
+      id_type const debug("DEBUG");
       
       namespace details {
        
-        class sig_impl {
+        /** @brief Log entries dispatcher
+         *
+         * The signal used by a text_log to dispatch its entries along 
+         * with the queue of entries waiting to be dispatched.
+         *
+         * Producers push their entries in a lock-free LIFO list linked
+         * through the entries themselves. The producer that finds this 
+         * list empty posts a drain on the service which then takes the 
+         * whole list at once and signals its entries in their creation 
+         * order. Drains are serialized so the handlers are called by a 
+         * single writer at any time.
+         *
+         * @relates TREX::utils::log::text_log
+         * @ingroup utils
+         */
+        class sig_impl :public ENABLE_SHARED_FROM_THIS<sig_impl> {
         public:
           typedef slot::signature_type signature_type;
           typedef bs2::signal<signature_type, bs2::optional_last_value<void>,
@@ -63,12 +81,25 @@ namespace TREX {
                               ext_slot::slot_function_type> signal_type;
           
           
-          inline sig_impl() {}
-          inline ~sig_impl() {}
+          explicit sig_impl(boost::asio::io_service &io)
+          :m_service(io), m_head(NULL) {}
+          /** @brief Destructor
+           *
+           * Dispatches the entries still waiting in the queue, this 
+           * happens when the service was stopped before executing the 
+           * last posted drain.
+           */
+          ~sig_impl() {
+            drain();
+          }
           
-          inline void emit(entry::pointer const &e) {
-            m_signal(e);
+          void emit(entry::pointer const &e) {
+            e->m_queued = e;
+            if( push(e.get()) )
+              m_service.post(boost::bind(&sig_impl::drain, 
+                                         shared_from_this()));
           }
+          void drain();
           
           inline connection connect(slot const &s) {
             return m_signal.connect(s);
@@ -78,7 +109,16 @@ namespace TREX {
           }
           
         private:
-          signal_type m_signal;
+          bool push(entry *e);
+          entry *take();
+          
+          boost::asio::io_service &m_service;
+          entry * volatile         m_head;
+# ifndef __GNUC__
+          boost::mutex             m_lock;
+# endif
+          boost::mutex             m_drain;
+          signal_type              m_signal;
         };
         
         
@@ -89,6 +129,65 @@ namespace TREX {
 
 using namespace TREX::utils::log;
 
+/*
+ * class TREX::utils::log::details::sig_impl
+ */
+
+// manipulators
+
+bool details::sig_impl::push(entry *e) {
+# ifdef __GNUC__
+  entry *head;
+  do {
+    head = m_head;
+    e->m_next = head;
+  } while( !__sync_bool_compare_and_swap(&m_head, head, e) );
+  return NULL==head;
+# else // !__GNUC__
+  boost::mutex::scoped_lock lock(m_lock);
+  e->m_next = m_head;
+  m_head = e;
+  return NULL==e->m_next;
+# endif // __GNUC__
+}
+
+entry *details::sig_impl::take() {
+# ifdef __GNUC__
+  return __sync_lock_test_and_set(&m_head, static_cast<entry *>(NULL));
+# else // !__GNUC__
+  boost::mutex::scoped_lock lock(m_lock);
+  entry *ret = m_head;
+  m_head = NULL;
+  return ret;
+# endif // __GNUC__
+}
+
+void details::sig_impl::drain() {
+  boost::mutex::scoped_lock lock(m_drain);
+  entry *batch = NULL, *e = take();
+  
+  // restore the creation order
+  while( NULL!=e ) {
+    entry *next = e->m_next;
+    e->m_next = batch;
+    batch = e;
+    e = next;
+  }
+  while( NULL!=batch ) {
+    entry::pointer cur;
+    
+    // take back the queue reference before the entry can be released
+    cur.swap(batch->m_queued);
+    batch = batch->m_next;
+    cur->m_next = NULL;
+    try {
+      m_signal(cur);
+    } catch(...) {
+      // a failing handler should not prevent the others to get the entries
+    }
+  }
+}
+
 /*
  * class TREX::utils::log::details::entry_sink
  */
@@ -112,17 +211,25 @@ details::entry_sink::~entry_sink() {
 // structors 
 
 text_log::text_log(boost::asio::io_service &io)
-  :m_new_log(new details::sig_impl), m_service(io) {}
+  :m_new_log(new details::sig_impl(io)), m_service(io), m_verbosity(1) {}
 
 // manipulators
 
 stream text_log::msg(id_type const &who, id_type const &what) {
-  return stream(details::entry_sink(m_new_log, who, what));
+  if( accept(what) )
+    return stream(details::entry_sink(m_new_log, who, what));
+  return stream(details::entry_sink());
 }
 
 stream text_log::msg(date_type const &when, 
                      id_type const &who, id_type const &what) {
-  return stream(details::entry_sink(m_new_log, when, who, what));
+  if( accept(what) )
+    return stream(details::entry_sink(m_new_log, when, who, what));
+  return stream(details::entry_sink());
+}
+
+void text_log::flush() {
+  m_new_log->drain();
 }
 
 text_log::connection text_log::direct_connect(text_log::slot_type const &cb) {
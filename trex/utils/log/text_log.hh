@@ -68,6 +68,13 @@ namespace TREX {
        * callback cannot be executed more than once at any time -- ensuring 
        * thread safetyness.
        *
+       * Completed entries are not signaled by the thread that produced 
+       * them. Instead they are pushed in a lock-free queue which is 
+       * drained in batches by a single writer executed by the @asio 
+       * service. Therefore the cost of a message for its producer is 
+       * mostly the formatting of its content. Messages which kind is 
+       * below the verbosity level are rejected before any formatting.
+       *
        * @author Frederic Py <fpy@mbari.org>
        * @ingroup utils
        * @sa class TREX::utils::log::entry
@@ -150,6 +157,50 @@ namespace TREX {
         }
         /** @} */
         
+        /** @brief Verbosity level
+         *
+         * @return the current verbosity level
+         * @sa verbosity(unsigned)
+         */
+        unsigned verbosity() const {
+          return m_verbosity;
+        }
+        /** @brief Set verbosity level
+         *
+         * @param[in] lvl A verbosity level
+         *
+         * Set the verbosity to @p lvl which determine which messages 
+         * are accepted by this log:
+         * @li @c 0 or @c 1 all the messages except @c debug ones 
+         *     (default is @c 1)
+         * @li @c 2 or more all the messages
+         *
+         * The entries rejected are never formatted nor dispatched
+         *
+         * @sa accept(id_type const &) const
+         */
+        void verbosity(unsigned lvl) {
+          m_verbosity = lvl;
+        }
+        /** @brief Check if a message kind is accepted
+         *
+         * @param[in] kind A message kind
+         *
+         * @retval true if the messages of kind @p kind are dispatched 
+         *         with the current verbosity level
+         * @retval false otherwise
+         */
+        bool accept(id_type const &kind) const {
+          return debug!=kind || m_verbosity>1;
+        }
+        
+        /** @brief Flush pending entries
+         *
+         * Dispatch synchronously all the entries that are still 
+         * waiting in the queue.
+         */
+        void flush();
+        
         boost::asio::io_service &service() {
           return m_service;
         }
@@ -218,6 +269,7 @@ namespace TREX {
       private:
         SHARED_PTR<details::sig_impl> m_new_log;
         boost::asio::io_service    &m_service;
+        unsigned                    m_verbosity;
        
 # ifndef DOXYGEN
         text_log() DELETED; // Non default constructible
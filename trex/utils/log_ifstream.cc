@@ -0,0 +1,316 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ * 
+ *  Copyright (c) 2013, MBARI.
+ *  All rights reserved.
+ * 
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ * 
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ * 
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "log_ifstream.hh"
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef TREX_HAS_ZLIB
+# include <zlib.h>
+#endif // TREX_HAS_ZLIB
+
+namespace TREX {
+  namespace utils {
+    
+    /** @brief gzip decompression state of a log_filebuf */
+    class log_filebuf::inflater :boost::noncopyable {
+    public:
+#ifdef TREX_HAS_ZLIB
+      inflater():m_in(65536) {
+        m_zip.zalloc = Z_NULL;
+        m_zip.zfree = Z_NULL;
+        m_zip.opaque = Z_NULL;
+        m_zip.next_in = Z_NULL;
+        m_zip.avail_in = 0;
+        // 15+32 window bits accepts both gzip and zlib headers
+        m_ok = Z_OK==inflateInit2(&m_zip, 15+32);
+      }
+      ~inflater() {
+        if( m_ok )
+          inflateEnd(&m_zip);
+      }
+      
+      void reset() {
+        m_zip.next_in = Z_NULL;
+        m_zip.avail_in = 0;
+        if( m_ok )
+          inflateReset(&m_zip);
+      }
+      
+      std::streamsize read(int fd, char *s, std::streamsize n) {
+        if( !m_ok )
+          return 0;
+        m_zip.next_out = reinterpret_cast<Bytef *>(s);
+        m_zip.avail_out = n;
+        while( m_zip.avail_out==static_cast<uInt>(n) ) {
+          if( 0==m_zip.avail_in ) {
+            ssize_t len = ::read(fd, &m_in[0], m_in.size());
+            if( len<0 && EINTR==errno )
+              continue;
+            if( len<=0 )
+              break; // end of this part: it may not be complete
+            m_zip.next_in = reinterpret_cast<Bytef *>(&m_in[0]);
+            m_zip.avail_in = len;
+          }
+          int ret = inflate(&m_zip, Z_NO_FLUSH);
+          if( Z_STREAM_END==ret )
+            inflateReset(&m_zip); // more gzip members may follow
+          else if( Z_OK!=ret && Z_BUF_ERROR!=ret )
+            break; // corrupted data: give up on this part
+        }
+        return n-m_zip.avail_out;
+      }
+      
+    private:
+      z_stream          m_zip;
+      bool              m_ok;
+      std::vector<Bytef> m_in;
+#else
+      void reset() {}
+      std::streamsize read(int, char *, std::streamsize) {
+        return 0;
+      }
+#endif // TREX_HAS_ZLIB
+    };
+    
+  }
+}
+
+using namespace TREX::utils;
+namespace fs=boost::filesystem;
+
+namespace {
+  std::string const gz_ext(".gz");
+  /** @brief Size of the decoded data buffer */
+  size_t const buf_size = 65536;
+}
+
+std::string TREX::utils::log_part(std::string const &base, size_t n,
+                                  bool compressed) {
+  std::string ret(base);
+  if( n>0 )
+    ret += "."+boost::lexical_cast<std::string>(n);
+  if( compressed )
+    ret += gz_ext;
+  return ret;
+}
+
+/*
+ * class TREX::utils::log_filebuf
+ */
+
+// structors
+
+log_filebuf::log_filebuf()
+:m_compressed(false), m_cur(0), m_fd(-1), m_pos(0) {}
+
+log_filebuf::~log_filebuf() {
+  close();
+}
+
+// modifiers
+
+bool log_filebuf::open(std::string const &name) {
+  std::string base(name);
+  boost::system::error_code ec;
+  
+  close();
+  if( fs::is_regular_file(name, ec) ) {
+    m_compressed = name.length()>gz_ext.length() &&
+      0==name.compare(name.length()-gz_ext.length(), gz_ext.length(), gz_ext);
+    if( m_compressed )
+      base.erase(name.length()-gz_ext.length());
+  } else if( fs::is_regular_file(name+gz_ext, ec) )
+    m_compressed = true;
+  else
+    return false;
+#ifndef TREX_HAS_ZLIB
+  if( m_compressed )
+    return false;
+#endif // TREX_HAS_ZLIB
+  
+  for(size_t n=0; ; ++n) {
+    std::string part = log_part(base, n, m_compressed);
+    if( !fs::is_regular_file(part, ec) )
+      break;
+    m_parts.push_back(part);
+    m_sizes.push_back(fs::file_size(part, ec));
+  }
+  if( m_compressed )
+    m_zip.reset(new inflater);
+  m_data.resize(buf_size);
+  if( open_part(0) )
+    return true;
+  close();
+  return false;
+}
+
+void log_filebuf::close() {
+  close_part();
+  m_parts.clear();
+  m_sizes.clear();
+  m_zip.reset();
+  m_compressed = false;
+  m_pos = 0;
+  setg(NULL, NULL, NULL);
+}
+
+bool log_filebuf::open_part(size_t n) {
+  close_part();
+  m_cur = n;
+  if( n<m_parts.size() ) {
+    m_fd = ::open(m_parts[n].c_str(), O_RDONLY);
+    if( NULL!=m_zip.get() )
+      m_zip->reset();
+  }
+  return m_fd>=0;
+}
+
+void log_filebuf::close_part() {
+  if( m_fd>=0 )
+    ::close(m_fd);
+  m_fd = -1;
+}
+
+// observers
+
+std::streamoff log_filebuf::disk_size() const {
+  std::streamoff ret = 0;
+  for(std::vector<std::streamoff>::const_iterator i=m_sizes.begin();
+      m_sizes.end()!=i; ++i)
+    ret += *i;
+  return ret;
+}
+
+// streambuf interface
+
+std::streamsize log_filebuf::read_part(char *s, std::streamsize n) {
+  if( NULL!=m_zip.get() )
+    return m_zip->read(m_fd, s, n);
+  while( true ) {
+    ssize_t ret = ::read(m_fd, s, n);
+    if( ret>=0 || EINTR!=errno )
+      return std::max(ret, ssize_t(0));
+  }
+}
+
+bool log_filebuf::refill() {
+  m_pos += egptr()-eback();
+  setg(NULL, NULL, NULL);
+  while( m_fd>=0 ) {
+    std::streamsize len = read_part(&m_data[0], m_data.size());
+    if( len>0 ) {
+      setg(&m_data[0], &m_data[0], &m_data[0]+len);
+      return true;
+    }
+    open_part(m_cur+1);
+  }
+  return false;
+}
+
+log_filebuf::int_type log_filebuf::underflow() {
+  if( gptr()<egptr() || refill() )
+    return traits_type::to_int_type(*gptr());
+  return traits_type::eof();
+}
+
+log_filebuf::pos_type log_filebuf::seekoff(off_type off,
+                                           std::ios_base::seekdir dir,
+                                           std::ios_base::openmode which) {
+  switch( dir ) {
+    case std::ios_base::beg:
+      break;
+    case std::ios_base::cur:
+      off += position();
+      break;
+    default:
+      // the end is only known for uncompressed logs
+      if( m_compressed || !is_open() )
+        return pos_type(off_type(-1));
+      off += disk_size();
+  }
+  return seekpos(pos_type(off), which);
+}
+
+log_filebuf::pos_type log_filebuf::seekpos(pos_type pos,
+                                           std::ios_base::openmode which) {
+  std::streamoff const target(pos);
+  
+  if( !( is_open() && (which&std::ios_base::in) ) || target<0 )
+    return pos_type(off_type(-1));
+  if( m_pos<=target && target<=m_pos+(egptr()-eback()) ) {
+    // still in the get area
+    setg(eback(), eback()+(target-m_pos), egptr());
+    return pos;
+  }
+  if( m_compressed ) {
+    if( target<m_pos ) {
+      // restart from the beginning
+      open_part(0);
+      m_pos = 0;
+      setg(NULL, NULL, NULL);
+    }
+    // decompress forward until target is reached
+    while( m_pos+(egptr()-eback())<target )
+      if( !refill() )
+        return pos_type(off_type(-1));
+    setg(eback(), eback()+(target-m_pos), egptr());
+    return pos;
+  } else {
+    // locate the part that contains target
+    std::streamoff base = 0;
+    size_t n = 0;
+    for( ; n<m_sizes.size() && base+m_sizes[n]<=target; ++n)
+      base += m_sizes[n];
+    if( n==m_sizes.size() ) {
+      if( target>base )
+        return pos_type(off_type(-1));
+      // the very end of the last part
+      --n;
+      base -= m_sizes[n];
+    }
+    if( !open_part(n) ||
+        ::lseek(m_fd, target-base, SEEK_SET)<0 )
+      return pos_type(off_type(-1));
+    m_pos = target;
+    setg(NULL, NULL, NULL);
+    return pos;
+  }
+}
@@ -0,0 +1,195 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ * 
+ *  Copyright (c) 2013, MBARI.
+ *  All rights reserved.
+ * 
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ * 
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the TREX Project nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ * 
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef H_trex_utils_log_ifstream
+# define H_trex_utils_log_ifstream
+
+# include "platform/memory.hh"
+
+# include <boost/noncopyable.hpp>
+
+# include <istream>
+# include <streambuf>
+# include <string>
+# include <vector>
+
+namespace TREX {
+  namespace utils {
+    
+    /** @brief Name of a log file part
+     *
+     * @param[in] base The name of the log file
+     * @param[in] n The index of the part
+     * @param[in] compressed Compression flag
+     *
+     * Give the name of the @p n th part of the log @p base as produced by 
+     * async_ofstream when rotating its output. The first part (@p n is 0) 
+     * is @p base while the following ones are @c base.n. A @c .gz 
+     * extension is added when @p compressed is @c true
+     *
+     * @return the file name of this part
+     *
+     * @ingroup utils
+     * @sa async_ofstream::storage_policy
+     */
+    std::string log_part(std::string const &base, size_t n, bool compressed);
+    
+    /** @brief Log file input buffer
+     *
+     * A stream buffer that reads a log produced by async_ofstream 
+     * regardless of its storage_policy. The file can be gzip compressed 
+     * and/or split into multiple parts; the buffer presents them as a 
+     * single continuous stream.
+     *
+     * Positions are offsets in this stream. Seeking is efficient for
+     * uncompressed files while compressed ones can only be read 
+     * forward: seeking back restarts the decompression from the 
+     * beginning of the log.
+     *
+     * @ingroup utils
+     * @sa async_ofstream
+     */
+    class log_filebuf :public std::streambuf, boost::noncopyable {
+    public:
+      log_filebuf();
+      ~log_filebuf();
+      
+      /** @brief Open a log
+       *
+       * @param[in] name The name of the log
+       *
+       * Open the log @p name. If @p name does not exist but @c name.gz 
+       * does, the latter is opened. All the parts following it are then 
+       * identified.
+       *
+       * @retval true if the log was found and opened
+       * @retval false otherwise
+       */
+      bool open(std::string const &name);
+      void close();
+      bool is_open() const {
+        return !m_parts.empty();
+      }
+      /** @brief Check for compression
+       * @retval true if the log opened is gzip compressed
+       * @retval false otherwise
+       */
+      bool compressed() const {
+        return m_compressed;
+      }
+      /** @brief Check if the log is seekable
+       *
+       * @retval true if seeking in this log is efficient
+       * @retval false if the log can only be read forward
+       */
+      bool seekable() const {
+        return is_open() && !m_compressed;
+      }
+      /** @brief Log size on disk
+       *
+       * @return The number of bytes used by all the parts of the log on 
+       * disk. This is the size of the log only when it is not compressed
+       */
+      std::streamoff disk_size() const;
+      
+    protected:
+      int_type underflow();
+      pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                       std::ios_base::openmode which);
+      pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+      
+    private:
+      class inflater;
+      
+      bool open_part(size_t n);
+      void close_part();
+      bool refill();
+      std::streamsize read_part(char *s, std::streamsize n);
+      std::streamoff position() const {
+        return m_pos+(gptr()-eback());
+      }
+      
+      std::vector<std::string>    m_parts;
+      std::vector<std::streamoff> m_sizes;
+      bool                        m_compressed;
+      
+      size_t         m_cur;
+      int            m_fd;
+      /** @brief Stream offset of the current get area */
+      std::streamoff m_pos;
+      std::vector<char> m_data;
+      UNIQ_PTR<inflater> m_zip;
+    }; // TREX::utils::log_filebuf
+    
+    /** @brief Log file input stream
+     *
+     * An input stream that reads a log through a log_filebuf
+     *
+     * @ingroup utils
+     * @sa log_filebuf
+     */
+    class log_ifstream :public std::istream {
+    public:
+      log_ifstream():std::istream(NULL) {
+        init(&m_buf);
+      }
+      explicit log_ifstream(std::string const &name):std::istream(NULL) {
+        init(&m_buf);
+        open(name);
+      }
+      ~log_ifstream() {}
+      
+      void open(std::string const &name) {
+        if( m_buf.open(name) )
+          clear();
+        else
+          setstate(std::ios_base::failbit);
+      }
+      void close() {
+        m_buf.close();
+      }
+      bool is_open() const {
+        return m_buf.is_open();
+      }
+      log_filebuf *rdbuf() const {
+        return const_cast<log_filebuf *>(&m_buf);
+      }
+      
+    private:
+      log_filebuf m_buf;
+    }; // TREX::utils::log_ifstream
+    
+  } // TREX::utils
+} // TREX
+
+#endif // H_trex_utils_log_ifstream